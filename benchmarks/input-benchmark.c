@@ -0,0 +1,203 @@
+/* input-benchmark.c
+ *
+ * Copyright 2019 Ryan Gonzalez <rymg19@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "auricle-utils.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <glib/gstdio.h>
+#include <gst/gst.h>
+#include <unistd.h>
+
+/* Reads a set of inputs at once from a cold page cache, comparing a plain filesrc against the
+   renderer's input source at different numbers of concurrent jobs. The inputs are only read, not
+   decoded, so this measures the I/O pattern alone. Point --directory at a spinning disk or a
+   network share to see the difference; on an SSD, the two are usually close. */
+
+#define DEFAULT_INPUT_MEGABYTES 64
+#define WRITE_BLOCK_SIZE (1024 * 1024)
+
+static const guint concurrency_levels[] = { 1, 4, 16 };
+
+static int input_megabytes = DEFAULT_INPUT_MEGABYTES;
+static char *directory = NULL;
+
+static GOptionEntry option_entries[] = {
+  { "size", 's', 0, G_OPTION_ARG_INT, &input_megabytes, "The size of each input in MiB", "MIB" },
+  { "directory", 'd', 0, G_OPTION_ARG_FILENAME, &directory,
+    "Where to create the inputs, instead of the temporary directory", "PATH" },
+  { NULL },
+};
+
+// Random data, so nothing along the way can get away with compressing it.
+static gboolean
+write_input (const char  *path,
+             GError     **error)
+{
+  int fd = g_open (path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd == -1)
+    {
+      int saved_errno = errno;
+      g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (saved_errno), "Failed to create %s: %s",
+                   path, g_strerror (saved_errno));
+      return FALSE;
+    }
+
+  g_autofree guint32 *block = g_malloc (WRITE_BLOCK_SIZE);
+  for (int i = 0; i < input_megabytes; i++)
+    {
+      for (gsize j = 0; j < WRITE_BLOCK_SIZE / sizeof (guint32); j++)
+        block[j] = g_random_int ();
+
+      if (write (fd, block, WRITE_BLOCK_SIZE) != WRITE_BLOCK_SIZE)
+        {
+          int saved_errno = errno;
+          g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (saved_errno), "Failed to write %s: %s",
+                       path, g_strerror (saved_errno));
+          g_close (fd, NULL);
+          return FALSE;
+        }
+    }
+
+  // Dirty pages can't be dropped, so they have to be written out first.
+  fsync (fd);
+  return g_close (fd, error);
+}
+
+static void
+drop_from_page_cache (const char *path)
+{
+  int fd = g_open (path, O_RDONLY | O_CLOEXEC, 0);
+  if (fd == -1)
+    return;
+
+  posix_fadvise (fd, 0, 0, POSIX_FADV_DONTNEED);
+  g_close (fd, NULL);
+}
+
+/* Reads the first n_inputs inputs through their own sources in one pipeline, returning the combined
+   throughput in MiB/s. */
+static gboolean
+measure_reads (GPtrArray  *paths,
+               guint       n_inputs,
+               gboolean    use_file_source,
+               double     *throughput,
+               GError    **error)
+{
+  g_autoptr(GstElement) pipeline = gst_pipeline_new ("benchmark-pipeline");
+
+  for (guint i = 0; i < n_inputs; i++)
+    {
+      const char *path = g_ptr_array_index (paths, i);
+      drop_from_page_cache (path);
+
+      GstElement *src;
+      if (use_file_source)
+        src = auricle_file_source_new (path);
+      else
+        {
+          src = gst_element_factory_make ("filesrc", NULL);
+          g_object_set (src, "location", path, NULL);
+        }
+
+      GstElement *sink = gst_element_factory_make ("fakesink", NULL);
+      g_object_set (sink, "sync", FALSE, NULL);
+
+      gst_bin_add_many (GST_BIN (pipeline), src, sink, NULL);
+      gst_element_link (src, sink);
+    }
+
+  g_autoptr(GstBus) bus = gst_element_get_bus (pipeline);
+  gint64 start_time = g_get_monotonic_time ();
+
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  g_autoptr(GstMessage) message = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+                                                              GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  double elapsed = (g_get_monotonic_time () - start_time) / (double) G_USEC_PER_SEC;
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+
+  if (GST_MESSAGE_TYPE (message) == GST_MESSAGE_ERROR)
+    {
+      gst_message_parse_error (message, error, NULL);
+      return FALSE;
+    }
+
+  *throughput = (double) n_inputs * input_megabytes / MAX (elapsed, 0.001);
+  return TRUE;
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+  g_autoptr(GError) error = NULL;
+
+  g_autoptr(GOptionContext) context = g_option_context_new ("- benchmark reading inputs from a cold cache");
+  g_option_context_add_main_entries (context, option_entries, NULL);
+  g_option_context_add_group (context, gst_init_get_option_group ());
+  if (!g_option_context_parse (context, &argc, &argv, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      return 1;
+    }
+
+  if (input_megabytes <= 0)
+    {
+      g_printerr ("The input size must be positive\n");
+      return 1;
+    }
+
+  g_autofree char *template = g_build_filename (directory != NULL ? directory : g_get_tmp_dir (),
+                                                "auricle-input-benchmark-XXXXXX", NULL);
+  if (g_mkdtemp (template) == NULL)
+    {
+      g_printerr ("Failed to create %s: %s\n", template, g_strerror (errno));
+      return 1;
+    }
+
+  guint max_inputs = concurrency_levels[G_N_ELEMENTS (concurrency_levels) - 1];
+  g_autoptr(GPtrArray) paths = g_ptr_array_new_with_free_func (g_free);
+  gboolean success = TRUE;
+
+  for (guint i = 0; i < max_inputs && success; i++)
+    {
+      char *path = g_strdup_printf ("%s/input-%u", template, i);
+      g_ptr_array_add (paths, path);
+      success = write_input (path, &error);
+    }
+
+  for (guint i = 0; i < G_N_ELEMENTS (concurrency_levels) && success; i++)
+    {
+      double plain_throughput, file_source_throughput;
+      success = measure_reads (paths, concurrency_levels[i], FALSE, &plain_throughput, &error) &&
+                measure_reads (paths, concurrency_levels[i], TRUE, &file_source_throughput, &error);
+      if (success)
+        g_print ("%2u inputs: filesrc %.1f MiB/s, auricle_file_source_new %.1f MiB/s\n", concurrency_levels[i],
+                 plain_throughput, file_source_throughput);
+    }
+
+  if (!success)
+    g_printerr ("%s\n", error->message);
+
+  for (guint i = 0; i < paths->len; i++)
+    g_unlink (g_ptr_array_index (paths, i));
+  g_rmdir (template);
+
+  return success ? 0 : 1;
+}
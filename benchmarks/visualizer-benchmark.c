@@ -0,0 +1,177 @@
+/* visualizer-benchmark.c
+ *
+ * Copyright 2019 Ryan Gonzalez <rymg19@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "auricle-codecs.h"
+#include "auricle-visualizer.h"
+#include <gst/gst.h>
+
+/* Renders a reference clip through each visualizer mode with the default video encoder, the same way
+   a render job does, and fails if any of them runs slower than the target realtime factor. */
+
+#define REFERENCE_CLIP_SECONDS 60
+#define REFERENCE_SAMPLE_RATE 44100
+#define REFERENCE_SAMPLES_PER_BUFFER 1024
+#define REFERENCE_IMAGE_WIDTH 1280
+#define REFERENCE_IMAGE_HEIGHT 720
+
+// Batch renders run several jobs at once, so a single one has to be well above realtime.
+#define DEFAULT_TARGET_REALTIME_FACTOR 10.0
+
+static const char *scope_names[] = { "wavescope", "spectrascope", NULL };
+
+static double target_realtime_factor = DEFAULT_TARGET_REALTIME_FACTOR;
+static char *image_path = NULL;
+
+static GOptionEntry option_entries[] = {
+  { "target", 't', 0, G_OPTION_ARG_DOUBLE, &target_realtime_factor,
+    "The slowest acceptable realtime factor", "FACTOR" },
+  { "image", 'i', 0, G_OPTION_ARG_FILENAME, &image_path,
+    "The image to draw over, instead of a generated one", "PATH" },
+  { NULL },
+};
+
+static GdkPixbuf *
+create_reference_image (void)
+{
+  GdkPixbuf *pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, FALSE, 8, REFERENCE_IMAGE_WIDTH,
+                                      REFERENCE_IMAGE_HEIGHT);
+  guint8 *pixels = gdk_pixbuf_get_pixels (pixbuf);
+  int rowstride = gdk_pixbuf_get_rowstride (pixbuf);
+
+  for (int y = 0; y < REFERENCE_IMAGE_HEIGHT; y++)
+    {
+      guint8 *row = pixels + y * rowstride;
+      for (int x = 0; x < REFERENCE_IMAGE_WIDTH; x++)
+        {
+          row[x * 3] = x * 255 / REFERENCE_IMAGE_WIDTH;
+          row[x * 3 + 1] = y * 255 / REFERENCE_IMAGE_HEIGHT;
+          row[x * 3 + 2] = ((x / 16) ^ (y / 16)) & 1 ? 0xc0 : 0x40;
+        }
+    }
+
+  return pixbuf;
+}
+
+static gboolean
+measure_scope (GdkPixbuf           *image,
+               const char          *scope_name,
+               const AuricleCodec  *video_codec,
+               double              *realtime_factor,
+               GError             **error)
+{
+  g_autoptr(GstElement) pipeline = gst_pipeline_new ("benchmark-pipeline");
+
+  GstElement *visualizer = auricle_visualizer_new (image, scope_name, video_codec, NULL, error);
+  if (visualizer == NULL)
+    return FALSE;
+
+  GstElement *src = gst_element_factory_make ("audiotestsrc", NULL);
+  GstElement *filter = gst_element_factory_make ("capsfilter", NULL);
+  GstElement *sink = gst_element_factory_make ("fakesink", NULL);
+
+  gst_util_set_object_arg (G_OBJECT (src), "wave", "pink-noise");
+  g_object_set (src, "samplesperbuffer", REFERENCE_SAMPLES_PER_BUFFER,
+                     "num-buffers", REFERENCE_CLIP_SECONDS * REFERENCE_SAMPLE_RATE /
+                                      REFERENCE_SAMPLES_PER_BUFFER, NULL);
+
+  g_autoptr(GstCaps) caps = gst_caps_new_simple ("audio/x-raw",
+                                                 "rate", G_TYPE_INT, REFERENCE_SAMPLE_RATE,
+                                                 "channels", G_TYPE_INT, 2, NULL);
+  g_object_set (filter, "caps", caps, NULL);
+  g_object_set (sink, "sync", FALSE, NULL);
+
+  gst_bin_add_many (GST_BIN (pipeline), src, filter, visualizer, sink, NULL);
+  gst_element_link_many (src, filter, visualizer, sink, NULL);
+
+  g_autoptr(GstBus) bus = gst_element_get_bus (pipeline);
+  gint64 start_time = g_get_monotonic_time ();
+
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  g_autoptr(GstMessage) message = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+                                                              GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  double elapsed = (g_get_monotonic_time () - start_time) / (double) G_USEC_PER_SEC;
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+
+  if (GST_MESSAGE_TYPE (message) == GST_MESSAGE_ERROR)
+    {
+      gst_message_parse_error (message, error, NULL);
+      return FALSE;
+    }
+
+  *realtime_factor = REFERENCE_CLIP_SECONDS / MAX (elapsed, 0.001);
+  return TRUE;
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+  g_autoptr(GError) error = NULL;
+
+  g_autoptr(GOptionContext) context = g_option_context_new ("- benchmark the visualizer render modes");
+  g_option_context_add_main_entries (context, option_entries, NULL);
+  g_option_context_add_group (context, gst_init_get_option_group ());
+  if (!g_option_context_parse (context, &argc, &argv, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      return 1;
+    }
+
+  auricle_codecs_probe ();
+
+  // The same encoders a render uses by default.
+  const AuricleCodec *muxer_codec, *video_codec, *audio_codec;
+  if (!auricle_codecs_resolve ("mp4", "x264", "fdkaac", &muxer_codec, &video_codec, &audio_codec, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      return 1;
+    }
+
+  g_autoptr(GdkPixbuf) image = NULL;
+  if (image_path != NULL)
+    image = gdk_pixbuf_new_from_file (image_path, &error);
+  else
+    image = create_reference_image ();
+
+  if (image == NULL)
+    {
+      g_printerr ("Failed to load %s: %s\n", image_path, error->message);
+      return 1;
+    }
+
+  gboolean passed = TRUE;
+
+  for (const char **scope_name = scope_names; *scope_name != NULL; scope_name++)
+    {
+      double realtime_factor;
+      if (!measure_scope (image, *scope_name, video_codec, &realtime_factor, &error))
+        {
+          g_printerr ("%s: %s\n", *scope_name, error->message);
+          return 1;
+        }
+
+      gboolean fast_enough = realtime_factor >= target_realtime_factor;
+      g_print ("%s (%s): %.1fx realtime, target %.1fx: %s\n", *scope_name, video_codec->name, realtime_factor,
+               target_realtime_factor, fast_enough ? "ok" : "FAILED");
+      passed = passed && fast_enough;
+    }
+
+  return passed ? 0 : 1;
+}
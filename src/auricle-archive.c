@@ -0,0 +1,326 @@
+/* auricle-archive.c
+ *
+ * Copyright 2019 Ryan Gonzalez <rymg19@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "auricle-config.h"
+#include "auricle-archive.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <glib/gstdio.h>
+#include <string.h>
+
+#ifdef HAVE_LIBARCHIVE
+#include <archive.h>
+#include <archive_entry.h>
+#endif
+
+/* Tracks inside an archive are given paths as if the archive were a directory, e.g.
+   /music/delivery.zip/disc1/01.flac, so they show up and get named like any other file. Their audio
+   is then read straight out of the archive as it's decoded, without extracting it first. Since a
+   member can only be read from its start, they can't be seeked in.
+
+   Every scan and render of a member opens the archive again and finds the member from its headers,
+   so this is limited to formats where the members in front can be skipped without reading them:
+   zip, where each is compressed on its own, and plain tar. Compressed tars and solid 7z archives
+   would have to be decompressed up to each member every time. */
+
+// The size of the reads from the archive itself.
+#define ARCHIVE_READ_BLOCK_SIZE (1024 * 1024)
+
+static const char *archive_suffixes[] = {
+  ".zip", ".tar", NULL
+};
+
+// Archives that are compressed as a whole, which are turned down.
+static const char *compressed_archive_suffixes[] = {
+  ".7z", ".tar.gz", ".tgz", ".tar.bz2", ".tbz2", ".tar.xz", ".txz", ".tar.zst", NULL
+};
+
+static gboolean
+has_suffix_in (const char  *path,
+               const char **suffixes)
+{
+  g_autofree char *lower = g_ascii_strdown (path, -1);
+  for (const char **suffix = suffixes; *suffix != NULL; suffix++)
+    if (g_str_has_suffix (lower, *suffix))
+      return TRUE;
+
+  return FALSE;
+}
+
+/* Returns whether the path is named like an archive, including ones tracks can't be read from. */
+gboolean
+auricle_archive_has_archive_name (const char *path)
+{
+  return has_suffix_in (path, archive_suffixes) || has_suffix_in (path, compressed_archive_suffixes);
+}
+
+/* Splits the path of an archive member into the archive's path and the member's name within it.
+   Returns FALSE for anything else, including files that actually exist at the path. */
+gboolean
+auricle_archive_split_path (const char  *path,
+                            char       **archive_path,
+                            char       **member)
+{
+  if (g_file_test (path, G_FILE_TEST_EXISTS))
+    return FALSE;
+
+  for (const char *sep = strchr (path + 1, '/'); sep != NULL; sep = strchr (sep + 1, '/'))
+    {
+      g_autofree char *prefix = g_strndup (path, sep - path);
+      if (g_file_test (prefix, G_FILE_TEST_IS_REGULAR))
+        {
+          if (!has_suffix_in (prefix, archive_suffixes))
+            return FALSE;
+
+          *archive_path = g_steal_pointer (&prefix);
+          *member = g_strdup (sep + 1);
+          return TRUE;
+        }
+      else if (!g_file_test (prefix, G_FILE_TEST_IS_DIR))
+        {
+          return FALSE;
+        }
+    }
+
+  return FALSE;
+}
+
+#ifdef HAVE_LIBARCHIVE
+
+#define AURICLE_TYPE_ARCHIVE_STREAM (auricle_archive_stream_get_type())
+
+G_DECLARE_FINAL_TYPE (AuricleArchiveStream, auricle_archive_stream, AURICLE, ARCHIVE_STREAM, GInputStream)
+
+/* Reads one member of an archive, which libarchive decompresses as it goes. */
+struct _AuricleArchiveStream
+{
+  GInputStream parent_instance;
+
+  struct archive *archive;
+  int             fd;
+};
+
+G_DEFINE_TYPE (AuricleArchiveStream, auricle_archive_stream, G_TYPE_INPUT_STREAM)
+
+static gssize
+auricle_archive_stream_read (GInputStream  *stream,
+                             void          *buffer,
+                             gsize          count,
+                             GCancellable  *cancellable,
+                             GError       **error)
+{
+  AuricleArchiveStream *self = AURICLE_ARCHIVE_STREAM (stream);
+
+  if (g_cancellable_set_error_if_cancelled (cancellable, error))
+    return -1;
+
+  la_ssize_t n_read = archive_read_data (self->archive, buffer, count);
+  if (n_read < 0)
+    {
+      g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED, "%s", archive_error_string (self->archive));
+      return -1;
+    }
+
+  return n_read;
+}
+
+static gboolean
+auricle_archive_stream_close (GInputStream  *stream,
+                              GCancellable  *cancellable,
+                              GError       **error)
+{
+  AuricleArchiveStream *self = AURICLE_ARCHIVE_STREAM (stream);
+
+  g_clear_pointer (&self->archive, archive_read_free);
+  if (self->fd != -1)
+    g_close (self->fd, NULL);
+  self->fd = -1;
+  return TRUE;
+}
+
+static void
+auricle_archive_stream_finalize (GObject *object)
+{
+  AuricleArchiveStream *self = (AuricleArchiveStream *)object;
+
+  // Streams that were never closed still hold on to the archive.
+  g_clear_pointer (&self->archive, archive_read_free);
+  if (self->fd != -1)
+    g_close (self->fd, NULL);
+
+  G_OBJECT_CLASS (auricle_archive_stream_parent_class)->finalize (object);
+}
+
+static void
+auricle_archive_stream_class_init (AuricleArchiveStreamClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  GInputStreamClass *stream_class = G_INPUT_STREAM_CLASS (klass);
+
+  object_class->finalize = auricle_archive_stream_finalize;
+
+  stream_class->read_fn = auricle_archive_stream_read;
+  stream_class->close_fn = auricle_archive_stream_close;
+}
+
+static void
+auricle_archive_stream_init (AuricleArchiveStream *self)
+{
+  self->fd = -1;
+}
+
+/* Opens the archive for reading from the start. The descriptor is opened here rather than by
+   libarchive, so the kernel can be told it's read sequentially. */
+static struct archive *
+open_archive (const char  *archive_path,
+              int         *fd,
+              GError     **error)
+{
+  *fd = g_open (archive_path, O_RDONLY | O_CLOEXEC, 0);
+  if (*fd == -1)
+    {
+      int saved_errno = errno;
+      g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (saved_errno), "Failed to open %s: %s",
+                   archive_path, g_strerror (saved_errno));
+      return NULL;
+    }
+
+  posix_fadvise (*fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+  // Without any filters, only archives whose members can be skipped over are opened.
+  struct archive *archive = archive_read_new ();
+  archive_read_support_format_zip (archive);
+  archive_read_support_format_tar (archive);
+  if (archive_read_open_fd (archive, *fd, ARCHIVE_READ_BLOCK_SIZE) != ARCHIVE_OK)
+    {
+      g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA, "Failed to read %s: %s", archive_path,
+                   archive_error_string (archive));
+      archive_read_free (archive);
+      g_close (*fd, NULL);
+      *fd = -1;
+      return NULL;
+    }
+
+  return archive;
+}
+
+static gboolean
+is_audio_name (const char *name)
+{
+  g_autofree char *content_type = g_content_type_guess (name, NULL, 0, NULL);
+  g_autofree char *mime_type = g_content_type_get_mime_type (content_type);
+  return mime_type != NULL && g_str_has_prefix (mime_type, "audio/");
+}
+
+/* Returns the paths of the audio files in the archive, in the order they're stored. */
+GPtrArray *
+auricle_archive_list (const char  *archive_path,
+                      GError     **error)
+{
+  if (!has_suffix_in (archive_path, archive_suffixes))
+    {
+      g_set_error (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+                   "Tracks can only be read from zip and uncompressed tar archives, so this one needs to be "
+                   "extracted first");
+      return NULL;
+    }
+
+  int fd;
+  struct archive *archive = open_archive (archive_path, &fd, error);
+  if (archive == NULL)
+    return NULL;
+
+  g_autoptr(GPtrArray) paths = g_ptr_array_new_with_free_func (g_free);
+  struct archive_entry *entry;
+  int ret;
+
+  // Only the headers are read, skipping over the contents.
+  while ((ret = archive_read_next_header (archive, &entry)) == ARCHIVE_OK || ret == ARCHIVE_WARN)
+    {
+      const char *name = archive_entry_pathname (entry);
+      if (archive_entry_filetype (entry) == AE_IFREG && name != NULL && is_audio_name (name))
+        g_ptr_array_add (paths, g_strconcat (archive_path, "/", name, NULL));
+    }
+
+  if (ret != ARCHIVE_EOF)
+    g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA, "Failed to read %s: %s", archive_path,
+                 archive_error_string (archive));
+
+  archive_read_free (archive);
+  g_close (fd, NULL);
+  return ret == ARCHIVE_EOF ? g_steal_pointer (&paths) : NULL;
+}
+
+/* Opens a stream reading the given member of the archive. */
+GInputStream *
+auricle_archive_open_member (const char  *archive_path,
+                             const char  *member,
+                             GError     **error)
+{
+  int fd;
+  struct archive *archive = open_archive (archive_path, &fd, error);
+  if (archive == NULL)
+    return NULL;
+
+  struct archive_entry *entry;
+  int ret;
+
+  while ((ret = archive_read_next_header (archive, &entry)) == ARCHIVE_OK || ret == ARCHIVE_WARN)
+    {
+      if (archive_entry_filetype (entry) != AE_IFREG || g_strcmp0 (archive_entry_pathname (entry), member) != 0)
+        continue;
+
+      AuricleArchiveStream *stream = g_object_new (AURICLE_TYPE_ARCHIVE_STREAM, NULL);
+      stream->archive = archive;
+      stream->fd = fd;
+      return G_INPUT_STREAM (stream);
+    }
+
+  if (ret == ARCHIVE_EOF)
+    g_set_error (error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND, "%s has no file named %s", archive_path, member);
+  else
+    g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA, "Failed to read %s: %s", archive_path,
+                 archive_error_string (archive));
+
+  archive_read_free (archive);
+  g_close (fd, NULL);
+  return NULL;
+}
+
+#else
+
+GPtrArray *
+auricle_archive_list (const char  *archive_path,
+                      GError     **error)
+{
+  g_set_error (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED, "Auricle was built without archive support");
+  return NULL;
+}
+
+GInputStream *
+auricle_archive_open_member (const char  *archive_path,
+                             const char  *member,
+                             GError     **error)
+{
+  g_set_error (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED, "Auricle was built without archive support");
+  return NULL;
+}
+
+#endif
@@ -0,0 +1,37 @@
+/* auricle-archive.h
+ *
+ * Copyright 2019 Ryan Gonzalez <rymg19@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+gboolean      auricle_archive_has_archive_name (const char  *path);
+gboolean      auricle_archive_split_path       (const char  *path,
+                                                char       **archive_path,
+                                                char       **member);
+GPtrArray    *auricle_archive_list             (const char  *archive_path,
+                                                GError     **error);
+GInputStream *auricle_archive_open_member      (const char  *archive_path,
+                                                const char  *member,
+                                                GError     **error);
+
+G_END_DECLS
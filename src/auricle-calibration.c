@@ -0,0 +1,372 @@
+/* auricle-calibration.c
+ *
+ * Copyright 2019 Ryan Gonzalez <rymg19@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "auricle-calibration.h"
+#include "auricle-codecs.h"
+#include "auricle-video-segment.h"
+#include <gst/app/app.h>
+
+#define CALIBRATION_CLIP_SECONDS 10
+#define CALIBRATION_SAMPLE_RATE 44100
+#define CALIBRATION_SAMPLES_PER_BUFFER 1024
+#define CALIBRATION_IMAGE_WIDTH 1280
+#define CALIBRATION_IMAGE_HEIGHT 720
+
+// How much faster than realtime a configuration must be to be picked for its smaller output.
+#define CALIBRATION_TARGET_REALTIME_FACTOR 10.0
+
+#define SELECTION_GROUP "selection"
+
+typedef struct _AuricleCalibrationData AuricleCalibrationData;
+
+/* The render options aren't thread-safe, so the calibration thread gets its own copy of the parts it
+   needs. */
+struct _AuricleCalibrationData
+{
+  GdkPixbuf *image;
+  char      *audio_encoder;
+  char      *muxer;
+  guint      bitrate;
+};
+
+static void
+auricle_calibration_data_free (AuricleCalibrationData *data)
+{
+  g_clear_object (&data->image);
+  g_clear_pointer (&data->audio_encoder, g_free);
+  g_clear_pointer (&data->muxer, g_free);
+  g_free (data);
+}
+
+static char *
+get_results_path (void)
+{
+  return g_build_filename (g_get_user_config_dir (), "auricle", "calibration.ini", NULL);
+}
+
+/* A gradient with some structure, so the encoders have something to chew on when no image has been
+   chosen yet. */
+static GdkPixbuf *
+create_test_image (void)
+{
+  GdkPixbuf *pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, FALSE, 8, CALIBRATION_IMAGE_WIDTH,
+                                      CALIBRATION_IMAGE_HEIGHT);
+  guint8 *pixels = gdk_pixbuf_get_pixels (pixbuf);
+  int rowstride = gdk_pixbuf_get_rowstride (pixbuf);
+
+  for (int y = 0; y < CALIBRATION_IMAGE_HEIGHT; y++)
+    {
+      guint8 *row = pixels + y * rowstride;
+      for (int x = 0; x < CALIBRATION_IMAGE_WIDTH; x++)
+        {
+          row[x * 3] = x * 255 / CALIBRATION_IMAGE_WIDTH;
+          row[x * 3 + 1] = y * 255 / CALIBRATION_IMAGE_HEIGHT;
+          row[x * 3 + 2] = ((x / 16) ^ (y / 16)) & 1 ? 0xc0 : 0x40;
+        }
+    }
+
+  return pixbuf;
+}
+
+static GstPadProbeReturn
+on_output_buffer (GstPad          *pad,
+                  GstPadProbeInfo *info,
+                  gpointer         udata)
+{
+  guint64 *size = udata;
+  *size += gst_buffer_get_size (GST_PAD_PROBE_INFO_BUFFER (info));
+  return GST_PAD_PROBE_OK;
+}
+
+typedef struct _AuricleCalibrationSegmentState AuricleCalibrationSegmentState;
+
+struct _AuricleCalibrationSegmentState
+{
+  AuricleVideoSegment *segment;
+  guint                repeat;
+};
+
+static void
+on_segment_src_needs_data (GstAppSrc *appsrc,
+                           guint      length,
+                           gpointer   udata)
+{
+  AuricleCalibrationSegmentState *state = udata;
+  GstClockTime duration = auricle_video_segment_get_duration (state->segment);
+
+  // Unlike the renderer, there's no audio EOS to cut the video off, so stop once the clip is covered.
+  if (state->repeat * duration >= CALIBRATION_CLIP_SECONDS * GST_SECOND)
+    {
+      gst_app_src_end_of_stream (appsrc);
+      return;
+    }
+
+  for (guint i = 0; i < auricle_video_segment_get_n_buffers (state->segment); i++)
+    gst_app_src_push_buffer (appsrc, auricle_video_segment_get_buffer (state->segment, state->repeat, i));
+
+  state->repeat++;
+}
+
+/* Renders a short clip of pink noise over the image through the given configuration as fast as
+   possible, the same way the renderer does for the still image modes: the image is encoded into a
+   segment once, which is then repeated for the length of the clip. The segment encode is part of
+   the measured time, since a render job pays for it too. */
+static gboolean
+measure_configuration (AuricleCalibrationData  *data,
+                       const AuricleCodec      *video_codec,
+                       const char              *preset,
+                       const AuricleCodec      *audio_codec,
+                       const AuricleCodec      *muxer_codec,
+                       double                  *realtime_factor,
+                       guint64                 *size,
+                       GError                 **error)
+{
+  gint64 start_time = g_get_monotonic_time ();
+
+  g_autoptr(GPtrArray) pixbufs = g_ptr_array_new ();
+  g_ptr_array_add (pixbufs, data->image);
+
+  g_autoptr(AuricleVideoSegment) segment = auricle_video_segment_encode (video_codec, preset, pixbufs,
+                                                                         AURICLE_VIDEO_SEGMENT_DEFAULT_DWELL,
+                                                                         error);
+  if (segment == NULL)
+    return FALSE;
+
+  g_autoptr(GstElement) pipeline = gst_pipeline_new ("calibration-pipeline");
+
+  AuricleCodecSettings audio_settings = { .bitrate = data->bitrate };
+  GstElement *audio_enc = auricle_codec_create_encoder (audio_codec, &audio_settings, error);
+  if (audio_enc == NULL)
+    return FALSE;
+  gst_bin_add (GST_BIN (pipeline), audio_enc);
+
+  AuricleCodecSettings mux_settings = { 0 };
+  GstElement *mux = auricle_codec_create_muxer (muxer_codec, &mux_settings, error);
+  if (mux == NULL)
+    return FALSE;
+  gst_bin_add (GST_BIN (pipeline), mux);
+
+  GstElement *src = gst_element_factory_make ("audiotestsrc", NULL);
+  GstElement *filter = gst_element_factory_make ("capsfilter", NULL);
+  GstElement *video_src = gst_element_factory_make ("appsrc", NULL);
+  GstElement *sink = gst_element_factory_make ("fakesink", NULL);
+
+  gst_util_set_object_arg (G_OBJECT (src), "wave", "pink-noise");
+  g_object_set (src, "samplesperbuffer", CALIBRATION_SAMPLES_PER_BUFFER,
+                     "num-buffers", CALIBRATION_CLIP_SECONDS * CALIBRATION_SAMPLE_RATE /
+                                      CALIBRATION_SAMPLES_PER_BUFFER, NULL);
+
+  g_autoptr(GstCaps) caps = gst_caps_new_simple ("audio/x-raw",
+                                                 "rate", G_TYPE_INT, CALIBRATION_SAMPLE_RATE,
+                                                 "channels", G_TYPE_INT, 2, NULL);
+  g_object_set (filter, "caps", caps, NULL);
+
+  AuricleCalibrationSegmentState segment_state = { .segment = segment };
+  gst_app_src_set_caps (GST_APP_SRC (video_src), auricle_video_segment_get_caps (segment));
+  g_object_set (video_src, "format", GST_FORMAT_TIME, NULL);
+  g_signal_connect (video_src, "need-data", G_CALLBACK (on_segment_src_needs_data), &segment_state);
+
+  g_object_set (sink, "sync", FALSE, NULL);
+
+  gst_bin_add_many (GST_BIN (pipeline), src, filter, video_src, sink, NULL);
+  gst_element_link_many (src, filter, audio_enc, NULL);
+  gst_element_link (mux, sink);
+
+  g_autoptr(GstPad) audio_pad = gst_element_get_static_pad (audio_enc, "src");
+  g_autoptr(GstPad) video_pad = gst_element_get_static_pad (video_src, "src");
+  g_autoptr(GstPad) mux_audio_pad = gst_element_get_request_pad (mux, "audio_%u");
+  g_autoptr(GstPad) mux_video_pad = gst_element_get_request_pad (mux, "video_%u");
+  gst_pad_link (audio_pad, mux_audio_pad);
+  gst_pad_link (video_pad, mux_video_pad);
+
+  *size = 0;
+  g_autoptr(GstPad) sink_pad = gst_element_get_static_pad (sink, "sink");
+  gst_pad_add_probe (sink_pad, GST_PAD_PROBE_TYPE_BUFFER, on_output_buffer, size, NULL);
+
+  g_autoptr(GstBus) bus = gst_element_get_bus (pipeline);
+
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+  g_autoptr(GstMessage) message = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+                                                              GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  double elapsed = (g_get_monotonic_time () - start_time) / (double) G_USEC_PER_SEC;
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+
+  gst_element_release_request_pad (mux, mux_audio_pad);
+  gst_element_release_request_pad (mux, mux_video_pad);
+
+  if (GST_MESSAGE_TYPE (message) == GST_MESSAGE_ERROR)
+    {
+      gst_message_parse_error (message, error, NULL);
+      return FALSE;
+    }
+
+  *realtime_factor = CALIBRATION_CLIP_SECONDS / MAX (elapsed, 0.001);
+  return TRUE;
+}
+
+static void
+auricle_calibration_thread (GTask        *task,
+                            gpointer      source_object,
+                            gpointer      task_data,
+                            GCancellable *cancellable)
+{
+  AuricleCalibrationData *data = task_data;
+  GError *error = NULL;
+
+  const AuricleCodec *muxer_codec, *video_codec, *audio_codec;
+  if (!auricle_codecs_resolve (data->muxer, NULL, data->audio_encoder, &muxer_codec, &video_codec,
+                               &audio_codec, &error))
+    {
+      g_task_return_error (task, error);
+      return;
+    }
+
+  g_autoptr(GKeyFile) results = g_key_file_new ();
+  g_autoptr(GPtrArray) video_codecs = auricle_codecs_list (AURICLE_CODEC_KIND_VIDEO);
+
+  const AuricleCodec *best_codec = NULL;
+  const char *best_preset = NULL;
+  double best_realtime_factor = 0;
+  guint64 best_size = 0;
+
+  for (guint i = 0; i < video_codecs->len; i++)
+    {
+      const AuricleCodec *codec = g_ptr_array_index (video_codecs, i);
+      if (!auricle_codec_can_mux (muxer_codec, codec))
+        continue;
+
+      // Codecs without any presets are still tried once, with their defaults.
+      guint n_presets = codec->presets != NULL ? g_strv_length ((char **) codec->presets) : 1;
+
+      for (guint j = 0; j < n_presets; j++)
+        {
+          if (g_task_return_error_if_cancelled (task))
+            return;
+
+          const char *preset = codec->presets != NULL ? codec->presets[j] : NULL;
+          double realtime_factor;
+          guint64 size;
+
+          if (!measure_configuration (data, codec, preset, audio_codec, muxer_codec, &realtime_factor, &size,
+                                      &error))
+            {
+              g_warning ("Failed to benchmark %s (%s): %s", codec->name, preset ? preset : "default",
+                         error->message);
+              g_clear_error (&error);
+              continue;
+            }
+
+          g_info ("Calibration: %s (%s) ran at %.1fx realtime, %" G_GUINT64_FORMAT " bytes", codec->name,
+                  preset ? preset : "default", realtime_factor, size);
+
+          g_autofree char *group = g_strdup_printf ("%s:%s", codec->id, preset ? preset : "default");
+          g_key_file_set_double (results, group, "realtime-factor", realtime_factor);
+          g_key_file_set_uint64 (results, group, "size", size);
+
+          // Prefer the smallest output among the configurations fast enough, or failing that, the
+          // fastest one.
+          gboolean fast_enough = realtime_factor >= CALIBRATION_TARGET_REALTIME_FACTOR;
+          gboolean best_fast_enough = best_realtime_factor >= CALIBRATION_TARGET_REALTIME_FACTOR;
+
+          if (best_codec == NULL || (fast_enough && !best_fast_enough) ||
+              (fast_enough && best_fast_enough && size < best_size) ||
+              (!fast_enough && !best_fast_enough && realtime_factor > best_realtime_factor))
+            {
+              best_codec = codec;
+              best_preset = preset;
+              best_realtime_factor = realtime_factor;
+              best_size = size;
+            }
+        }
+    }
+
+  if (best_codec == NULL)
+    {
+      g_task_return_new_error (task, GST_CORE_ERROR, GST_CORE_ERROR_FAILED, "None of the video encoders worked");
+      return;
+    }
+
+  g_key_file_set_double (results, SELECTION_GROUP, "target-realtime-factor", CALIBRATION_TARGET_REALTIME_FACTOR);
+  g_key_file_set_string (results, SELECTION_GROUP, "video-encoder", best_codec->id);
+  if (best_preset != NULL)
+    g_key_file_set_string (results, SELECTION_GROUP, "video-preset", best_preset);
+
+  g_autofree char *path = get_results_path ();
+  g_autofree char *dirname = g_path_get_dirname (path);
+  g_mkdir_with_parents (dirname, 0755);
+
+  if (!g_key_file_save_to_file (results, path, &error))
+    {
+      g_task_return_error (task, error);
+      return;
+    }
+
+  g_task_return_boolean (task, TRUE);
+}
+
+/* Benchmarks every installed video encoder and preset that works with the chosen audio encoder and
+   muxer, storing the results in the user's config directory. If no image is given, a generated test
+   image is used instead. Use auricle_calibration_apply once it's done to pick up the results. */
+void
+auricle_calibration_run_async (GdkPixbuf            *image,
+                               AuricleRenderOptions *render_options,
+                               GCancellable         *cancellable,
+                               GAsyncReadyCallback   callback,
+                               gpointer              udata)
+{
+  AuricleCalibrationData *data = g_new0 (AuricleCalibrationData, 1);
+  data->image = image != NULL ? g_object_ref (image) : create_test_image ();
+  data->audio_encoder = g_strdup (auricle_render_options_get_audio_encoder (render_options));
+  data->muxer = g_strdup (auricle_render_options_get_muxer (render_options));
+  data->bitrate = auricle_render_options_get_audio_bitrate (render_options);
+
+  g_autoptr(GTask) task = g_task_new (NULL, cancellable, callback, udata);
+  g_task_set_task_data (task, data, (GDestroyNotify) auricle_calibration_data_free);
+  g_task_run_in_thread (task, auricle_calibration_thread);
+}
+
+gboolean
+auricle_calibration_run_finish (GAsyncResult  *result,
+                                GError       **error)
+{
+  return g_task_propagate_boolean (G_TASK (result), error);
+}
+
+/* Applies the stored calibration results to the render options. Returns FALSE if there are none, or
+   if the chosen encoder has since been uninstalled. */
+gboolean
+auricle_calibration_apply (AuricleRenderOptions *render_options)
+{
+  g_autoptr(GKeyFile) results = g_key_file_new ();
+  g_autofree char *path = get_results_path ();
+  if (!g_key_file_load_from_file (results, path, G_KEY_FILE_NONE, NULL))
+    return FALSE;
+
+  g_autofree char *video_encoder = g_key_file_get_string (results, SELECTION_GROUP, "video-encoder", NULL);
+  const AuricleCodec *codec = auricle_codecs_find (AURICLE_CODEC_KIND_VIDEO, video_encoder);
+  if (codec == NULL || !codec->available)
+    return FALSE;
+
+  g_autofree char *video_preset = g_key_file_get_string (results, SELECTION_GROUP, "video-preset", NULL);
+
+  auricle_render_options_set_video_encoder (render_options, video_encoder);
+  auricle_render_options_set_video_preset (render_options, video_preset);
+  return TRUE;
+}
@@ -0,0 +1,39 @@
+/* auricle-calibration.h
+ *
+ * Copyright 2019 Ryan Gonzalez <rymg19@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include "auricle-render-options.h"
+
+G_BEGIN_DECLS
+
+void     auricle_calibration_run_async  (GdkPixbuf             *image,
+                                         AuricleRenderOptions  *render_options,
+                                         GCancellable          *cancellable,
+                                         GAsyncReadyCallback    callback,
+                                         gpointer               udata);
+gboolean auricle_calibration_run_finish (GAsyncResult          *result,
+                                         GError               **error);
+
+gboolean auricle_calibration_apply (AuricleRenderOptions *render_options);
+
+G_END_DECLS
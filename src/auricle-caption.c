@@ -0,0 +1,80 @@
+/* auricle-caption.c
+ *
+ * Copyright 2019 Ryan Gonzalez <rymg19@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "auricle-caption.h"
+#include <gdk/gdk.h>
+#include <pango/pangocairo.h>
+
+// The caption's font size and margins are relative to the image height, so it looks the same
+// regardless of the image resolution.
+#define CAPTION_FONT_SCALE 0.05
+#define CAPTION_MARGIN_SCALE 0.03
+
+/* Draws text onto a copy of the image. This is done once per render job, so the caption ends up
+   baked into the still frame instead of being overlaid on every single video frame. */
+GdkPixbuf *
+auricle_caption_render (GdkPixbuf  *image,
+                        const char *text)
+{
+  int width = gdk_pixbuf_get_width (image);
+  int height = gdk_pixbuf_get_height (image);
+
+  cairo_surface_t *surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, width, height);
+  cairo_t *cr = cairo_create (surface);
+
+  gdk_cairo_set_source_pixbuf (cr, image, 0, 0);
+  cairo_paint (cr);
+
+  int font_size = MAX (height * CAPTION_FONT_SCALE, 8);
+  int margin = height * CAPTION_MARGIN_SCALE;
+
+  g_autoptr(PangoFontDescription) font = pango_font_description_new ();
+  pango_font_description_set_family (font, "Sans");
+  pango_font_description_set_weight (font, PANGO_WEIGHT_BOLD);
+  pango_font_description_set_absolute_size (font, font_size * PANGO_SCALE);
+
+  g_autoptr(PangoLayout) layout = pango_cairo_create_layout (cr);
+  pango_layout_set_font_description (layout, font);
+  pango_layout_set_alignment (layout, PANGO_ALIGN_CENTER);
+  pango_layout_set_width (layout, (width - margin * 2) * PANGO_SCALE);
+  pango_layout_set_wrap (layout, PANGO_WRAP_WORD_CHAR);
+  pango_layout_set_text (layout, text, -1);
+
+  int text_width, text_height;
+  pango_layout_get_pixel_size (layout, &text_width, &text_height);
+
+  int text_y = height - margin - text_height;
+
+  // Darken a band behind the text so it stays readable on bright images.
+  cairo_set_source_rgba (cr, 0, 0, 0, 0.5);
+  cairo_rectangle (cr, 0, text_y - margin / 2, width, text_height + margin);
+  cairo_fill (cr);
+
+  cairo_move_to (cr, margin, text_y);
+  cairo_set_source_rgb (cr, 1, 1, 1);
+  pango_cairo_show_layout (cr, layout);
+
+  cairo_destroy (cr);
+
+  GdkPixbuf *result = gdk_pixbuf_get_from_surface (surface, 0, 0, width, height);
+  cairo_surface_destroy (surface);
+  return result;
+}
+
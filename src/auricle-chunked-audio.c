@@ -0,0 +1,571 @@
+/* auricle-chunked-audio.c
+ *
+ * Copyright 2019 Ryan Gonzalez <rymg19@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "auricle-chunked-audio.h"
+#include "auricle-utils.h"
+#include <errno.h>
+#include <glib/gstdio.h>
+#include <gst/app/app.h>
+#include <stdio.h>
+
+/* Long tracks are encoded as several time ranges in parallel, then concatenated back together.
+
+   Each range starts being encoded a little early, and the frames before its actual start are
+   thrown away. That way the encoder is already warmed up at the boundary, and the frame that
+   decodes right before it (the last one of the previous range) was encoded from the same audio.
+   The boundaries are placed on the encoder's frame grid, so the kept frames of every range line
+   up with each other. */
+
+// Tracks at least this long are worth splitting up.
+#define CHUNKED_MIN_DURATION (20 * 60 * GST_SECOND)
+// Shorter ranges than this spend too much of their time on the overlap and pipeline setup.
+#define CHUNK_MIN_DURATION (5 * 60 * GST_SECOND)
+#define CHUNK_OVERLAP_FRAMES 48
+#define CHUNK_POLL_INTERVAL (100 * GST_MSECOND)
+// Enough of the next chunk's start to be read by the time its pipeline is up.
+#define CHUNK_PREFETCH_BYTES (16 * 1024 * 1024)
+
+typedef struct _AuricleChunk AuricleChunk;
+
+struct _AuricleChunk
+{
+  guint     index;
+  char     *path;
+  gboolean  started;
+  gboolean  done;
+  GError   *error;
+  GstCaps  *caps;
+};
+
+typedef struct _AuricleChunkedAudio AuricleChunkedAudio;
+
+struct _AuricleChunkedAudio
+{
+  volatile gint ref_count;
+
+  GMutex        lock;
+  GCond         cond;
+  GCancellable *cancellable;
+
+  char                 *path;
+  const AuricleCodec   *codec;
+  AuricleCodecSettings  settings;
+  GstClockTime          duration;
+  guint64               size;
+
+  guint         n_chunks;
+  AuricleChunk *chunks;
+
+  GstAppSrc *src;
+  GThread   *feeder;
+};
+
+// A chunk queued on the shared pool, which holds a reference to its state until it's run.
+typedef struct _AuricleChunkTask AuricleChunkTask;
+
+struct _AuricleChunkTask
+{
+  AuricleChunkedAudio *state;
+  AuricleChunk        *chunk;
+};
+
+// The frames are spilled into temporary files, since a long track's worth won't fit in memory.
+typedef struct _AuricleChunkFrameHeader AuricleChunkFrameHeader;
+
+struct _AuricleChunkFrameHeader
+{
+  guint64 duration;
+  guint32 size;
+};
+
+static AuricleChunkedAudio *
+auricle_chunked_audio_ref (AuricleChunkedAudio *self)
+{
+  g_atomic_int_inc (&self->ref_count);
+  return self;
+}
+
+static void
+auricle_chunked_audio_unref (AuricleChunkedAudio *self)
+{
+  if (!g_atomic_int_dec_and_test (&self->ref_count))
+    return;
+
+  for (guint i = 0; i < self->n_chunks; i++)
+    {
+      AuricleChunk *chunk = &self->chunks[i];
+      if (chunk->path != NULL)
+        g_unlink (chunk->path);
+
+      g_clear_pointer (&chunk->path, g_free);
+      g_clear_error (&chunk->error);
+      g_clear_pointer (&chunk->caps, gst_caps_unref);
+    }
+
+  g_free (self->chunks);
+  g_free (self->path);
+  g_clear_object (&self->cancellable);
+  g_mutex_clear (&self->lock);
+  g_cond_clear (&self->cond);
+  g_free (self);
+}
+
+/* Called once the source is destroyed, which only happens after its pipeline stopped. */
+static void
+auricle_chunked_audio_destroy (AuricleChunkedAudio *self)
+{
+  g_mutex_lock (&self->lock);
+  g_cancellable_cancel (self->cancellable);
+  g_cond_broadcast (&self->cond);
+  g_mutex_unlock (&self->lock);
+
+  g_thread_join (self->feeder);
+  auricle_chunked_audio_unref (self);
+}
+
+/* Returns how many ranges a track of the given length should be split into, or 1 if it shouldn't be. */
+guint
+auricle_chunked_audio_get_chunk_count (GstClockTime duration)
+{
+  if (!GST_CLOCK_TIME_IS_VALID (duration) || duration < CHUNKED_MIN_DURATION)
+    return 1;
+
+  guint64 n_chunks = duration / CHUNK_MIN_DURATION;
+  return CLAMP (n_chunks, 1, g_get_num_processors ());
+}
+
+static void
+on_dec_pad_added (GstElement *el,
+                  GstPad     *pad,
+                  GstElement *enc)
+{
+  g_autoptr(GstPad) sinkpad = gst_element_get_static_pad (enc, "sink");
+  g_autoptr(GstCaps) caps = gst_pad_query_caps (pad, NULL);
+
+  if (gst_pad_is_linked (sinkpad) || gst_caps_is_empty (caps) ||
+      !g_str_has_prefix (gst_structure_get_name (gst_caps_get_structure (caps, 0)), "audio/"))
+    return;
+
+  gst_pad_link (pad, sinkpad);
+}
+
+static gboolean
+check_pipeline_error (GstElement  *pipeline,
+                      GError     **error)
+{
+  g_autoptr(GstBus) bus = gst_element_get_bus (pipeline);
+  g_autoptr(GstMessage) message = gst_bus_pop_filtered (bus, GST_MESSAGE_ERROR);
+  if (message == NULL)
+    return TRUE;
+
+  gst_message_parse_error (message, error, NULL);
+  return FALSE;
+}
+
+static gboolean
+wait_for_preroll (GstElement  *pipeline,
+                  GError     **error)
+{
+  if (gst_element_get_state (pipeline, NULL, NULL, GST_CLOCK_TIME_NONE) != GST_STATE_CHANGE_FAILURE)
+    return TRUE;
+
+  if (check_pipeline_error (pipeline, error))
+    g_set_error (error, GST_CORE_ERROR, GST_CORE_ERROR_STATE_CHANGE, "Failed to start encoding");
+  return FALSE;
+}
+
+static guint64
+get_chunk_boundary (AuricleChunkedAudio *self,
+                    guint                index,
+                    guint64              total_samples,
+                    guint64              frame_samples)
+{
+  if (index == self->n_chunks)
+    return G_MAXUINT64;
+
+  guint64 boundary = total_samples * index / self->n_chunks;
+  return boundary / frame_samples * frame_samples;
+}
+
+static gboolean
+write_frame (FILE       *file,
+             GstBuffer  *buffer,
+             GError    **error)
+{
+  GstMapInfo map;
+  if (!gst_buffer_map (buffer, &map, GST_MAP_READ))
+    {
+      g_set_error (error, GST_RESOURCE_ERROR, GST_RESOURCE_ERROR_FAILED, "Failed to map an encoded frame");
+      return FALSE;
+    }
+
+  AuricleChunkFrameHeader header = { .duration = GST_BUFFER_DURATION (buffer), .size = map.size };
+  gboolean written = fwrite (&header, sizeof (header), 1, file) == 1 &&
+                     fwrite (map.data, 1, map.size, file) == map.size;
+  gst_buffer_unmap (buffer, &map);
+
+  if (!written)
+    g_set_error (error, GST_RESOURCE_ERROR, GST_RESOURCE_ERROR_WRITE, "Failed to write an encoded frame: %s",
+                 g_strerror (errno));
+  return written;
+}
+
+static gboolean
+encode_chunk_to_file (AuricleChunkedAudio  *self,
+                      AuricleChunk         *chunk,
+                      FILE                 *file,
+                      GError              **error)
+{
+  GstElement *enc = auricle_codec_create_encoder (self->codec, &self->settings, error);
+  if (enc == NULL)
+    return FALSE;
+
+  g_autoptr(GstElement) pipeline = gst_pipeline_new (NULL);
+
+  GstElement *src = auricle_file_source_new (self->path);
+
+  GstElement *dec = gst_element_factory_make ("decodebin3", NULL);
+  GstElement *sink = gst_element_factory_make ("appsink", NULL);
+  g_object_set (sink, "sync", FALSE, NULL);
+
+  gst_bin_add_many (GST_BIN (pipeline), src, dec, enc, sink, NULL);
+  gst_element_link (src, dec);
+  gst_element_link (enc, sink);
+  g_signal_connect (dec, "pad-added", G_CALLBACK (on_dec_pad_added), enc);
+
+  // The first frame gives away the encoder's output rate and frame size, which the boundaries
+  // need to be aligned to.
+  gst_element_set_state (pipeline, GST_STATE_PAUSED);
+  if (!wait_for_preroll (pipeline, error))
+    {
+      gst_element_set_state (pipeline, GST_STATE_NULL);
+      return FALSE;
+    }
+
+  g_autoptr(GstSample) preroll = gst_app_sink_try_pull_preroll (GST_APP_SINK (sink), 0);
+  GstStructure *structure = preroll != NULL ? gst_caps_get_structure (gst_sample_get_caps (preroll), 0) : NULL;
+  GstBuffer *first_frame = preroll != NULL ? gst_sample_get_buffer (preroll) : NULL;
+  int rate = 0;
+
+  if (structure == NULL || !gst_structure_get_int (structure, "rate", &rate) || rate <= 0 ||
+      !GST_BUFFER_DURATION_IS_VALID (first_frame))
+    {
+      gst_element_set_state (pipeline, GST_STATE_NULL);
+      g_set_error (error, GST_STREAM_ERROR, GST_STREAM_ERROR_FORMAT,
+                   "Cannot split %s into ranges without its frame size", self->codec->name);
+      return FALSE;
+    }
+
+  guint64 frame_samples = gst_util_uint64_scale_round (GST_BUFFER_DURATION (first_frame), rate, GST_SECOND);
+  frame_samples = MAX (frame_samples, 1);
+  guint64 total_samples = gst_util_uint64_scale (self->duration, rate, GST_SECOND);
+
+  guint64 start_sample = get_chunk_boundary (self, chunk->index, total_samples, frame_samples);
+  guint64 end_sample = get_chunk_boundary (self, chunk->index + 1, total_samples, frame_samples);
+  guint64 overlap_samples = CHUNK_OVERLAP_FRAMES * frame_samples;
+  guint64 seek_sample = start_sample > overlap_samples ? start_sample - overlap_samples : 0;
+
+  GstClockTime start_time = gst_util_uint64_scale (start_sample, GST_SECOND, rate);
+  GstClockTime end_time = end_sample != G_MAXUINT64 ? gst_util_uint64_scale (end_sample, GST_SECOND, rate)
+                                                    : GST_CLOCK_TIME_NONE;
+  GstClockTime seek_time = gst_util_uint64_scale (seek_sample, GST_SECOND, rate);
+
+  // Run a bit past the end too, so the encoder isn't flushing its last kept frames.
+  GstClockTime stop_time = GST_CLOCK_TIME_IS_VALID (end_time)
+                           ? end_time + gst_util_uint64_scale (overlap_samples, GST_SECOND, rate)
+                           : GST_CLOCK_TIME_NONE;
+  gst_element_seek (pipeline, 1.0, GST_FORMAT_TIME, GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_ACCURATE,
+                    GST_SEEK_TYPE_SET, seek_time,
+                    GST_CLOCK_TIME_IS_VALID (stop_time) ? GST_SEEK_TYPE_SET : GST_SEEK_TYPE_NONE, stop_time);
+
+  g_debug ("Encoding range %u of %s: %" GST_TIME_FORMAT " - %" GST_TIME_FORMAT, chunk->index, self->path,
+           GST_TIME_ARGS (start_time), GST_TIME_ARGS (end_time));
+
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+
+  gboolean ok = TRUE;
+  while (ok)
+    {
+      if (g_cancellable_set_error_if_cancelled (self->cancellable, error))
+        {
+          ok = FALSE;
+          break;
+        }
+
+      g_autoptr(GstSample) sample = gst_app_sink_try_pull_sample (GST_APP_SINK (sink), CHUNK_POLL_INTERVAL);
+      if (sample == NULL)
+        {
+          if (gst_app_sink_is_eos (GST_APP_SINK (sink)))
+            break;
+
+          ok = check_pipeline_error (pipeline, error);
+          continue;
+        }
+
+      GstBuffer *buffer = gst_sample_get_buffer (sample);
+      GstClockTime middle = GST_BUFFER_PTS (buffer) + GST_BUFFER_DURATION (buffer) / 2;
+      if (middle < start_time)
+        continue;
+      if (GST_CLOCK_TIME_IS_VALID (end_time) && middle >= end_time)
+        break;
+
+      if (chunk->caps == NULL)
+        chunk->caps = gst_caps_ref (gst_sample_get_caps (sample));
+
+      ok = write_frame (file, buffer, error);
+    }
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  return ok;
+}
+
+static gboolean
+encode_chunk (AuricleChunkedAudio  *self,
+              AuricleChunk         *chunk,
+              GError              **error)
+{
+  g_autofree char *name_template = g_strdup_printf ("auricle-chunk-%u-XXXXXX", chunk->index);
+  int fd = g_file_open_tmp (name_template, &chunk->path, error);
+  if (fd == -1)
+    return FALSE;
+
+  FILE *file = fdopen (fd, "wb");
+  if (file == NULL)
+    {
+      int saved_errno = errno;
+      g_close (fd, NULL);
+      g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (saved_errno), "Failed to open %s: %s",
+                   chunk->path, g_strerror (saved_errno));
+      return FALSE;
+    }
+
+  gboolean ok = encode_chunk_to_file (self, chunk, file, error);
+  if (fclose (file) != 0 && ok)
+    {
+      int saved_errno = errno;
+      g_set_error (error, G_FILE_ERROR, g_file_error_from_errno (saved_errno), "Failed to write %s: %s",
+                   chunk->path, g_strerror (saved_errno));
+      ok = FALSE;
+    }
+
+  return ok;
+}
+
+static void
+run_chunk_task (gpointer task_ptr,
+                gpointer udata)
+{
+  AuricleChunkTask *task = task_ptr;
+  AuricleChunkedAudio *self = task->state;
+  AuricleChunk *chunk = task->chunk;
+
+  // The shared pool may be busy with other jobs, so the next range still waiting for a thread
+  // starts being read in while this one encodes. Its place in the file is a guess from its place in
+  // the track.
+  g_mutex_lock (&self->lock);
+  chunk->started = TRUE;
+  AuricleChunk *next = NULL;
+  for (guint i = 0; i < self->n_chunks && next == NULL; i++)
+    {
+      if (!self->chunks[i].started)
+        next = &self->chunks[i];
+    }
+  g_mutex_unlock (&self->lock);
+
+  if (next != NULL && self->size != 0 && !g_cancellable_is_cancelled (self->cancellable))
+    auricle_prefetch_file (self->path, self->size / self->n_chunks * next->index, CHUNK_PREFETCH_BYTES);
+
+  g_autoptr(GError) error = NULL;
+  if (!g_cancellable_is_cancelled (self->cancellable))
+    encode_chunk (self, chunk, &error);
+
+  g_mutex_lock (&self->lock);
+  chunk->done = TRUE;
+  chunk->error = g_steal_pointer (&error);
+  g_cond_broadcast (&self->cond);
+  g_mutex_unlock (&self->lock);
+
+  auricle_chunked_audio_unref (self);
+  g_free (task);
+}
+
+static GThreadPool *
+get_chunk_pool (void)
+{
+  static GThreadPool *pool = NULL;
+
+  if (g_once_init_enter (&pool))
+    {
+      // Shared by every job, so several long tracks don't each claim all the cores.
+      GThreadPool *new_pool = g_thread_pool_new (run_chunk_task, NULL, g_get_num_processors (), FALSE, NULL);
+      g_once_init_leave (&pool, new_pool);
+    }
+
+  return pool;
+}
+
+static gboolean
+push_chunk_frames (AuricleChunkedAudio *self,
+                   AuricleChunk        *chunk,
+                   FILE                *file,
+                   GstClockTime        *next_pts)
+{
+  AuricleChunkFrameHeader header;
+  while (fread (&header, sizeof (header), 1, file) == 1)
+    {
+      GstBuffer *buffer = gst_buffer_new_allocate (NULL, header.size, NULL);
+      GstMapInfo map;
+      gst_buffer_map (buffer, &map, GST_MAP_WRITE);
+      gboolean read = fread (map.data, 1, header.size, file) == header.size;
+      gst_buffer_unmap (buffer, &map);
+
+      if (!read)
+        {
+          gst_buffer_unref (buffer);
+          GST_ELEMENT_ERROR (GST_ELEMENT (self->src), RESOURCE, READ,
+                             ("Truncated encoded range in %s", chunk->path), (NULL));
+          return FALSE;
+        }
+
+      // The ranges are laid back to back, whatever the source timestamps drifted to.
+      GST_BUFFER_PTS (buffer) = GST_BUFFER_DTS (buffer) = *next_pts;
+      GST_BUFFER_DURATION (buffer) = header.duration;
+      *next_pts += header.duration;
+
+      if (gst_app_src_push_buffer (self->src, buffer) != GST_FLOW_OK)
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+static gboolean
+push_chunk (AuricleChunkedAudio *self,
+            AuricleChunk        *chunk,
+            GstClockTime        *next_pts)
+{
+  FILE *file = g_fopen (chunk->path, "rb");
+  if (file == NULL)
+    {
+      GST_ELEMENT_ERROR (GST_ELEMENT (self->src), RESOURCE, READ,
+                         ("Failed to read %s: %s", chunk->path, g_strerror (errno)), (NULL));
+      return FALSE;
+    }
+
+  gboolean pushed = push_chunk_frames (self, chunk, file, next_pts);
+  fclose (file);
+  return pushed;
+}
+
+/* Pushes the ranges into the source in order, as soon as each one is done. */
+static gpointer
+feed_chunks (gpointer udata)
+{
+  AuricleChunkedAudio *self = udata;
+  GstClockTime next_pts = 0;
+
+  for (guint i = 0; i < self->n_chunks; i++)
+    {
+      AuricleChunk *chunk = &self->chunks[i];
+
+      g_mutex_lock (&self->lock);
+      while (!chunk->done && !g_cancellable_is_cancelled (self->cancellable))
+        g_cond_wait (&self->cond, &self->lock);
+      g_mutex_unlock (&self->lock);
+
+      if (g_cancellable_is_cancelled (self->cancellable))
+        return NULL;
+
+      if (chunk->error != NULL)
+        {
+          GST_ELEMENT_ERROR (GST_ELEMENT (self->src), STREAM, ENCODE,
+                             ("Failed to encode range %u: %s", i, chunk->error->message), (NULL));
+          return NULL;
+        }
+
+      if (i == 0)
+        gst_app_src_set_caps (self->src, chunk->caps);
+
+      gboolean pushed = push_chunk (self, chunk, &next_pts);
+
+      // Free up the disk space as soon as possible.
+      g_unlink (chunk->path);
+      g_clear_pointer (&chunk->path, g_free);
+
+      if (!pushed)
+        return NULL;
+    }
+
+  gst_app_src_end_of_stream (self->src);
+  return NULL;
+}
+
+/* Creates a source that outputs the given file's audio, encoded in n_chunks ranges in parallel. The
+   duration must be the track's full length. */
+GstElement *
+auricle_chunked_audio_new (const char                 *path,
+                           const AuricleCodec         *codec,
+                           const AuricleCodecSettings *settings,
+                           GstClockTime                duration,
+                           guint                       n_chunks)
+{
+  g_return_val_if_fail (codec->kind == AURICLE_CODEC_KIND_AUDIO, NULL);
+  g_return_val_if_fail (GST_CLOCK_TIME_IS_VALID (duration) && n_chunks > 0, NULL);
+
+  AuricleChunkedAudio *self = g_new0 (AuricleChunkedAudio, 1);
+  self->ref_count = 1;
+  g_mutex_init (&self->lock);
+  g_cond_init (&self->cond);
+  self->cancellable = g_cancellable_new ();
+
+  self->path = g_strdup (path);
+  self->codec = codec;
+  self->settings = *settings;
+  self->duration = duration;
+
+  GStatBuf st;
+  if (g_stat (path, &st) == 0)
+    self->size = st.st_size;
+
+  self->n_chunks = n_chunks;
+  self->chunks = g_new0 (AuricleChunk, n_chunks);
+
+  GstElement *src = gst_element_factory_make ("appsrc", NULL);
+  g_object_set (src, "format", GST_FORMAT_TIME,
+                     "block", TRUE, NULL);
+  gst_app_src_set_duration (GST_APP_SRC (src), duration);
+  self->src = GST_APP_SRC (src);
+
+  for (guint i = 0; i < n_chunks; i++)
+    {
+      self->chunks[i].index = i;
+
+      AuricleChunkTask *task = g_new (AuricleChunkTask, 1);
+      task->state = auricle_chunked_audio_ref (self);
+      task->chunk = &self->chunks[i];
+      g_thread_pool_push (get_chunk_pool (), task, NULL);
+    }
+
+  self->feeder = g_thread_new ("auricle-chunk-feeder", feed_chunks, self);
+  g_object_set_data_full (G_OBJECT (src), "auricle-chunked-audio", self,
+                          (GDestroyNotify) auricle_chunked_audio_destroy);
+
+  return src;
+}
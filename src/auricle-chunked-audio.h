@@ -0,0 +1,36 @@
+/* auricle-chunked-audio.h
+ *
+ * Copyright 2019 Ryan Gonzalez <rymg19@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <gst/gst.h>
+#include "auricle-codecs.h"
+
+G_BEGIN_DECLS
+
+GstElement *auricle_chunked_audio_new (const char                 *path,
+                                       const AuricleCodec         *codec,
+                                       const AuricleCodecSettings *settings,
+                                       GstClockTime                duration,
+                                       guint                       n_chunks);
+
+guint auricle_chunked_audio_get_chunk_count (GstClockTime duration);
+
+G_END_DECLS
@@ -0,0 +1,451 @@
+/* auricle-codecs.c
+ *
+ * Copyright 2019 Ryan Gonzalez <rymg19@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "auricle-codecs.h"
+#include <math.h>
+
+#define H264_CAPS "video/x-h264, stream-format=avc, alignment=au"
+#define AAC_CAPS "audio/mpeg, mpegversion=4"
+
+/* Element properties have been renamed and added across plugin versions, so anything the installed
+   element doesn't know about is skipped rather than warned about. */
+static void
+set_arg (GstElement *element,
+         const char *property,
+         const char *value)
+{
+  if (g_object_class_find_property (G_OBJECT_GET_CLASS (element), property) == NULL)
+    {
+      g_debug ("%s has no %s property", GST_ELEMENT_NAME (element), property);
+      return;
+    }
+
+  gst_util_set_object_arg (G_OBJECT (element), property, value);
+}
+
+static void
+set_uint (GstElement *element,
+          const char *property,
+          guint       value)
+{
+  g_autofree char *string = g_strdup_printf ("%u", value);
+  set_arg (element, property, string);
+}
+
+static void
+configure_x264 (GstElement                 *element,
+                const AuricleCodecSettings *settings)
+{
+  // Leaving out B-frames keeps the DTS equal to the PTS, which makes re-timestamping repeated GOPs
+  // trivial.
+  set_uint (element, "bframes", 0);
+
+  if (settings->keyframe_interval != 0)
+    set_uint (element, "key-int-max", settings->keyframe_interval);
+  if (settings->still_image)
+    set_arg (element, "tune", "stillimage");
+  if (settings->fast)
+    set_arg (element, "speed-preset", "veryfast");
+}
+
+static void
+configure_openh264 (GstElement                 *element,
+                    const AuricleCodecSettings *settings)
+{
+  // The default bitrate is meant for video calls, not full-size artwork.
+  set_uint (element, "bitrate", 2000000);
+
+  if (settings->keyframe_interval != 0)
+    set_uint (element, "gop-size", settings->keyframe_interval);
+  if (settings->fast)
+    set_arg (element, "complexity", "low");
+}
+
+static void
+configure_vp9 (GstElement                 *element,
+               const AuricleCodecSettings *settings)
+{
+  set_arg (element, "end-usage", "q");
+  set_uint (element, "cq-level", 32);
+  set_arg (element, "row-mt", "true");
+
+  if (settings->keyframe_interval != 0)
+    set_uint (element, "keyframe-max-dist", settings->keyframe_interval);
+  set_uint (element, "cpu-used", settings->fast ? 8 : 4);
+}
+
+static void
+configure_svtav1 (GstElement                 *element,
+                  const AuricleCodecSettings *settings)
+{
+  set_uint (element, "crf", 35);
+
+  if (settings->keyframe_interval != 0)
+    set_uint (element, "intra-period-length", settings->keyframe_interval);
+  set_uint (element, "preset", settings->fast ? 12 : 8);
+}
+
+static void
+configure_audio_bitrate (GstElement                 *element,
+                         const AuricleCodecSettings *settings)
+{
+  set_uint (element, "bitrate", settings->bitrate * 1000);
+}
+
+static const char * const x264_presets[] = { "superfast", "veryfast", "faster", "fast", "medium", NULL };
+static const char * const openh264_presets[] = { "low", "medium", "high", NULL };
+static const char * const vp9_presets[] = { "8", "6", "4", NULL };
+static const char * const svtav1_presets[] = { "12", "10", "8", NULL };
+
+// Within each kind, the codecs are listed in order of preference for fallbacks.
+static AuricleCodec codecs[] = {
+  { AURICLE_CODEC_KIND_VIDEO, "x264", "H.264 (x264)", "x264enc", NULL, H264_CAPS, NULL,
+    "speed-preset", x264_presets, configure_x264 },
+  { AURICLE_CODEC_KIND_VIDEO, "openh264", "H.264 (OpenH264)", "openh264enc", "h264parse", H264_CAPS, NULL,
+    "complexity", openh264_presets, configure_openh264 },
+  { AURICLE_CODEC_KIND_VIDEO, "vp9", "VP9", "vp9enc", NULL, "video/x-vp9", NULL,
+    "cpu-used", vp9_presets, configure_vp9 },
+  { AURICLE_CODEC_KIND_VIDEO, "svtav1", "AV1 (SVT-AV1)", "svtav1enc", "av1parse", "video/x-av1", NULL,
+    "preset", svtav1_presets, configure_svtav1 },
+
+  { AURICLE_CODEC_KIND_AUDIO, "fdkaac", "AAC (FDK)", "fdkaacenc", NULL, AAC_CAPS, NULL, NULL, NULL,
+    configure_audio_bitrate },
+  { AURICLE_CODEC_KIND_AUDIO, "avenc_aac", "AAC (FFmpeg)", "avenc_aac", "aacparse", AAC_CAPS, NULL, NULL, NULL,
+    configure_audio_bitrate },
+  { AURICLE_CODEC_KIND_AUDIO, "opus", "Opus", "opusenc", NULL, "audio/x-opus", NULL, NULL, NULL,
+    configure_audio_bitrate },
+  { AURICLE_CODEC_KIND_AUDIO, "vorbis", "Vorbis", "vorbisenc", NULL, "audio/x-vorbis", NULL, NULL, NULL,
+    configure_audio_bitrate },
+  { AURICLE_CODEC_KIND_AUDIO, "flac", "FLAC", "flacenc", NULL, "audio/x-flac", NULL, NULL, NULL, NULL },
+
+  { AURICLE_CODEC_KIND_MUXER, "mp4", "MP4", "mp4mux", NULL, NULL, "mp4", NULL, NULL, NULL },
+  { AURICLE_CODEC_KIND_MUXER, "matroska", "Matroska", "matroskamux", NULL, NULL, "mkv", NULL, NULL, NULL },
+  { AURICLE_CODEC_KIND_MUXER, "webm", "WebM", "webmmux", NULL, NULL, "webm", NULL, NULL, NULL },
+  { AURICLE_CODEC_KIND_MUXER, "m4a", "M4A (audio only)", "mp4mux", NULL, NULL, "m4a", NULL, NULL, NULL, TRUE },
+  { AURICLE_CODEC_KIND_MUXER, "ogg", "Ogg (audio only)", "oggmux", NULL, NULL, "ogg", NULL, NULL, NULL, TRUE },
+};
+
+static gboolean
+element_exists (const char *name)
+{
+  g_autoptr(GstElementFactory) factory = gst_element_factory_find (name);
+  return factory != NULL;
+}
+
+/* Checks which of the codecs are installed. This only happens once, and gst_init must have been
+   called beforehand. */
+void
+auricle_codecs_probe (void)
+{
+  static gsize probed = 0;
+
+  if (g_once_init_enter (&probed))
+    {
+      for (gsize i = 0; i < G_N_ELEMENTS (codecs); i++)
+        {
+          AuricleCodec *codec = &codecs[i];
+          codec->available = element_exists (codec->element) &&
+                             (codec->parser == NULL || element_exists (codec->parser));
+
+          g_info ("%s (%s) is %savailable", codec->name, codec->element, codec->available ? "" : "not ");
+        }
+
+      g_once_init_leave (&probed, 1);
+    }
+}
+
+const AuricleCodec *
+auricle_codecs_find (AuricleCodecKind  kind,
+                     const char       *id)
+{
+  auricle_codecs_probe ();
+
+  for (gsize i = 0; i < G_N_ELEMENTS (codecs); i++)
+    {
+      if (codecs[i].kind == kind && g_strcmp0 (codecs[i].id, id) == 0)
+        return &codecs[i];
+    }
+
+  return NULL;
+}
+
+/* Returns the available codecs of the given kind, in order of preference. */
+GPtrArray *
+auricle_codecs_list (AuricleCodecKind kind)
+{
+  auricle_codecs_probe ();
+
+  GPtrArray *result = g_ptr_array_new ();
+  for (gsize i = 0; i < G_N_ELEMENTS (codecs); i++)
+    {
+      if (codecs[i].kind == kind && codecs[i].available)
+        g_ptr_array_add (result, &codecs[i]);
+    }
+
+  return result;
+}
+
+gboolean
+auricle_codec_can_mux (const AuricleCodec *muxer,
+                       const AuricleCodec *codec)
+{
+  g_return_val_if_fail (muxer->kind == AURICLE_CODEC_KIND_MUXER, FALSE);
+
+  g_autoptr(GstElementFactory) factory = gst_element_factory_find (muxer->element);
+  g_autoptr(GstCaps) caps = gst_caps_from_string (codec->caps);
+  return factory != NULL && gst_element_factory_can_sink_any_caps (factory, caps);
+}
+
+static void
+restrict_audio_caps (GstCaps *caps,
+                     guint    max_sample_rate,
+                     guint    max_channels)
+{
+  if (max_sample_rate != 0)
+    gst_caps_set_simple (caps, "rate", GST_TYPE_INT_RANGE, 1, (int) max_sample_rate, NULL);
+  if (max_channels != 0)
+    gst_caps_set_simple (caps, "channels", GST_TYPE_INT_RANGE, 1, (int) max_channels, NULL);
+}
+
+/* Returns raw audio plus every encoded audio format the muxer can take as is, whether or not its
+   encoder is installed. Encoded audio above the given limits (where non-zero) is left to be decoded,
+   so it can be reduced. */
+GstCaps *
+auricle_codecs_get_passthrough_caps (const AuricleCodec *muxer,
+                                     guint               max_sample_rate,
+                                     guint               max_channels)
+{
+  g_return_val_if_fail (muxer->kind == AURICLE_CODEC_KIND_MUXER, NULL);
+
+  GstCaps *result = gst_caps_from_string ("audio/x-raw");
+
+  g_autoptr(GstElementFactory) factory = gst_element_factory_find (muxer->element);
+  if (factory == NULL)
+    return result;
+
+  for (gsize i = 0; i < G_N_ELEMENTS (codecs); i++)
+    {
+      if (codecs[i].kind != AURICLE_CODEC_KIND_AUDIO)
+        continue;
+
+      g_autoptr(GstCaps) codec_caps = gst_caps_from_string (codecs[i].caps);
+      restrict_audio_caps (codec_caps, max_sample_rate, max_channels);
+      for (const GList *l = gst_element_factory_get_static_pad_templates (factory); l != NULL; l = l->next)
+        {
+          GstStaticPadTemplate *templ = l->data;
+          if (templ->direction != GST_PAD_SINK)
+            continue;
+
+          // Narrowing to the template picks up fields like AAC's stream-format, so anything needing
+          // conversion gets decoded and re-encoded instead.
+          g_autoptr(GstCaps) templ_caps = gst_static_pad_template_get_caps (templ);
+          GstCaps *accepted = gst_caps_intersect (codec_caps, templ_caps);
+          result = gst_caps_merge (result, accepted);
+        }
+    }
+
+  return gst_caps_simplify (result);
+}
+
+static const AuricleCodec *
+pick_codec (AuricleCodecKind    kind,
+            const char         *id,
+            const AuricleCodec *muxer)
+{
+  const AuricleCodec *preferred = auricle_codecs_find (kind, id);
+  if (preferred != NULL && preferred->available && auricle_codec_can_mux (muxer, preferred))
+    return preferred;
+
+  for (gsize i = 0; i < G_N_ELEMENTS (codecs); i++)
+    {
+      const AuricleCodec *codec = &codecs[i];
+      if (codec->kind == kind && codec->available && auricle_codec_can_mux (muxer, codec))
+        return codec;
+    }
+
+  return NULL;
+}
+
+/* Returns the audio-only counterpart of a muxer, i.e. the one writing the same format, or the muxer
+   itself if there is none. */
+static const AuricleCodec *
+find_audio_only_muxer (const AuricleCodec *muxer)
+{
+  if (muxer == NULL || muxer->audio_only)
+    return muxer;
+
+  for (gsize i = 0; i < G_N_ELEMENTS (codecs); i++)
+    {
+      if (codecs[i].kind == AURICLE_CODEC_KIND_MUXER && codecs[i].audio_only &&
+          g_str_equal (codecs[i].element, muxer->element))
+        return &codecs[i];
+    }
+
+  return muxer;
+}
+
+/* Picks the muxer and encoders to use, preferring the requested ones but falling back to whatever
+   is installed and can be muxed together. If video is NULL, no video encoder is needed, and the
+   audio-only counterpart of the requested muxer is preferred. */
+gboolean
+auricle_codecs_resolve (const char          *muxer_id,
+                        const char          *video_id,
+                        const char          *audio_id,
+                        const AuricleCodec **muxer,
+                        const AuricleCodec **video,
+                        const AuricleCodec **audio,
+                        GError             **error)
+{
+  const AuricleCodec *preferred_muxer = auricle_codecs_find (AURICLE_CODEC_KIND_MUXER, muxer_id);
+
+  // Try the requested muxer first, then the rest in order of preference.
+  for (gssize i = -1; i < (gssize) G_N_ELEMENTS (codecs); i++)
+    {
+      const AuricleCodec *candidate = i == -1 ? preferred_muxer : &codecs[i];
+      if (video == NULL)
+        candidate = find_audio_only_muxer (candidate);
+      if (candidate == NULL || candidate->kind != AURICLE_CODEC_KIND_MUXER || !candidate->available ||
+          (candidate->audio_only && video != NULL))
+        continue;
+
+      if (video != NULL && (*video = pick_codec (AURICLE_CODEC_KIND_VIDEO, video_id, candidate)) == NULL)
+        continue;
+
+      *audio = pick_codec (AURICLE_CODEC_KIND_AUDIO, audio_id, candidate);
+      if (*audio != NULL)
+        {
+          *muxer = candidate;
+          return TRUE;
+        }
+    }
+
+  g_set_error (error, GST_CORE_ERROR, GST_CORE_ERROR_MISSING_PLUGIN,
+               "No installed combination of video encoder, audio encoder, and muxer works together");
+  return FALSE;
+}
+
+static GstElement *
+make_element (const char  *name,
+              GError     **error)
+{
+  GstElement *element = gst_element_factory_make (name, NULL);
+  if (element == NULL)
+    g_set_error (error, GST_CORE_ERROR, GST_CORE_ERROR_MISSING_PLUGIN, "%s is not available", name);
+  return element;
+}
+
+/* Creates a bin that encodes raw audio or video into the codec's caps. */
+GstElement *
+auricle_codec_create_encoder (const AuricleCodec          *codec,
+                              const AuricleCodecSettings  *settings,
+                              GError                     **error)
+{
+  g_return_val_if_fail (codec->kind != AURICLE_CODEC_KIND_MUXER, NULL);
+
+  GstElement *enc = make_element (codec->element, error);
+  if (enc == NULL)
+    return NULL;
+
+  if (codec->configure != NULL)
+    codec->configure (enc, settings);
+  if (settings->preset != NULL && codec->preset_property != NULL)
+    set_arg (enc, codec->preset_property, settings->preset);
+
+  GstElement *bin = gst_bin_new (NULL);
+  gst_bin_add (GST_BIN (bin), enc);
+
+  GstElement *first = enc;
+  GstElement *last = enc;
+
+  if (codec->kind == AURICLE_CODEC_KIND_AUDIO)
+    {
+      /* The encoders differ in the sample formats and rates they accept. Any downmixing happens in
+         audioconvert, so the resampler has fewer channels to work through. Since the limits are
+         ranges, audio already below them is left alone. */
+      GstElement *conv = gst_element_factory_make ("audioconvert", NULL);
+      GstElement *resample = gst_element_factory_make ("audioresample", NULL);
+      GstElement *limit = gst_element_factory_make ("capsfilter", NULL);
+
+      g_autoptr(GstCaps) limit_caps = gst_caps_new_empty_simple ("audio/x-raw");
+      restrict_audio_caps (limit_caps, settings->max_sample_rate, settings->max_channels);
+      g_object_set (limit, "caps", limit_caps, NULL);
+      if (settings->max_sample_rate != 0)
+        set_uint (resample, "quality", settings->resample_quality);
+
+      gst_bin_add_many (GST_BIN (bin), conv, resample, limit, NULL);
+      gst_element_link_many (conv, resample, limit, enc, NULL);
+      first = conv;
+
+      if (settings->gain_db != 0)
+        {
+          GstElement *volume = gst_element_factory_make ("volume", NULL);
+          g_object_set (volume, "volume", pow (10.0, settings->gain_db / 20.0), NULL);
+          gst_bin_add (GST_BIN (bin), volume);
+          gst_element_link (volume, conv);
+          first = volume;
+        }
+    }
+
+  if (codec->parser != NULL)
+    {
+      GstElement *parser = gst_element_factory_make (codec->parser, NULL);
+      gst_bin_add (GST_BIN (bin), parser);
+      gst_element_link (last, parser);
+      last = parser;
+    }
+
+  GstElement *filter = gst_element_factory_make ("capsfilter", NULL);
+  g_autoptr(GstCaps) caps = gst_caps_from_string (codec->caps);
+  g_object_set (filter, "caps", caps, NULL);
+  gst_bin_add (GST_BIN (bin), filter);
+  gst_element_link (last, filter);
+
+  g_autoptr(GstPad) sink_pad = gst_element_get_static_pad (first, "sink");
+  g_autoptr(GstPad) src_pad = gst_element_get_static_pad (filter, "src");
+  gst_element_add_pad (bin, gst_ghost_pad_new ("sink", sink_pad));
+  gst_element_add_pad (bin, gst_ghost_pad_new ("src", src_pad));
+
+  return bin;
+}
+
+GstElement *
+auricle_codec_create_muxer (const AuricleCodec          *codec,
+                            const AuricleCodecSettings  *settings,
+                            GError                     **error)
+{
+  g_return_val_if_fail (codec->kind == AURICLE_CODEC_KIND_MUXER, NULL);
+
+  GstElement *mux = make_element (codec->element, error);
+  if (mux == NULL)
+    return NULL;
+
+  // Only mp4mux needs these, since the other formats are written as they go anyway.
+  if (settings->fragment_duration != 0)
+    set_uint (mux, "fragment-duration", settings->fragment_duration);
+  if (settings->streamable)
+    set_arg (mux, "streamable", "true");
+  if (settings->reserved_duration != 0)
+    {
+      g_autofree char *reserved_duration = g_strdup_printf ("%" G_GUINT64_FORMAT, settings->reserved_duration);
+      set_arg (mux, "reserved-max-duration", reserved_duration);
+    }
+
+  return mux;
+}
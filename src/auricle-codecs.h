@@ -0,0 +1,120 @@
+/* auricle-codecs.h
+ *
+ * Copyright 2019 Ryan Gonzalez <rymg19@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+typedef enum {
+  AURICLE_CODEC_KIND_VIDEO,
+  AURICLE_CODEC_KIND_AUDIO,
+  AURICLE_CODEC_KIND_MUXER,
+} AuricleCodecKind;
+
+typedef struct _AuricleCodecSettings AuricleCodecSettings;
+
+struct _AuricleCodecSettings
+{
+  // Audio bitrate, in kbps.
+  guint        bitrate;
+  // Audio above this sample rate or number of channels is reduced to it before encoding, unless 0.
+  guint        max_sample_rate;
+  guint        max_channels;
+  // The audioresample quality from 0 to 10, only used along with max_sample_rate.
+  guint        resample_quality;
+  // Gain applied to the audio before encoding, in dB.
+  double       gain_db;
+  // Maximum distance between video keyframes, in frames.
+  guint        keyframe_interval;
+  // Set when the video is mostly static, so the encoder can be tuned for it.
+  gboolean     still_image;
+  // Set when the video content changes every frame and encoding speed matters more than size.
+  gboolean     fast;
+  // One of the codec's presets, overriding the above speed tuning, or NULL.
+  const char  *preset;
+  // Muxers: the length of each fragment in milliseconds, for formats that are otherwise only
+  // playable once finished, or 0 to write them whole.
+  guint        fragment_duration;
+  // Muxers: the longest the output may get, to reserve room for the index at the start of the file
+  // instead of appending it, or 0 to append it.
+  GstClockTime reserved_duration;
+  // Muxers: set when the output can't be seeked back into, so everything has to be written in
+  // order. MP4 then also needs a fragment_duration.
+  gboolean     streamable;
+};
+
+typedef struct _AuricleCodec AuricleCodec;
+
+struct _AuricleCodec
+{
+  AuricleCodecKind    kind;
+  const char         *id;
+  const char         *name;
+  const char         *element;
+  // Encoders: an optional parser that fixes up the stream for the muxers.
+  const char         *parser;
+  // Encoders: the caps the muxer will be given.
+  const char         *caps;
+  // Muxers: the output file extension.
+  const char         *extension;
+  // Video encoders: the property selecting the speed preset, and the presets worth trying, fastest
+  // first.
+  const char         *preset_property;
+  const char * const *presets;
+
+  void (*configure) (GstElement                 *element,
+                     const AuricleCodecSettings *settings);
+
+  // Muxers: set for formats meant for audio alone, which are only used when there's no video.
+  gboolean audio_only;
+
+  gboolean available;
+};
+
+void auricle_codecs_probe (void);
+
+const AuricleCodec *auricle_codecs_find (AuricleCodecKind  kind,
+                                         const char       *id);
+GPtrArray          *auricle_codecs_list (AuricleCodecKind  kind);
+
+GstCaps *auricle_codecs_get_passthrough_caps (const AuricleCodec *muxer,
+                                              guint               max_sample_rate,
+                                              guint               max_channels);
+
+gboolean auricle_codecs_resolve (const char          *muxer_id,
+                                 const char          *video_id,
+                                 const char          *audio_id,
+                                 const AuricleCodec **muxer,
+                                 const AuricleCodec **video,
+                                 const AuricleCodec **audio,
+                                 GError             **error);
+
+gboolean    auricle_codec_can_mux          (const AuricleCodec          *muxer,
+                                            const AuricleCodec          *codec);
+GstElement *auricle_codec_create_encoder   (const AuricleCodec          *codec,
+                                            const AuricleCodecSettings  *settings,
+                                            GError                     **error);
+GstElement *auricle_codec_create_muxer     (const AuricleCodec          *codec,
+                                            const AuricleCodecSettings  *settings,
+                                            GError                     **error);
+
+G_END_DECLS
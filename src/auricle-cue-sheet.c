@@ -0,0 +1,323 @@
+/* auricle-cue-sheet.c
+ *
+ * Copyright 2019 Ryan Gonzalez <rymg19@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "auricle-cue-sheet.h"
+#include <gio/gio.h>
+#include <stdio.h>
+#include <string.h>
+
+/* CUE sheets describe an album as one or more audio files, with each track starting at an index into
+   its file. Times are given in minutes, seconds, and CD frames of 1/75th of a second. */
+
+#define CUE_FRAMES_PER_SECOND 75
+
+void
+auricle_cue_track_free (AuricleCueTrack *track)
+{
+  g_free (track->path);
+  g_clear_pointer (&track->template_vars, g_hash_table_unref);
+  g_free (track);
+}
+
+static void
+set_template_var (GHashTable *template_vars,
+                  const char *name,
+                  const char *value)
+{
+  char **strv = g_new0 (char *, 2);
+  strv[0] = g_strdup (value);
+  g_hash_table_replace (template_vars, g_strdup (name), strv);
+}
+
+/* Splits a line into its command and arguments, with double quotes grouping words together. */
+static char **
+split_cue_line (const char *line)
+{
+  g_autoptr(GPtrArray) words = g_ptr_array_new_with_free_func (g_free);
+  const char *p = line;
+
+  for (;;)
+    {
+      while (g_ascii_isspace (*p))
+        p++;
+      if (*p == '\0')
+        break;
+
+      const char *start;
+      if (*p == '"')
+        {
+          start = ++p;
+          while (*p != '\0' && *p != '"')
+            p++;
+          g_ptr_array_add (words, g_strndup (start, p - start));
+          if (*p == '"')
+            p++;
+        }
+      else
+        {
+          start = p;
+          while (*p != '\0' && !g_ascii_isspace (*p))
+            p++;
+          g_ptr_array_add (words, g_strndup (start, p - start));
+        }
+    }
+
+  g_ptr_array_add (words, NULL);
+  return (char **) g_ptr_array_free (g_steal_pointer (&words), FALSE);
+}
+
+static gboolean
+parse_cue_time (const char   *str,
+                GstClockTime *time)
+{
+  guint minutes, seconds, frames;
+  char extra;
+
+  if (sscanf (str, "%u:%u:%u%c", &minutes, &seconds, &frames, &extra) != 3 ||
+      seconds >= 60 || frames >= CUE_FRAMES_PER_SECOND)
+    return FALSE;
+
+  guint64 total_frames = ((guint64) minutes * 60 + seconds) * CUE_FRAMES_PER_SECOND + frames;
+  *time = gst_util_uint64_scale (total_frames, GST_SECOND, CUE_FRAMES_PER_SECOND);
+  return TRUE;
+}
+
+// Most rippers put the fields the format lacks into comments, e.g. REM GENRE Rock.
+static const char *
+tag_for_remark (const char *field)
+{
+  if (g_ascii_strcasecmp (field, "GENRE") == 0)
+    return GST_TAG_GENRE;
+  else if (g_ascii_strcasecmp (field, "DATE") == 0)
+    return GST_TAG_DATE;
+  else if (g_ascii_strcasecmp (field, "COMMENT") == 0)
+    return GST_TAG_COMMENT;
+  else
+    return NULL;
+}
+
+// The same commands describe the album before the first track, and the track after.
+static const char *
+tag_for_command (const char *command,
+                 gboolean    in_track)
+{
+  if (g_ascii_strcasecmp (command, "TITLE") == 0)
+    return in_track ? GST_TAG_TITLE : GST_TAG_ALBUM;
+  else if (g_ascii_strcasecmp (command, "PERFORMER") == 0)
+    return in_track ? GST_TAG_ARTIST : GST_TAG_ALBUM_ARTIST;
+  else if (g_ascii_strcasecmp (command, "SONGWRITER") == 0)
+    return GST_TAG_COMPOSER;
+  else if (g_ascii_strcasecmp (command, "ISRC") == 0)
+    return in_track ? GST_TAG_ISRC : NULL;
+  else
+    return NULL;
+}
+
+static void
+auricle_cue_track_finish (AuricleCueTrack *track,
+                          GHashTable      *album_vars,
+                          const char      *album_name,
+                          guint            n_tracks)
+{
+  GHashTableIter iter;
+  gpointer key, value;
+  g_hash_table_iter_init (&iter, album_vars);
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    if (!g_hash_table_contains (track->template_vars, key))
+      g_hash_table_replace (track->template_vars, g_strdup (key), g_strdupv (value));
+
+  char **album_artist = g_hash_table_lookup (album_vars, GST_TAG_ALBUM_ARTIST);
+  if (album_artist != NULL && !g_hash_table_contains (track->template_vars, GST_TAG_ARTIST))
+    g_hash_table_replace (track->template_vars, g_strdup (GST_TAG_ARTIST), g_strdupv (album_artist));
+
+  g_autofree char *track_count = g_strdup_printf ("%u", n_tracks);
+  set_template_var (track->template_vars, GST_TAG_TRACK_COUNT, track_count);
+
+  g_autofree char *basename = g_path_get_basename (track->path);
+  set_template_var (track->template_vars, "path", track->path);
+  set_template_var (track->template_vars, "basename", basename);
+
+  // Every track shares the audio file, so its name can't be the default output name.
+  guint number = g_ascii_strtoull (*(char **) g_hash_table_lookup (track->template_vars, GST_TAG_TRACK_NUMBER),
+                                   NULL, 10);
+  char **title = g_hash_table_lookup (track->template_vars, GST_TAG_TITLE);
+  g_autofree char *name = title != NULL ? g_strdup_printf ("%02u - %s", number, title[0])
+                                        : g_strdup_printf ("%s - %02u", album_name, number);
+  set_template_var (track->template_vars, "name", name);
+}
+
+/* Reads the audio tracks out of a CUE sheet, in order. Returns NULL if the sheet can't be read or
+   has no tracks. */
+GPtrArray *
+auricle_cue_sheet_load (const char  *path,
+                        GError     **error)
+{
+  g_autofree char *contents = NULL;
+  gsize length;
+  if (!g_file_get_contents (path, &contents, &length, error))
+    return NULL;
+
+  // Older rippers write their sheets in the legacy Windows codepage.
+  if (!g_utf8_validate (contents, length, NULL))
+    {
+      char *converted = g_convert (contents, length, "UTF-8", "WINDOWS-1252", NULL, NULL, error);
+      if (converted == NULL)
+        return NULL;
+
+      g_free (contents);
+      contents = converted;
+    }
+
+  const char *text = contents;
+  if (g_str_has_prefix (text, "\xef\xbb\xbf"))
+    text += 3;
+
+  g_autofree char *directory = g_path_get_dirname (path);
+  g_autofree char *file_path = NULL;
+  g_autoptr(GHashTable) album_vars = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                                            (GDestroyNotify) g_strfreev);
+  g_autoptr(GPtrArray) tracks = g_ptr_array_new_with_free_func ((GDestroyNotify) auricle_cue_track_free);
+  AuricleCueTrack *track = NULL;
+  // Set while skipping the lines of a data track.
+  gboolean skipping = FALSE;
+
+  g_auto(GStrv) lines = g_strsplit_set (text, "\r\n", -1);
+  for (guint i = 0; lines[i] != NULL; i++)
+    {
+      g_auto(GStrv) words = split_cue_line (lines[i]);
+      if (g_strv_length (words) < 2)
+        continue;
+
+      const char *command = words[0];
+      const char *arg = words[1];
+
+      if (g_ascii_strcasecmp (command, "FILE") == 0)
+        {
+          g_free (file_path);
+          file_path = g_path_is_absolute (arg) ? g_strdup (arg) : g_build_filename (directory, arg, NULL);
+          track = NULL;
+          skipping = FALSE;
+        }
+      else if (g_ascii_strcasecmp (command, "TRACK") == 0)
+        {
+          if (file_path == NULL)
+            {
+              g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA, "Track on line %u has no file", i + 1);
+              return NULL;
+            }
+
+          // Mixed mode discs can have data tracks, which there's nothing to render from.
+          track = NULL;
+          skipping = words[2] != NULL && g_ascii_strcasecmp (words[2], "AUDIO") != 0;
+          if (skipping)
+            continue;
+
+          track = g_new0 (AuricleCueTrack, 1);
+          track->path = g_strdup (file_path);
+          track->start = GST_CLOCK_TIME_NONE;
+          track->end = GST_CLOCK_TIME_NONE;
+          track->template_vars = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_strfreev);
+
+          g_autofree char *number = g_strdup_printf ("%u", (guint) g_ascii_strtoull (arg, NULL, 10));
+          set_template_var (track->template_vars, GST_TAG_TRACK_NUMBER, number);
+          g_ptr_array_add (tracks, track);
+        }
+      else if (skipping)
+        continue;
+      else if (g_ascii_strcasecmp (command, "INDEX") == 0)
+        {
+          // Index 0 marks the pregap, which stays with the track before, as on the original disc.
+          if (track == NULL || words[2] == NULL || g_ascii_strtoull (arg, NULL, 10) != 1)
+            continue;
+
+          if (!parse_cue_time (words[2], &track->start))
+            {
+              g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA, "Invalid index time %s on line %u",
+                           words[2], i + 1);
+              return NULL;
+            }
+        }
+      else
+        {
+          GHashTable *template_vars = track != NULL ? track->template_vars : album_vars;
+
+          if (g_ascii_strcasecmp (command, "REM") == 0)
+            {
+              const char *tag = tag_for_remark (arg);
+              if (tag != NULL && words[2] != NULL)
+                {
+                  g_autofree char *value = g_strjoinv (" ", words + 2);
+                  set_template_var (template_vars, tag, value);
+                }
+            }
+          else
+            {
+              const char *tag = tag_for_command (command, track != NULL);
+              if (tag != NULL)
+                set_template_var (template_vars, tag, arg);
+            }
+        }
+    }
+
+  if (tracks->len == 0)
+    {
+      g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA, "No audio tracks found");
+      return NULL;
+    }
+
+  for (guint i = 0; i < tracks->len; i++)
+    {
+      track = g_ptr_array_index (tracks, i);
+      if (!GST_CLOCK_TIME_IS_VALID (track->start))
+        {
+          g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA, "Track %u has no start index", i + 1);
+          return NULL;
+        }
+    }
+
+  char **album = g_hash_table_lookup (album_vars, GST_TAG_ALBUM);
+  g_autofree char *basename = g_path_get_basename (path);
+  const char *extension = strrchr (basename, '.');
+  g_autofree char *album_name = album != NULL ? g_strdup (album[0])
+                              : g_strndup (basename, extension != NULL ? extension - basename : strlen (basename));
+
+  for (guint i = 0; i < tracks->len; i++)
+    {
+      track = g_ptr_array_index (tracks, i);
+      AuricleCueTrack *next = i + 1 < tracks->len ? g_ptr_array_index (tracks, i + 1) : NULL;
+
+      // A track runs up to the next one in the same file, or otherwise to the end of its own.
+      if (next != NULL && g_strcmp0 (next->path, track->path) == 0)
+        {
+          if (next->start <= track->start)
+            {
+              g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA, "Track %u doesn't start after track %u",
+                           i + 2, i + 1);
+              return NULL;
+            }
+
+          track->end = next->start;
+        }
+
+      auricle_cue_track_finish (track, album_vars, album_name, tracks->len);
+    }
+
+  return g_steal_pointer (&tracks);
+}
@@ -0,0 +1,46 @@
+/* auricle-cue-sheet.h
+ *
+ * Copyright 2019 Ryan Gonzalez <rymg19@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <gst/gst.h>
+
+G_BEGIN_DECLS
+
+typedef struct _AuricleCueTrack AuricleCueTrack;
+
+struct _AuricleCueTrack
+{
+  char         *path;
+  GstClockTime  start;
+  // GST_CLOCK_TIME_NONE for the last track of a file, which runs to its end.
+  GstClockTime  end;
+  // Named after the GStreamer tags, so the same filename templates work for both.
+  GHashTable   *template_vars;
+};
+
+void auricle_cue_track_free (AuricleCueTrack *track);
+
+GPtrArray *auricle_cue_sheet_load (const char  *path,
+                                   GError     **error);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (AuricleCueTrack, auricle_cue_track_free)
+
+G_END_DECLS
@@ -0,0 +1,805 @@
+/* auricle-file-sink.c
+ *
+ * Copyright 2019 Ryan Gonzalez <rymg19@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#define _GNU_SOURCE
+
+#include "auricle-config.h"
+#include "auricle-file-sink.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <glib/gstdio.h>
+#include <signal.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#ifdef HAVE_LIBURING
+#include <liburing.h>
+#endif
+
+/* A replacement for filesink that keeps the streaming threads off the disk. Buffers are queued
+   along with their file offset, and a writer thread takes everything queued so far at once,
+   writing each contiguous run with a single call (or, with io_uring, submitting all of them
+   together). The muxers seek back to patch headers, which is just another run at an earlier
+   offset. The file's extents are preallocated from an estimate of the output size, so many jobs
+   writing side by side don't interleave their blocks on disk.
+
+   The output is written under a temporary name and only moved into place once it's complete, so
+   nothing picking up finished files ever sees a half-written one. If rendering crashes, the
+   partial file is left behind under the temporary name. When it's stopped early, it's deleted,
+   unless the muxer writes fragments that stay playable on their own, in which case it's kept.
+
+   The SHA-256 of the file can be computed along the way, by the writer thread. That only works as
+   long as the file is written from start to end, though, and most muxers go back to patch their
+   headers at the very end. In that case, the file is hashed again once it's finished, while it's
+   still in the page cache.
+
+   The sink can also write to a pipe or other descriptor that can't seek, for the muxers that are
+   set up to stream. Everything then has to come in order, and the descriptor is closed at EOS. */
+
+// The streaming thread only waits for the writer once this much is queued.
+#define MAX_PENDING_BYTES (8 * 1024 * 1024)
+#define MAX_RUN_BUFFERS 64
+#define RING_ENTRIES 32
+#define CHECKSUM_READ_SIZE (1024 * 1024)
+
+typedef struct _AuricleFileSinkWrite AuricleFileSinkWrite;
+
+struct _AuricleFileSinkWrite
+{
+  GstBuffer  *buffer;
+  GstMapInfo  map;
+  guint64     offset;
+};
+
+struct _AuricleFileSink
+{
+  GstBaseSink parent_instance;
+
+  char     *location;
+  char     *temp_location;
+  guint64   preallocate_size;
+  int       fd;
+  gboolean  streaming;
+  gboolean  keep_partial;
+  gboolean  finished;
+
+  // Only touched by the streaming thread.
+  guint64 position;
+
+  // Everything below is guarded by the mutex, except end, which belongs to the writer thread
+  // while it runs.
+  GMutex    lock;
+  GCond     cond;
+  GQueue    pending;
+  gsize     pending_bytes;
+  gboolean  writing;
+  gboolean  stopping;
+  gboolean  flushing;
+  int       write_errno;
+  guint64   end;
+  guint64   stream_end;
+  GThread  *writer;
+
+  // Owned by the writer thread while it runs, like end.
+  GChecksum *checksum;
+  guint64    checksum_end;
+  gboolean   checksum_in_order;
+  char      *checksum_string;
+
+#ifdef HAVE_LIBURING
+  struct io_uring ring;
+  gboolean        has_ring;
+#endif
+};
+
+G_DEFINE_TYPE (AuricleFileSink, auricle_file_sink, GST_TYPE_BASE_SINK)
+
+static GstStaticPadTemplate sink_template = GST_STATIC_PAD_TEMPLATE ("sink",
+                                                                     GST_PAD_SINK,
+                                                                     GST_PAD_ALWAYS,
+                                                                     GST_STATIC_CAPS_ANY);
+
+/* The file is preallocated to the given size in bytes, unless 0. If checksum is set, the file's
+   SHA-256 is computed while it's written. */
+GstElement *
+auricle_file_sink_new (const char *location,
+                       guint64     preallocate_size,
+                       gboolean    checksum)
+{
+  AuricleFileSink *self = g_object_new (AURICLE_TYPE_FILE_SINK, NULL);
+  self->location = g_strdup (location);
+  self->preallocate_size = preallocate_size;
+  if (checksum)
+    self->checksum = g_checksum_new (G_CHECKSUM_SHA256);
+  return GST_ELEMENT (self);
+}
+
+/* Creates a sink writing to the given descriptor, which it takes over, in order. The name is only
+   used in messages. */
+GstElement *
+auricle_file_sink_new_for_fd (int         fd,
+                              const char *name,
+                              gboolean    checksum)
+{
+  AuricleFileSink *self = AURICLE_FILE_SINK (auricle_file_sink_new (name, 0, checksum));
+  self->fd = fd;
+  self->streaming = TRUE;
+  return GST_ELEMENT (self);
+}
+
+/* Returns the hex SHA-256 of the file once it's been moved into place, or NULL. */
+const char *
+auricle_file_sink_get_checksum (AuricleFileSink *self)
+{
+  return self->checksum_string;
+}
+
+/* Sets whether a file that wasn't finished is kept under its temporary name when the sink stops,
+   instead of being deleted. */
+void
+auricle_file_sink_set_keep_partial (AuricleFileSink *self,
+                                    gboolean         keep_partial)
+{
+  self->keep_partial = keep_partial;
+}
+
+/* Returns whether everything was written and the file moved into place. */
+gboolean
+auricle_file_sink_is_finished (AuricleFileSink *self)
+{
+  return self->finished;
+}
+
+static void
+auricle_file_sink_write_free (AuricleFileSinkWrite *write)
+{
+  gst_buffer_unmap (write->buffer, &write->map);
+  gst_buffer_unref (write->buffer);
+  g_free (write);
+}
+
+/* Writes out the whole run synchronously, picking up after short writes. A negative offset writes
+   to a stream instead. Returns 0 or an errno. */
+static int
+write_run (int           fd,
+           struct iovec *iov,
+           int           n_iov,
+           gint64        offset)
+{
+  while (n_iov > 0)
+    {
+      ssize_t written = offset >= 0 ? pwritev (fd, iov, n_iov, offset) : writev (fd, iov, n_iov);
+      if (written < 0)
+        {
+          if (errno == EINTR)
+            continue;
+          return errno;
+        }
+
+      if (offset >= 0)
+        offset += written;
+      while (n_iov > 0 && (size_t) written >= iov->iov_len)
+        {
+          written -= iov->iov_len;
+          iov++;
+          n_iov--;
+        }
+
+      if (n_iov > 0)
+        {
+          iov->iov_base = (guint8 *) iov->iov_base + written;
+          iov->iov_len -= written;
+        }
+    }
+
+  return 0;
+}
+
+typedef struct _AuricleFileSinkRun AuricleFileSinkRun;
+
+struct _AuricleFileSinkRun
+{
+  struct iovec iov[MAX_RUN_BUFFERS];
+  int          n_iov;
+  guint64      offset;
+  gsize        size;
+};
+
+/* Splits the batch into runs of buffers that follow each other in the file. */
+static GArray *
+collect_runs (GQueue *batch)
+{
+  GArray *runs = g_array_new (FALSE, FALSE, sizeof (AuricleFileSinkRun));
+  AuricleFileSinkRun *run = NULL;
+
+  for (GList *l = batch->head; l != NULL; l = l->next)
+    {
+      AuricleFileSinkWrite *write = l->data;
+      if (write->map.size == 0)
+        continue;
+
+      if (run == NULL || run->n_iov == MAX_RUN_BUFFERS || run->offset + run->size != write->offset)
+        {
+          g_array_set_size (runs, runs->len + 1);
+          run = &g_array_index (runs, AuricleFileSinkRun, runs->len - 1);
+          run->n_iov = 0;
+          run->offset = write->offset;
+          run->size = 0;
+        }
+
+      run->iov[run->n_iov].iov_base = write->map.data;
+      run->iov[run->n_iov].iov_len = write->map.size;
+      run->n_iov++;
+      run->size += write->map.size;
+    }
+
+  return runs;
+}
+
+#ifdef HAVE_LIBURING
+/* Submits every run with a single call. They're linked so they still land in order, since a muxer
+   patching a header may overwrite a placeholder from earlier in the same batch. Anything the ring
+   doesn't finish, e.g. after a short write cancels the rest of the chain, is written out
+   synchronously. */
+static int
+write_runs_ring (AuricleFileSink *self,
+                 GArray          *runs)
+{
+  // Runs that don't fit into the ring are left to the fallback, which comes after the rest.
+  guint submitted = MIN (runs->len, RING_ENTRIES);
+  for (guint i = 0; i < submitted; i++)
+    {
+      AuricleFileSinkRun *run = &g_array_index (runs, AuricleFileSinkRun, i);
+      struct io_uring_sqe *sqe = io_uring_get_sqe (&self->ring);
+
+      io_uring_prep_writev (sqe, self->fd, run->iov, run->n_iov, run->offset);
+      io_uring_sqe_set_data (sqe, run);
+      if (i != submitted - 1)
+        io_uring_sqe_set_flags (sqe, IOSQE_IO_LINK);
+    }
+
+  int ret = io_uring_submit_and_wait (&self->ring, submitted);
+  if (ret < 0)
+    return -ret;
+
+  int error = 0;
+  for (guint i = 0; i < submitted; i++)
+    {
+      struct io_uring_cqe *cqe;
+      ret = io_uring_wait_cqe (&self->ring, &cqe);
+      if (ret < 0)
+        return -ret;
+
+      AuricleFileSinkRun *run = io_uring_cqe_get_data (cqe);
+      int res = cqe->res;
+      io_uring_cqe_seen (&self->ring, cqe);
+
+      if (res == -ECANCELED)
+        continue;
+      else if (res < 0 && error == 0)
+        error = -res;
+      else if (res >= 0)
+        {
+          // Mark what was written so the fallback below only finishes the rest.
+          run->offset += res;
+          run->size -= res;
+        }
+    }
+
+  for (guint i = 0; i < runs->len && error == 0; i++)
+    {
+      AuricleFileSinkRun *run = &g_array_index (runs, AuricleFileSinkRun, i);
+      if (run->size == 0)
+        continue;
+
+      // Skip over whatever the ring did write.
+      gsize done = 0;
+      for (int j = 0; j < run->n_iov; j++)
+        done += run->iov[j].iov_len;
+      done -= run->size;
+
+      struct iovec *iov = run->iov;
+      int n_iov = run->n_iov;
+      while (done > 0 && done >= iov->iov_len)
+        {
+          done -= iov->iov_len;
+          iov++;
+          n_iov--;
+        }
+      if (done > 0)
+        {
+          iov->iov_base = (guint8 *) iov->iov_base + done;
+          iov->iov_len -= done;
+        }
+
+      error = write_run (self->fd, iov, n_iov, run->offset);
+    }
+
+  return error;
+}
+#endif
+
+static int
+auricle_file_sink_write_batch (AuricleFileSink *self,
+                               GQueue          *batch)
+{
+  g_autoptr(GArray) runs = collect_runs (batch);
+  int error = 0;
+
+  for (guint i = 0; i < runs->len; i++)
+    {
+      AuricleFileSinkRun *run = &g_array_index (runs, AuricleFileSinkRun, i);
+      self->end = MAX (self->end, run->offset + run->size);
+
+      if (self->checksum == NULL || !self->checksum_in_order)
+        continue;
+
+      // Anything but the next bytes of the file means it has to be hashed again at the end.
+      if (run->offset != self->checksum_end)
+        {
+          self->checksum_in_order = FALSE;
+          continue;
+        }
+
+      for (int j = 0; j < run->n_iov; j++)
+        g_checksum_update (self->checksum, run->iov[j].iov_base, run->iov[j].iov_len);
+      self->checksum_end += run->size;
+    }
+
+#ifdef HAVE_LIBURING
+  if (self->has_ring)
+    return write_runs_ring (self, runs);
+#endif
+
+  for (guint i = 0; i < runs->len && error == 0; i++)
+    {
+      AuricleFileSinkRun *run = &g_array_index (runs, AuricleFileSinkRun, i);
+      if (self->streaming && run->offset != self->stream_end)
+        return ESPIPE;
+
+      error = write_run (self->fd, run->iov, run->n_iov, self->streaming ? -1 : (gint64) run->offset);
+      self->stream_end += run->size;
+    }
+
+  return error;
+}
+
+static gpointer
+auricle_file_sink_writer (gpointer udata)
+{
+  AuricleFileSink *self = AURICLE_FILE_SINK (udata);
+
+  // If whatever reads a stream goes away, the write should fail with EPIPE instead of the signal
+  // killing the whole process.
+  if (self->streaming)
+    {
+      sigset_t signals;
+      sigemptyset (&signals);
+      sigaddset (&signals, SIGPIPE);
+      pthread_sigmask (SIG_BLOCK, &signals, NULL);
+    }
+
+  g_mutex_lock (&self->lock);
+
+  for (;;)
+    {
+      while (g_queue_is_empty (&self->pending) && !self->stopping)
+        g_cond_wait (&self->cond, &self->lock);
+
+      if (g_queue_is_empty (&self->pending))
+        break;
+
+      GQueue batch = self->pending;
+      g_queue_init (&self->pending);
+      gsize batch_bytes = self->pending_bytes;
+      self->pending_bytes = 0;
+      self->writing = TRUE;
+      gboolean failed = self->write_errno != 0;
+      g_mutex_unlock (&self->lock);
+
+      // Once a write failed, the rest is only thrown away.
+      int error = failed ? 0 : auricle_file_sink_write_batch (self, &batch);
+      g_queue_clear_full (&batch, (GDestroyNotify) auricle_file_sink_write_free);
+      g_debug ("Wrote %" G_GSIZE_FORMAT " bytes to %s", batch_bytes, self->location);
+
+      g_mutex_lock (&self->lock);
+      if (error != 0 && self->write_errno == 0)
+        self->write_errno = error;
+      self->writing = FALSE;
+      g_cond_broadcast (&self->cond);
+    }
+
+  g_mutex_unlock (&self->lock);
+  return NULL;
+}
+
+static void
+auricle_file_sink_post_write_error (AuricleFileSink *self,
+                                    int              error)
+{
+  GST_ELEMENT_ERROR (self, RESOURCE, WRITE, ("Could not write to file \"%s\".", self->location),
+                     ("%s", g_strerror (error)));
+}
+
+/* Hashes the finished file from the start. Returns 0 or an errno. */
+static int
+auricle_file_sink_rehash (AuricleFileSink *self)
+{
+  g_checksum_reset (self->checksum);
+  g_autofree guint8 *block = g_malloc (CHECKSUM_READ_SIZE);
+
+  for (guint64 offset = 0; offset < self->end;)
+    {
+      ssize_t n_read = pread (self->fd, block, MIN (CHECKSUM_READ_SIZE, self->end - offset), offset);
+      if (n_read < 0 && errno == EINTR)
+        continue;
+      else if (n_read < 0)
+        return errno;
+      else if (n_read == 0)
+        return EIO;
+
+      g_checksum_update (self->checksum, block, n_read);
+      offset += n_read;
+    }
+
+  return 0;
+}
+
+/* Moves the finished file into place. Its contents are flushed to disk first, so the rename can't
+   outlive them in a crash. A stream is closed instead, so whatever reads it sees its end. Returns 0
+   or an errno. */
+static int
+auricle_file_sink_finish (AuricleFileSink *self)
+{
+  if (self->checksum != NULL)
+    {
+      if (!self->checksum_in_order || self->checksum_end != self->end)
+        {
+          g_debug ("%s wasn't written in order, hashing it again", self->location);
+          int error = auricle_file_sink_rehash (self);
+          if (error != 0)
+            return error;
+        }
+
+      g_free (self->checksum_string);
+      self->checksum_string = g_strdup (g_checksum_get_string (self->checksum));
+    }
+
+  if (self->streaming)
+    {
+      self->finished = TRUE;
+      int fd = self->fd;
+      self->fd = -1;
+      return g_close (fd, NULL) ? 0 : errno;
+    }
+
+  // Gives back the preallocated space past the end.
+  if (self->preallocate_size != 0 && ftruncate (self->fd, self->end) != 0)
+    g_debug ("Cannot truncate %s: %s", self->temp_location, g_strerror (errno));
+
+  if (fdatasync (self->fd) != 0 || g_rename (self->temp_location, self->location) != 0)
+    return errno;
+
+  self->finished = TRUE;
+  return 0;
+}
+
+/* Waits for everything queued to be written. Returns 0, the errno of the first failed write, or
+   ECANCELED if the sink started flushing first. */
+static int
+auricle_file_sink_drain (AuricleFileSink *self)
+{
+  g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&self->lock);
+
+  while ((!g_queue_is_empty (&self->pending) || self->writing) && self->write_errno == 0 && !self->flushing)
+    g_cond_wait (&self->cond, &self->lock);
+
+  if (self->write_errno == 0 && self->flushing)
+    return ECANCELED;
+  return self->write_errno;
+}
+
+static void
+auricle_file_sink_start_writer (AuricleFileSink *self)
+{
+  self->position = 0;
+  self->end = 0;
+  self->checksum_end = 0;
+  self->checksum_in_order = TRUE;
+  g_clear_pointer (&self->checksum_string, g_free);
+  if (self->checksum != NULL)
+    g_checksum_reset (self->checksum);
+  self->stopping = FALSE;
+  self->flushing = FALSE;
+  self->write_errno = 0;
+  self->stream_end = 0;
+  self->writer = g_thread_new ("auricle-file-sink", auricle_file_sink_writer, self);
+}
+
+static gboolean
+auricle_file_sink_start (GstBaseSink *sink)
+{
+  AuricleFileSink *self = AURICLE_FILE_SINK (sink);
+
+  self->finished = FALSE;
+  if (self->streaming)
+    {
+      if (self->fd == -1)
+        {
+          GST_ELEMENT_ERROR (self, RESOURCE, OPEN_WRITE, ("\"%s\" was already written.", self->location), (NULL));
+          return FALSE;
+        }
+
+      auricle_file_sink_start_writer (self);
+      return TRUE;
+    }
+
+  g_free (self->temp_location);
+  self->temp_location = g_strconcat (self->location, ".part", NULL);
+
+  self->fd = g_open (self->temp_location, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+  if (self->fd == -1)
+    {
+      GST_ELEMENT_ERROR (self, RESOURCE, OPEN_WRITE, ("Could not open file \"%s\" for writing.",
+                                                      self->temp_location),
+                         ("%s", g_strerror (errno)));
+      return FALSE;
+    }
+
+  // The size isn't changed, so the muxers still see an empty file, and anything past the
+  // actual end is given back when the file is truncated once done.
+  if (self->preallocate_size != 0 && fallocate (self->fd, FALLOC_FL_KEEP_SIZE, 0, self->preallocate_size) != 0)
+    g_debug ("Cannot preallocate %s: %s", self->location, g_strerror (errno));
+
+#ifdef HAVE_LIBURING
+  int ret = io_uring_queue_init (RING_ENTRIES, &self->ring, 0);
+  self->has_ring = ret == 0;
+  if (!self->has_ring)
+    g_debug ("io_uring is not available, writing %s directly: %s", self->location, g_strerror (-ret));
+#endif
+
+  auricle_file_sink_start_writer (self);
+  return TRUE;
+}
+
+static gboolean
+auricle_file_sink_stop (GstBaseSink *sink)
+{
+  AuricleFileSink *self = AURICLE_FILE_SINK (sink);
+
+  g_mutex_lock (&self->lock);
+  self->stopping = TRUE;
+  g_cond_broadcast (&self->cond);
+  g_mutex_unlock (&self->lock);
+
+  g_clear_pointer (&self->writer, g_thread_join);
+
+#ifdef HAVE_LIBURING
+  if (self->has_ring)
+    io_uring_queue_exit (&self->ring);
+  self->has_ring = FALSE;
+#endif
+
+  // Whatever didn't make it to the end is thrown away, unless it's worth keeping. A stream is just
+  // cut off.
+  gboolean keep = !self->finished && !self->streaming && self->keep_partial && self->fd != -1;
+  if (keep && self->preallocate_size != 0 && ftruncate (self->fd, self->end) != 0)
+    g_debug ("Cannot truncate %s: %s", self->temp_location, g_strerror (errno));
+
+  if (self->fd != -1)
+    g_close (self->fd, NULL);
+  self->fd = -1;
+  if (keep)
+    g_info ("Keeping the partial output in %s", self->temp_location);
+  else if (!self->finished && !self->streaming)
+    g_unlink (self->temp_location);
+
+  return TRUE;
+}
+
+static gboolean
+auricle_file_sink_unlock (GstBaseSink *sink)
+{
+  AuricleFileSink *self = AURICLE_FILE_SINK (sink);
+
+  g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&self->lock);
+  self->flushing = TRUE;
+  g_cond_broadcast (&self->cond);
+  return TRUE;
+}
+
+static gboolean
+auricle_file_sink_unlock_stop (GstBaseSink *sink)
+{
+  AuricleFileSink *self = AURICLE_FILE_SINK (sink);
+
+  g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&self->lock);
+  self->flushing = FALSE;
+  return TRUE;
+}
+
+static GstFlowReturn
+auricle_file_sink_render (GstBaseSink *sink,
+                          GstBuffer   *buffer)
+{
+  AuricleFileSink *self = AURICLE_FILE_SINK (sink);
+
+  AuricleFileSinkWrite *write = g_new0 (AuricleFileSinkWrite, 1);
+  if (!gst_buffer_map (buffer, &write->map, GST_MAP_READ))
+    {
+      g_free (write);
+      GST_ELEMENT_ERROR (self, RESOURCE, WRITE, ("Could not write to file \"%s\".", self->location),
+                         ("Failed to map the buffer"));
+      return GST_FLOW_ERROR;
+    }
+
+  write->buffer = gst_buffer_ref (buffer);
+  write->offset = self->position;
+
+  g_mutex_lock (&self->lock);
+
+  while (self->pending_bytes >= MAX_PENDING_BYTES && self->write_errno == 0 && !self->flushing)
+    g_cond_wait (&self->cond, &self->lock);
+
+  int error = self->write_errno;
+  gboolean flushing = self->flushing;
+  if (error == 0 && !flushing)
+    {
+      g_queue_push_tail (&self->pending, write);
+      self->pending_bytes += write->map.size;
+      g_cond_broadcast (&self->cond);
+    }
+
+  g_mutex_unlock (&self->lock);
+
+  if (error != 0 || flushing)
+    {
+      auricle_file_sink_write_free (write);
+      if (flushing)
+        return GST_FLOW_FLUSHING;
+
+      auricle_file_sink_post_write_error (self, error);
+      return GST_FLOW_ERROR;
+    }
+
+  self->position += gst_buffer_get_size (buffer);
+  return GST_FLOW_OK;
+}
+
+static gboolean
+auricle_file_sink_event (GstBaseSink *sink,
+                         GstEvent    *event)
+{
+  AuricleFileSink *self = AURICLE_FILE_SINK (sink);
+
+  switch (GST_EVENT_TYPE (event))
+    {
+    case GST_EVENT_SEGMENT:
+      {
+        // The muxers seek by sending a new byte segment starting at the offset to write to.
+        const GstSegment *segment;
+        gst_event_parse_segment (event, &segment);
+        if (segment->format == GST_FORMAT_BYTES)
+          self->position = segment->start;
+        break;
+      }
+    case GST_EVENT_EOS:
+      {
+        // The EOS only gets posted once everything is actually in the file.
+        int error = auricle_file_sink_drain (self);
+        if (error == 0)
+          error = auricle_file_sink_finish (self);
+        if (error != 0)
+          {
+            if (error != ECANCELED)
+              auricle_file_sink_post_write_error (self, error);
+            gst_event_unref (event);
+            return FALSE;
+          }
+        break;
+      }
+    default:
+      break;
+    }
+
+  return GST_BASE_SINK_CLASS (auricle_file_sink_parent_class)->event (sink, event);
+}
+
+static gboolean
+auricle_file_sink_query (GstBaseSink *sink,
+                         GstQuery    *query)
+{
+  AuricleFileSink *self = AURICLE_FILE_SINK (sink);
+  GstFormat format;
+
+  switch (GST_QUERY_TYPE (query))
+    {
+    case GST_QUERY_SEEKING:
+      // Muxers like mp4mux need to seek back to finish the file, unless they're set up to stream.
+      gst_query_parse_seeking (query, &format, NULL, NULL, NULL);
+      gst_query_set_seeking (query, format,
+                             !self->streaming && (format == GST_FORMAT_BYTES || format == GST_FORMAT_DEFAULT), 0, -1);
+      return TRUE;
+    case GST_QUERY_POSITION:
+      gst_query_parse_position (query, &format, NULL);
+      if (format != GST_FORMAT_BYTES && format != GST_FORMAT_DEFAULT)
+        return FALSE;
+
+      gst_query_set_position (query, GST_FORMAT_BYTES, self->position);
+      return TRUE;
+    case GST_QUERY_FORMATS:
+      gst_query_set_formats (query, 2, GST_FORMAT_DEFAULT, GST_FORMAT_BYTES);
+      return TRUE;
+    default:
+      return GST_BASE_SINK_CLASS (auricle_file_sink_parent_class)->query (sink, query);
+    }
+}
+
+static void
+auricle_file_sink_finalize (GObject *object)
+{
+  AuricleFileSink *self = (AuricleFileSink *)object;
+
+  // A descriptor handed over but never started on is still owned here.
+  if (self->fd != -1)
+    g_close (self->fd, NULL);
+
+  g_queue_clear_full (&self->pending, (GDestroyNotify) auricle_file_sink_write_free);
+  g_clear_pointer (&self->location, g_free);
+  g_clear_pointer (&self->temp_location, g_free);
+  g_clear_pointer (&self->checksum, g_checksum_free);
+  g_clear_pointer (&self->checksum_string, g_free);
+  g_mutex_clear (&self->lock);
+  g_cond_clear (&self->cond);
+
+  G_OBJECT_CLASS (auricle_file_sink_parent_class)->finalize (object);
+}
+
+static void
+auricle_file_sink_class_init (AuricleFileSinkClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+  GstElementClass *element_class = GST_ELEMENT_CLASS (klass);
+  GstBaseSinkClass *base_sink_class = GST_BASE_SINK_CLASS (klass);
+
+  object_class->finalize = auricle_file_sink_finalize;
+
+  gst_element_class_set_static_metadata (element_class, "Auricle file sink", "Sink/File",
+                                         "Writes to a file from a separate thread",
+                                         "Ryan Gonzalez <rymg19@gmail.com>");
+  gst_element_class_add_static_pad_template (element_class, &sink_template);
+
+  base_sink_class->start = auricle_file_sink_start;
+  base_sink_class->stop = auricle_file_sink_stop;
+  base_sink_class->unlock = auricle_file_sink_unlock;
+  base_sink_class->unlock_stop = auricle_file_sink_unlock_stop;
+  base_sink_class->render = auricle_file_sink_render;
+  base_sink_class->event = auricle_file_sink_event;
+  base_sink_class->query = auricle_file_sink_query;
+}
+
+static void
+auricle_file_sink_init (AuricleFileSink *self)
+{
+  self->fd = -1;
+  g_mutex_init (&self->lock);
+  g_cond_init (&self->cond);
+  g_queue_init (&self->pending);
+}
@@ -0,0 +1,42 @@
+/* auricle-file-sink.h
+ *
+ * Copyright 2019 Ryan Gonzalez <rymg19@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <gst/base/base.h>
+
+G_BEGIN_DECLS
+
+#define AURICLE_TYPE_FILE_SINK (auricle_file_sink_get_type())
+
+G_DECLARE_FINAL_TYPE (AuricleFileSink, auricle_file_sink, AURICLE, FILE_SINK, GstBaseSink)
+
+GstElement *auricle_file_sink_new              (const char      *location,
+                                                guint64          preallocate_size,
+                                                gboolean         checksum);
+GstElement *auricle_file_sink_new_for_fd       (int              fd,
+                                                const char      *name,
+                                                gboolean         checksum);
+void        auricle_file_sink_set_keep_partial (AuricleFileSink *self,
+                                                gboolean         keep_partial);
+const char *auricle_file_sink_get_checksum     (AuricleFileSink *self);
+gboolean    auricle_file_sink_is_finished      (AuricleFileSink *self);
+
+G_END_DECLS
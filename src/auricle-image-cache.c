@@ -0,0 +1,348 @@
+/* auricle-image-cache.c
+ *
+ * Copyright 2019 Ryan Gonzalez <rymg19@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "auricle-image-cache.h"
+#include "auricle-caption.h"
+#include "auricle-utils.h"
+
+/* Images are identified by a hash of their contents, so e.g. the same cover art embedded into
+   every track of an album is only decoded, captioned and encoded once per render. Keys are
+   "<image hash>" or "<image hash>:<caption hash>", and slideshows (which are a list of images that
+   are encoded together) are "slideshow:<hash of the image keys>". */
+
+typedef struct _AuricleImageCacheEntry AuricleImageCacheEntry;
+
+struct _AuricleImageCacheEntry
+{
+  GPtrArray           *pixbufs;
+  GstClockTime         dwell;
+  AuricleVideoSegment *segment;
+  GError              *error;
+  gboolean             encoding;
+};
+
+static void
+auricle_image_cache_entry_free (AuricleImageCacheEntry *entry)
+{
+  g_clear_pointer (&entry->pixbufs, g_ptr_array_unref);
+  g_clear_object (&entry->segment);
+  g_clear_error (&entry->error);
+  g_free (entry);
+}
+
+struct _AuricleImageCache
+{
+  GObject parent_instance;
+
+  // Segments are requested from streaming threads, so everything below is guarded by the mutex.
+  GMutex      mutex;
+  GCond       encoded;
+  GHashTable *entries;
+
+  const AuricleCodec *video_codec;
+  char               *video_preset;
+};
+
+G_DEFINE_TYPE (AuricleImageCache, auricle_image_cache, G_TYPE_OBJECT)
+
+/* The segments are encoded with the given video codec and preset (or NULL for the default). */
+AuricleImageCache *
+auricle_image_cache_new (const AuricleCodec *video_codec,
+                         const char         *video_preset)
+{
+  AuricleImageCache *self = g_object_new (AURICLE_TYPE_IMAGE_CACHE, NULL);
+  self->video_codec = video_codec;
+  self->video_preset = g_strdup (video_preset);
+  return self;
+}
+
+static void
+auricle_image_cache_finalize (GObject *object)
+{
+  AuricleImageCache *self = (AuricleImageCache *)object;
+
+  g_clear_pointer (&self->entries, g_hash_table_unref);
+  g_clear_pointer (&self->video_preset, g_free);
+  g_mutex_clear (&self->mutex);
+  g_cond_clear (&self->encoded);
+
+  G_OBJECT_CLASS (auricle_image_cache_parent_class)->finalize (object);
+}
+
+static void
+auricle_image_cache_class_init (AuricleImageCacheClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = auricle_image_cache_finalize;
+}
+
+static void
+auricle_image_cache_init (AuricleImageCache *self)
+{
+  g_mutex_init (&self->mutex);
+  g_cond_init (&self->encoded);
+  self->entries = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                         (GDestroyNotify) auricle_image_cache_entry_free);
+}
+
+static gboolean
+auricle_image_cache_contains (AuricleImageCache *self,
+                              const char        *key)
+{
+  g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&self->mutex);
+  return g_hash_table_contains (self->entries, key);
+}
+
+static AuricleImageCacheEntry *
+auricle_image_cache_lookup (AuricleImageCache *self,
+                            const char        *key)
+{
+  g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&self->mutex);
+  return g_hash_table_lookup (self->entries, key);
+}
+
+static void
+auricle_image_cache_insert (AuricleImageCache *self,
+                            const char        *key,
+                            GPtrArray         *pixbufs,
+                            GstClockTime       dwell)
+{
+  g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&self->mutex);
+  if (g_hash_table_contains (self->entries, key))
+    return;
+
+  AuricleImageCacheEntry *entry = g_new0 (AuricleImageCacheEntry, 1);
+  entry->pixbufs = g_ptr_array_ref (pixbufs);
+  entry->dwell = dwell;
+  g_hash_table_insert (self->entries, g_strdup (key), entry);
+}
+
+static void
+auricle_image_cache_insert_pixbuf (AuricleImageCache *self,
+                                   const char        *key,
+                                   GdkPixbuf         *pixbuf)
+{
+  g_autoptr(GPtrArray) pixbufs = g_ptr_array_new_with_free_func (g_object_unref);
+  g_ptr_array_add (pixbufs, g_object_ref (pixbuf));
+  auricle_image_cache_insert (self, key, pixbufs, AURICLE_VIDEO_SEGMENT_DEFAULT_DWELL);
+}
+
+/* Adds an already decoded image, returning its key. */
+char *
+auricle_image_cache_add_pixbuf (AuricleImageCache *self,
+                                GdkPixbuf         *pixbuf)
+{
+  g_autoptr(GChecksum) checksum = g_checksum_new (G_CHECKSUM_SHA256);
+
+  int dimensions[] = {gdk_pixbuf_get_width (pixbuf), gdk_pixbuf_get_height (pixbuf),
+                      gdk_pixbuf_get_rowstride (pixbuf), gdk_pixbuf_get_has_alpha (pixbuf)};
+  g_checksum_update (checksum, (const guchar *) dimensions, sizeof (dimensions));
+  g_checksum_update (checksum, gdk_pixbuf_read_pixels (pixbuf), gdk_pixbuf_get_byte_length (pixbuf));
+
+  char *key = g_strdup (g_checksum_get_string (checksum));
+  auricle_image_cache_insert_pixbuf (self, key, pixbuf);
+  return key;
+}
+
+/* Adds an encoded image, returning its key. The image is only decoded if it hasn't been seen yet. */
+char *
+auricle_image_cache_add_bytes (AuricleImageCache  *self,
+                               GBytes             *data,
+                               GError            **error)
+{
+  g_autofree char *key = g_compute_checksum_for_bytes (G_CHECKSUM_SHA256, data);
+  if (auricle_image_cache_contains (self, key))
+    return g_steal_pointer (&key);
+
+  g_autoptr(GdkPixbufLoader) loader = gdk_pixbuf_loader_new ();
+  if (!gdk_pixbuf_loader_write_bytes (loader, data, error) || !gdk_pixbuf_loader_close (loader, error))
+    return NULL;
+
+  GdkPixbuf *decoded = gdk_pixbuf_loader_get_pixbuf (loader);
+  g_autoptr(GdkPixbuf) oriented = gdk_pixbuf_apply_embedded_orientation (decoded);
+  g_autoptr(GdkPixbuf) pixbuf = auricle_pixbuf_make_even (oriented);
+
+  auricle_image_cache_insert_pixbuf (self, key, pixbuf);
+  return g_steal_pointer (&key);
+}
+
+char *
+auricle_image_cache_add_file (AuricleImageCache  *self,
+                              const char         *path,
+                              GError            **error)
+{
+  char *contents;
+  gsize length;
+  if (!g_file_get_contents (path, &contents, &length, error))
+    return NULL;
+
+  g_autoptr(GBytes) data = g_bytes_new_take (contents, length);
+  return auricle_image_cache_add_bytes (self, data, error);
+}
+
+/* Returns the key of the image (or slideshow) with the given caption drawn onto it, rendering it
+   if needed. */
+char *
+auricle_image_cache_add_caption (AuricleImageCache *self,
+                                 const char        *key,
+                                 const char        *caption)
+{
+  if (caption == NULL || *caption == '\0')
+    return g_strdup (key);
+
+  g_autofree char *caption_hash = g_compute_checksum_for_string (G_CHECKSUM_SHA256, caption, -1);
+  g_autofree char *captioned_key = g_strdup_printf ("%s:%s", key, caption_hash);
+
+  if (!auricle_image_cache_contains (self, captioned_key))
+    {
+      AuricleImageCacheEntry *entry = auricle_image_cache_lookup (self, key);
+      g_return_val_if_fail (entry != NULL, NULL);
+
+      g_autoptr(GPtrArray) pixbufs = g_ptr_array_new_with_free_func (g_object_unref);
+      for (guint i = 0; i < entry->pixbufs->len; i++)
+        g_ptr_array_add (pixbufs, auricle_caption_render (g_ptr_array_index (entry->pixbufs, i), caption));
+
+      auricle_image_cache_insert (self, captioned_key, pixbufs, entry->dwell);
+    }
+
+  return g_steal_pointer (&captioned_key);
+}
+
+/* Returns the key of a slideshow cycling through the given images, each shown for the dwell time.
+   Every image is fit into the size of the first one, since the video size can't change midway. */
+char *
+auricle_image_cache_add_slideshow (AuricleImageCache  *self,
+                                   const char * const *keys,
+                                   GstClockTime        dwell)
+{
+  g_return_val_if_fail (keys != NULL && keys[0] != NULL, NULL);
+
+  g_autofree char *joined_keys = g_strjoinv ("\n", (char **) keys);
+  g_autofree char *source = g_strdup_printf ("%s\n%" G_GUINT64_FORMAT, joined_keys, dwell);
+  g_autofree char *source_hash = g_compute_checksum_for_string (G_CHECKSUM_SHA256, source, -1);
+  g_autofree char *key = g_strdup_printf ("slideshow:%s", source_hash);
+
+  if (auricle_image_cache_contains (self, key))
+    return g_steal_pointer (&key);
+
+  GdkPixbuf *first = auricle_image_cache_get_pixbuf (self, keys[0]);
+  int width = gdk_pixbuf_get_width (first);
+  int height = gdk_pixbuf_get_height (first);
+
+  g_autoptr(GPtrArray) pixbufs = g_ptr_array_new_with_free_func (g_object_unref);
+  for (const char * const *image_key = keys; *image_key != NULL; image_key++)
+    {
+      GdkPixbuf *image = auricle_image_cache_get_pixbuf (self, *image_key);
+      g_ptr_array_add (pixbufs, auricle_pixbuf_fit (image, width, height));
+    }
+
+  auricle_image_cache_insert (self, key, pixbufs, dwell);
+  return g_steal_pointer (&key);
+}
+
+/* Returns the key of the image (or slideshow) scaled down to at most the given height. */
+char *
+auricle_image_cache_add_scaled (AuricleImageCache *self,
+                                const char        *key,
+                                int                max_height)
+{
+  g_autofree char *scaled_key = g_strdup_printf ("%s:%dp", key, max_height);
+
+  if (!auricle_image_cache_contains (self, scaled_key))
+    {
+      AuricleImageCacheEntry *entry = auricle_image_cache_lookup (self, key);
+      g_return_val_if_fail (entry != NULL, NULL);
+
+      g_autoptr(GPtrArray) pixbufs = g_ptr_array_new_with_free_func (g_object_unref);
+      for (guint i = 0; i < entry->pixbufs->len; i++)
+        {
+          GdkPixbuf *image = g_ptr_array_index (entry->pixbufs, i);
+          int width = gdk_pixbuf_get_width (image);
+          int height = gdk_pixbuf_get_height (image);
+
+          if (height <= max_height)
+            {
+              g_ptr_array_add (pixbufs, g_object_ref (image));
+              continue;
+            }
+
+          g_autoptr(GdkPixbuf) scaled = gdk_pixbuf_scale_simple (image, MAX (width * max_height / height, 2),
+                                                                 max_height, GDK_INTERP_BILINEAR);
+          g_ptr_array_add (pixbufs, auricle_pixbuf_make_even (scaled));
+        }
+
+      auricle_image_cache_insert (self, scaled_key, pixbufs, entry->dwell);
+    }
+
+  return g_steal_pointer (&scaled_key);
+}
+
+GdkPixbuf *
+auricle_image_cache_get_pixbuf (AuricleImageCache *self,
+                                const char        *key)
+{
+  g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&self->mutex);
+
+  AuricleImageCacheEntry *entry = g_hash_table_lookup (self->entries, key);
+  g_return_val_if_fail (entry != NULL, NULL);
+  return g_ptr_array_index (entry->pixbufs, 0);
+}
+
+/* Returns the encoded segment for the image, encoding it if this is the first request for it.
+   Concurrent requests for the same image wait for the first one to finish. */
+AuricleVideoSegment *
+auricle_image_cache_get_segment (AuricleImageCache  *self,
+                                 const char         *key,
+                                 GError            **error)
+{
+  g_autoptr(GMutexLocker) locker = g_mutex_locker_new (&self->mutex);
+
+  AuricleImageCacheEntry *entry = g_hash_table_lookup (self->entries, key);
+  g_return_val_if_fail (entry != NULL, NULL);
+
+  while (entry->encoding)
+    g_cond_wait (&self->encoded, &self->mutex);
+
+  if (entry->segment == NULL && entry->error == NULL)
+    {
+      entry->encoding = TRUE;
+      g_mutex_unlock (&self->mutex);
+
+      g_autoptr(GError) local_error = NULL;
+      AuricleVideoSegment *segment = auricle_video_segment_encode (self->video_codec, self->video_preset,
+                                                                   entry->pixbufs, entry->dwell, &local_error);
+
+      g_mutex_lock (&self->mutex);
+      entry->segment = segment;
+      entry->error = g_steal_pointer (&local_error);
+      entry->encoding = FALSE;
+      g_cond_broadcast (&self->encoded);
+    }
+
+  if (entry->error != NULL)
+    {
+      g_propagate_error (error, g_error_copy (entry->error));
+      return NULL;
+    }
+
+  return entry->segment;
+}
+
@@ -0,0 +1,62 @@
+/* auricle-image-cache.h
+ *
+ * Copyright 2019 Ryan Gonzalez <rymg19@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <glib-object.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include "auricle-video-segment.h"
+
+G_BEGIN_DECLS
+
+#define AURICLE_TYPE_IMAGE_CACHE (auricle_image_cache_get_type())
+
+G_DECLARE_FINAL_TYPE (AuricleImageCache, auricle_image_cache, AURICLE, IMAGE_CACHE, GObject)
+
+AuricleImageCache *auricle_image_cache_new (const AuricleCodec *video_codec,
+                                            const char         *video_preset);
+
+char *auricle_image_cache_add_pixbuf  (AuricleImageCache  *self,
+                                       GdkPixbuf          *pixbuf);
+char *auricle_image_cache_add_bytes   (AuricleImageCache  *self,
+                                       GBytes             *data,
+                                       GError            **error);
+char *auricle_image_cache_add_file    (AuricleImageCache  *self,
+                                       const char         *path,
+                                       GError            **error);
+char *auricle_image_cache_add_caption (AuricleImageCache  *self,
+                                       const char         *key,
+                                       const char         *caption);
+
+char *auricle_image_cache_add_slideshow (AuricleImageCache  *self,
+                                         const char * const *keys,
+                                         GstClockTime        dwell);
+char *auricle_image_cache_add_scaled    (AuricleImageCache  *self,
+                                         const char         *key,
+                                         int                 max_height);
+
+GdkPixbuf           *auricle_image_cache_get_pixbuf  (AuricleImageCache  *self,
+                                                      const char         *key);
+AuricleVideoSegment *auricle_image_cache_get_segment (AuricleImageCache  *self,
+                                                      const char         *key,
+                                                      GError            **error);
+
+G_END_DECLS
+
@@ -155,18 +155,7 @@ on_file_set (GtkFileChooserButton *button,
   int height_request = ((float) image_height / image_width) * width_request;
   gtk_image_set_from_pixbuf (self->image, gdk_pixbuf_scale_simple (pixbuf, width_request, height_request, GDK_INTERP_BILINEAR));
 
-  if (image_width % 2 != 0 || image_height % 2 != 0)
-    {
-      // h264 requires even dimensions, so we need to scale up around a pixel on the needed sides.
-      g_autoptr(GdkPixbuf) old_pixbuf = g_steal_pointer (&pixbuf);
-
-      image_width += image_width % 2;
-      image_height += image_height % 2;
-
-      pixbuf = gdk_pixbuf_scale_simple (old_pixbuf, image_width, image_height, GDK_INTERP_BILINEAR);
-    }
-
-  auricle_image_section_take_pixbuf (self, g_steal_pointer (&pixbuf), TRUE);
+  auricle_image_section_take_pixbuf (self, auricle_pixbuf_make_even (pixbuf), TRUE);
 }
 
 static void
@@ -0,0 +1,301 @@
+/* auricle-loudness.c
+ *
+ * Copyright 2019 Ryan Gonzalez <rymg19@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "auricle-loudness.h"
+#include <math.h>
+#include <string.h>
+
+/* Measures loudness as per ITU-R BS.1770-4, which EBU R128 builds on: the audio is K-weighted, its
+   power is taken over 400ms blocks overlapping by 75%, and the blocks are gated to leave out
+   silence before averaging. */
+
+#define SUBBLOCKS_PER_SECOND 10
+#define SUBBLOCKS_PER_BLOCK 4
+#define ABSOLUTE_GATE -70.0
+#define RELATIVE_GATE -10.0
+
+// True peaks are found by 4x oversampling with a windowed sinc filter, split into one phase per
+// interpolated sample.
+#define OVERSAMPLE 4
+#define TAPS_PER_PHASE 12
+#define OVERSAMPLE_TAPS (OVERSAMPLE * TAPS_PER_PHASE)
+
+typedef struct _AuricleBiquad AuricleBiquad;
+
+struct _AuricleBiquad
+{
+  double b[3];
+  double a[3];
+};
+
+typedef struct _AuricleLoudnessChannel AuricleLoudnessChannel;
+
+struct _AuricleLoudnessChannel
+{
+  double weight;
+  // Direct form II state for the two K-weighting stages.
+  double shelf_state[2];
+  double highpass_state[2];
+  float  history[TAPS_PER_PHASE];
+};
+
+struct _AuricleLoudness
+{
+  guint channel_count;
+  AuricleLoudnessChannel *channels;
+
+  AuricleBiquad shelf;
+  AuricleBiquad highpass;
+  double        oversample_filter[OVERSAMPLE_TAPS];
+
+  gsize   subblock_frames;
+  gsize   subblock_position;
+  double  subblock_power;
+  // The mean power of each 100ms subblock so far.
+  GArray *subblocks;
+
+  double peak;
+};
+
+static void
+init_k_weighting (AuricleLoudness *self,
+                  double           rate)
+{
+  // The filters given in BS.1770 are for 48kHz, so they're recomputed from their analog prototypes
+  // for other rates.
+  double f0 = 1681.974450955533;
+  double gain = 3.999843853973347;
+  double q = 0.7071752369554196;
+
+  double k = tan (G_PI * f0 / rate);
+  double vh = pow (10.0, gain / 20.0);
+  double vb = pow (vh, 0.4996667741545416);
+  double a0 = 1.0 + k / q + k * k;
+
+  self->shelf.b[0] = (vh + vb * k / q + k * k) / a0;
+  self->shelf.b[1] = 2.0 * (k * k - vh) / a0;
+  self->shelf.b[2] = (vh - vb * k / q + k * k) / a0;
+  self->shelf.a[0] = 1.0;
+  self->shelf.a[1] = 2.0 * (k * k - 1.0) / a0;
+  self->shelf.a[2] = (1.0 - k / q + k * k) / a0;
+
+  f0 = 38.13547087602444;
+  q = 0.5003270373238773;
+  k = tan (G_PI * f0 / rate);
+  a0 = 1.0 + k / q + k * k;
+
+  self->highpass.b[0] = 1.0;
+  self->highpass.b[1] = -2.0;
+  self->highpass.b[2] = 1.0;
+  self->highpass.a[0] = 1.0;
+  self->highpass.a[1] = 2.0 * (k * k - 1.0) / a0;
+  self->highpass.a[2] = (1.0 - k / q + k * k) / a0;
+}
+
+static void
+init_oversample_filter (AuricleLoudness *self)
+{
+  for (int phase = 0; phase < OVERSAMPLE; phase++)
+    {
+      double sum = 0;
+
+      for (int tap = 0; tap < TAPS_PER_PHASE; tap++)
+        {
+          int i = tap * OVERSAMPLE + phase;
+          double x = (i - (OVERSAMPLE_TAPS - 1) / 2.0) / OVERSAMPLE;
+          double sinc = x == 0 ? 1.0 : sin (G_PI * x) / (G_PI * x);
+          double window = 0.5 - 0.5 * cos (2.0 * G_PI * (i + 0.5) / OVERSAMPLE_TAPS);
+
+          self->oversample_filter[i] = sinc * window;
+          sum += sinc * window;
+        }
+
+      // Keep each phase at unity gain, so a constant signal doesn't read as louder than it is.
+      for (int tap = 0; tap < TAPS_PER_PHASE; tap++)
+        self->oversample_filter[tap * OVERSAMPLE + phase] /= sum;
+    }
+}
+
+AuricleLoudness *
+auricle_loudness_new (guint rate,
+                      guint channels)
+{
+  g_return_val_if_fail (rate != 0 && channels != 0, NULL);
+
+  AuricleLoudness *self = g_new0 (AuricleLoudness, 1);
+  self->channel_count = channels;
+  self->channels = g_new0 (AuricleLoudnessChannel, channels);
+
+  for (guint i = 0; i < channels; i++)
+    self->channels[i].weight = 1.0;
+
+  // With the default 5.1 layout, the LFE channel is left out and the surrounds count for more.
+  if (channels == 6)
+    {
+      self->channels[3].weight = 0.0;
+      self->channels[4].weight = 1.41;
+      self->channels[5].weight = 1.41;
+    }
+
+  init_k_weighting (self, rate);
+  init_oversample_filter (self);
+
+  self->subblock_frames = MAX (rate / SUBBLOCKS_PER_SECOND, 1);
+  self->subblocks = g_array_new (FALSE, FALSE, sizeof (double));
+
+  return self;
+}
+
+void
+auricle_loudness_free (AuricleLoudness *self)
+{
+  g_free (self->channels);
+  g_array_unref (self->subblocks);
+  g_free (self);
+}
+
+guint
+auricle_loudness_get_channels (AuricleLoudness *self)
+{
+  return self->channel_count;
+}
+
+static double
+biquad_run (const AuricleBiquad *filter,
+            double              *state,
+            double               x)
+{
+  double w = x - filter->a[1] * state[0] - filter->a[2] * state[1];
+  double y = filter->b[0] * w + filter->b[1] * state[0] + filter->b[2] * state[1];
+
+  state[1] = state[0];
+  state[0] = w;
+  return y;
+}
+
+static void
+update_peak (AuricleLoudness        *self,
+             AuricleLoudnessChannel *channel,
+             float                   sample)
+{
+  memmove (channel->history + 1, channel->history, sizeof (float) * (TAPS_PER_PHASE - 1));
+  channel->history[0] = sample;
+
+  for (int phase = 0; phase < OVERSAMPLE; phase++)
+    {
+      double y = 0;
+      for (int tap = 0; tap < TAPS_PER_PHASE; tap++)
+        y += self->oversample_filter[tap * OVERSAMPLE + phase] * channel->history[tap];
+
+      self->peak = MAX (self->peak, fabs (y));
+    }
+
+  self->peak = MAX (self->peak, fabsf (sample));
+}
+
+/* Takes interleaved samples in the channel count given at creation. */
+void
+auricle_loudness_add_samples (AuricleLoudness *self,
+                              const float     *samples,
+                              gsize            frames)
+{
+  for (gsize frame = 0; frame < frames; frame++)
+    {
+      for (guint i = 0; i < self->channel_count; i++)
+        {
+          AuricleLoudnessChannel *channel = &self->channels[i];
+          float sample = samples[frame * self->channel_count + i];
+
+          update_peak (self, channel, sample);
+
+          if (channel->weight == 0)
+            continue;
+
+          double y = biquad_run (&self->shelf, channel->shelf_state, sample);
+          y = biquad_run (&self->highpass, channel->highpass_state, y);
+          self->subblock_power += channel->weight * y * y;
+        }
+
+      if (++self->subblock_position == self->subblock_frames)
+        {
+          double power = self->subblock_power / self->subblock_frames;
+          g_array_append_val (self->subblocks, power);
+
+          self->subblock_position = 0;
+          self->subblock_power = 0;
+        }
+    }
+}
+
+static double
+power_to_loudness (double power)
+{
+  return -0.691 + 10.0 * log10 (power);
+}
+
+static double
+get_block_power (AuricleLoudness *self,
+                 guint            block)
+{
+  double power = 0;
+  for (guint i = 0; i < SUBBLOCKS_PER_BLOCK; i++)
+    power += g_array_index (self->subblocks, double, block + i);
+
+  return power / SUBBLOCKS_PER_BLOCK;
+}
+
+static double
+get_gated_power (AuricleLoudness *self,
+                 double           gate)
+{
+  double total = 0;
+  guint count = 0;
+
+  for (guint block = 0; block + SUBBLOCKS_PER_BLOCK <= self->subblocks->len; block++)
+    {
+      double power = get_block_power (self, block);
+      if (power > 0 && power_to_loudness (power) > gate)
+        {
+          total += power;
+          count++;
+        }
+    }
+
+  return count != 0 ? total / count : 0;
+}
+
+/* Returns the integrated loudness in LUFS, or -HUGE_VAL if the audio was too short or quiet. */
+double
+auricle_loudness_get_integrated (AuricleLoudness *self)
+{
+  double power = get_gated_power (self, ABSOLUTE_GATE);
+  if (power == 0)
+    return -HUGE_VAL;
+
+  power = get_gated_power (self, power_to_loudness (power) + RELATIVE_GATE);
+  return power != 0 ? power_to_loudness (power) : -HUGE_VAL;
+}
+
+/* Returns the true peak in dBTP. */
+double
+auricle_loudness_get_true_peak (AuricleLoudness *self)
+{
+  return self->peak > 0 ? 20.0 * log10 (self->peak) : -HUGE_VAL;
+}
@@ -0,0 +1,44 @@
+/* auricle-loudness.h
+ *
+ * Copyright 2019 Ryan Gonzalez <rymg19@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _AuricleLoudness AuricleLoudness;
+
+AuricleLoudness *auricle_loudness_new  (guint            rate,
+                                        guint            channels);
+void             auricle_loudness_free (AuricleLoudness *loudness);
+
+guint auricle_loudness_get_channels (AuricleLoudness *loudness);
+
+void auricle_loudness_add_samples (AuricleLoudness *loudness,
+                                   const float     *samples,
+                                   gsize            frames);
+
+double auricle_loudness_get_integrated (AuricleLoudness *loudness);
+double auricle_loudness_get_true_peak  (AuricleLoudness *loudness);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (AuricleLoudness, auricle_loudness_free)
+
+G_END_DECLS
@@ -24,8 +24,22 @@ struct _AuricleMusicFile
 {
   GObject parent_instance;
 
-  char *path;
-  char *result_name;
+  char       *path;
+  char       *result_name;
+  GHashTable *template_vars;
+  GBytes     *cover;
+  guint       source_bitrate;
+
+  GstClockTime duration;
+  GstCaps     *source_caps;
+
+  // The part of the source this file covers, e.g. a track from a CUE sheet.
+  GstClockTime range_start;
+  GstClockTime range_end;
+
+  gboolean    has_loudness;
+  double      integrated_loudness;
+  double      true_peak;
 };
 
 G_DEFINE_TYPE (AuricleMusicFile, auricle_music_file, G_TYPE_OBJECT)
@@ -34,6 +48,9 @@ enum {
   PROP_0,
   PROP_PATH,
   PROP_RESULT_NAME,
+  PROP_TEMPLATE_VARS,
+  PROP_COVER,
+  PROP_SOURCE_BITRATE,
   N_PROPS
 };
 
@@ -49,6 +66,30 @@ auricle_music_file_new (const char *path,
                        NULL);
 }
 
+/* Returns a copy of the file, with everything known about its source, but a different result name. */
+AuricleMusicFile *
+auricle_music_file_copy_renamed (AuricleMusicFile *self,
+                                 const char       *result_name)
+{
+  AuricleMusicFile *copy = g_object_new (AURICLE_TYPE_MUSIC_FILE,
+                                         "path", self->path,
+                                         "result-name", result_name,
+                                         "template-vars", self->template_vars,
+                                         "cover", self->cover,
+                                         "source-bitrate", self->source_bitrate,
+                                         NULL);
+
+  copy->duration = self->duration;
+  gst_caps_replace (&copy->source_caps, self->source_caps);
+  copy->range_start = self->range_start;
+  copy->range_end = self->range_end;
+  copy->has_loudness = self->has_loudness;
+  copy->integrated_loudness = self->integrated_loudness;
+  copy->true_peak = self->true_peak;
+
+  return copy;
+}
+
 static void
 auricle_music_file_finalize (GObject *object)
 {
@@ -56,6 +97,9 @@ auricle_music_file_finalize (GObject *object)
 
   g_clear_pointer (&self->path, g_free);
   g_clear_pointer (&self->result_name, g_free);
+  g_clear_pointer (&self->template_vars, g_hash_table_unref);
+  g_clear_pointer (&self->cover, g_bytes_unref);
+  g_clear_pointer (&self->source_caps, gst_caps_unref);
 
   G_OBJECT_CLASS (auricle_music_file_parent_class)->finalize (object);
 }
@@ -78,6 +122,15 @@ auricle_music_file_get_property (GObject    *object,
       g_warn_if_fail (self->result_name != NULL);
       g_value_set_string (value, self->result_name);
       break;
+    case PROP_TEMPLATE_VARS:
+      g_value_set_boxed (value, self->template_vars);
+      break;
+    case PROP_COVER:
+      g_value_set_boxed (value, self->cover);
+      break;
+    case PROP_SOURCE_BITRATE:
+      g_value_set_uint (value, self->source_bitrate);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
     }
@@ -101,6 +154,15 @@ auricle_music_file_set_property (GObject      *object,
       g_warn_if_fail (self->result_name == NULL);
       self->result_name = g_value_dup_string (value);
       break;
+    case PROP_TEMPLATE_VARS:
+      auricle_music_file_set_template_vars (self, g_value_get_boxed (value));
+      break;
+    case PROP_COVER:
+      auricle_music_file_set_cover (self, g_value_get_boxed (value));
+      break;
+    case PROP_SOURCE_BITRATE:
+      auricle_music_file_set_source_bitrate (self, g_value_get_uint (value));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
     }
@@ -136,11 +198,44 @@ auricle_music_file_class_init (AuricleMusicFileClass *klass)
                           G_PARAM_STATIC_STRINGS));
   g_object_class_install_property (object_class, PROP_RESULT_NAME,
                                    properties [PROP_RESULT_NAME]);
+
+  properties [PROP_TEMPLATE_VARS] =
+    g_param_spec_boxed ("template-vars",
+                        "Template variables",
+                        "The template variables (tags, path, etc) of the source track",
+                        G_TYPE_HASH_TABLE,
+                        (G_PARAM_READWRITE |
+                         G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (object_class, PROP_TEMPLATE_VARS,
+                                   properties [PROP_TEMPLATE_VARS]);
+
+  properties [PROP_COVER] =
+    g_param_spec_boxed ("cover",
+                        "Cover",
+                        "The encoded cover image embedded in the source track, if any",
+                        G_TYPE_BYTES,
+                        (G_PARAM_READWRITE |
+                         G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (object_class, PROP_COVER,
+                                   properties [PROP_COVER]);
+
+  properties [PROP_SOURCE_BITRATE] =
+    g_param_spec_uint ("source-bitrate",
+                       "Source bitrate",
+                       "The audio bitrate of the source track in kbps, or 0 if unknown",
+                       0, G_MAXUINT, 0,
+                       (G_PARAM_READWRITE |
+                        G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (object_class, PROP_SOURCE_BITRATE,
+                                   properties [PROP_SOURCE_BITRATE]);
 }
 
 static void
 auricle_music_file_init (AuricleMusicFile *self)
 {
+  self->duration = GST_CLOCK_TIME_NONE;
+  self->range_start = GST_CLOCK_TIME_NONE;
+  self->range_end = GST_CLOCK_TIME_NONE;
 }
 
 const char *
@@ -154,3 +249,122 @@ auricle_music_file_get_result_name (AuricleMusicFile *self)
 {
   return self->result_name;
 }
+
+GHashTable *
+auricle_music_file_get_template_vars (AuricleMusicFile *self)
+{
+  return self->template_vars;
+}
+
+void
+auricle_music_file_set_template_vars (AuricleMusicFile *self,
+                                      GHashTable       *template_vars)
+{
+  g_clear_pointer (&self->template_vars, g_hash_table_unref);
+  if (template_vars != NULL)
+    self->template_vars = g_hash_table_ref (template_vars);
+}
+
+GBytes *
+auricle_music_file_get_cover (AuricleMusicFile *self)
+{
+  return self->cover;
+}
+
+void
+auricle_music_file_set_cover (AuricleMusicFile *self,
+                              GBytes           *cover)
+{
+  g_clear_pointer (&self->cover, g_bytes_unref);
+  if (cover != NULL)
+    self->cover = g_bytes_ref (cover);
+}
+
+
+guint
+auricle_music_file_get_source_bitrate (AuricleMusicFile *self)
+{
+  return self->source_bitrate;
+}
+
+void
+auricle_music_file_set_source_bitrate (AuricleMusicFile *self,
+                                       guint             source_bitrate)
+{
+  self->source_bitrate = source_bitrate;
+}
+
+/* Returns the integrated loudness in LUFS and the true peak in dBTP, if they were measured. */
+gboolean
+auricle_music_file_get_loudness (AuricleMusicFile *self,
+                                 double           *integrated_loudness,
+                                 double           *true_peak)
+{
+  if (!self->has_loudness)
+    return FALSE;
+
+  *integrated_loudness = self->integrated_loudness;
+  *true_peak = self->true_peak;
+  return TRUE;
+}
+
+void
+auricle_music_file_set_loudness (AuricleMusicFile *self,
+                                 double            integrated_loudness,
+                                 double            true_peak)
+{
+  self->has_loudness = TRUE;
+  self->integrated_loudness = integrated_loudness;
+  self->true_peak = true_peak;
+}
+
+GstClockTime
+auricle_music_file_get_duration (AuricleMusicFile *self)
+{
+  return self->duration;
+}
+
+void
+auricle_music_file_set_duration (AuricleMusicFile *self,
+                                 GstClockTime      duration)
+{
+  self->duration = duration;
+}
+
+/* Returns the caps of the source's audio stream before decoding, if known. */
+GstCaps *
+auricle_music_file_get_source_caps (AuricleMusicFile *self)
+{
+  return self->source_caps;
+}
+
+void
+auricle_music_file_set_source_caps (AuricleMusicFile *self,
+                                    GstCaps          *source_caps)
+{
+  gst_caps_replace (&self->source_caps, source_caps);
+}
+
+/* Returns whether the file only covers part of its source. The end is GST_CLOCK_TIME_NONE if the
+   range runs to the end of the source. */
+gboolean
+auricle_music_file_get_range (AuricleMusicFile *self,
+                              GstClockTime     *start,
+                              GstClockTime     *end)
+{
+  if (!GST_CLOCK_TIME_IS_VALID (self->range_start))
+    return FALSE;
+
+  *start = self->range_start;
+  *end = self->range_end;
+  return TRUE;
+}
+
+void
+auricle_music_file_set_range (AuricleMusicFile *self,
+                              GstClockTime      start,
+                              GstClockTime      end)
+{
+  self->range_start = start;
+  self->range_end = end;
+}
@@ -21,6 +21,7 @@
 #pragma once
 
 #include <glib-object.h>
+#include <gst/gst.h>
 
 G_BEGIN_DECLS
 
@@ -31,8 +32,45 @@ G_DECLARE_FINAL_TYPE (AuricleMusicFile, auricle_music_file, AURICLE, MUSIC_FILE,
 AuricleMusicFile *auricle_music_file_new (const char *path,
                                           const char *result_name);
 
+AuricleMusicFile *auricle_music_file_copy_renamed (AuricleMusicFile *file,
+                                                   const char       *result_name);
+
 const char *auricle_music_file_get_path        (AuricleMusicFile *file);
 const char *auricle_music_file_get_result_name (AuricleMusicFile *file);
 
+GHashTable *auricle_music_file_get_template_vars (AuricleMusicFile *file);
+void        auricle_music_file_set_template_vars (AuricleMusicFile *file,
+                                                  GHashTable       *template_vars);
+
+GBytes *auricle_music_file_get_cover (AuricleMusicFile *file);
+void    auricle_music_file_set_cover (AuricleMusicFile *file,
+                                      GBytes           *cover);
+
+guint auricle_music_file_get_source_bitrate (AuricleMusicFile *file);
+void  auricle_music_file_set_source_bitrate (AuricleMusicFile *file,
+                                             guint             source_bitrate);
+
+gboolean auricle_music_file_get_loudness (AuricleMusicFile *file,
+                                          double           *integrated_loudness,
+                                          double           *true_peak);
+void     auricle_music_file_set_loudness (AuricleMusicFile *file,
+                                          double            integrated_loudness,
+                                          double            true_peak);
+
+GstClockTime auricle_music_file_get_duration (AuricleMusicFile *file);
+void         auricle_music_file_set_duration (AuricleMusicFile *file,
+                                              GstClockTime      duration);
+
+GstCaps *auricle_music_file_get_source_caps (AuricleMusicFile *file);
+void     auricle_music_file_set_source_caps (AuricleMusicFile *file,
+                                             GstCaps          *source_caps);
+
+gboolean auricle_music_file_get_range (AuricleMusicFile *file,
+                                       GstClockTime     *start,
+                                       GstClockTime     *end);
+void     auricle_music_file_set_range (AuricleMusicFile *file,
+                                       GstClockTime      start,
+                                       GstClockTime      end);
+
 G_END_DECLS
 
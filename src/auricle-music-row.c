@@ -19,10 +19,18 @@
  */
 
 #include <gst/gst.h>
+#include <gst/app/app.h>
 
+#include "auricle-loudness.h"
 #include "auricle-music-row.h"
 #include "auricle-utils.h"
 
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+#define NATIVE_F32 "F32LE"
+#else
+#define NATIVE_F32 "F32BE"
+#endif
+
 struct _AuricleMusicRow
 {
   GtkListBoxRow parent_instance;
@@ -38,21 +46,52 @@ struct _AuricleMusicRow
   GtkRevealer *music_row_override_entry;
 
   GHashTable *template_vars;
+  GBytes     *cover;
+  guint       source_bitrate;
 
   char       *path;
   char       *template;
   char       *template_override;
   GstElement *pipeline;
   guint       bus_watch_id;
+  gboolean    tags_scanned;
+
+  GstClockTime duration;
+  GstCaps     *source_caps;
+
+  /* Set for tracks taken from a CUE sheet, which cover part of the file. The sheet's own metadata
+     takes precedence over the file's tags. */
+  GstClockTime range_start;
+  GstClockTime range_end;
+  GHashTable  *range_vars;
+
+  /* The tag scan stops once the pipeline prerolls. To measure the loudness, it's then left to play
+     through the rest of the file, so the start isn't decoded twice. */
+  gboolean         measure_loudness;
+  gboolean         waiting_for_loudness;
+  gboolean         measuring_loudness;
+  AuricleLoudness *loudness;
+  guint            loudness_rate;
+  gboolean         has_loudness;
+  double           integrated_loudness;
+  double           true_peak;
 };
 
 G_DEFINE_TYPE (AuricleMusicRow, auricle_music_row, GTK_TYPE_LIST_BOX_ROW)
 
+/* Measuring the loudness decodes each track in full, so only one measurement per CPU runs at a time,
+   and the other rows wait their turn in order. */
+static GQueue waiting_rows = G_QUEUE_INIT;
+static guint n_measuring = 0;
+
+static void auricle_music_row_stop_loudness (AuricleMusicRow *self);
+
 enum {
   PROP_0,
   PROP_PATH,
   PROP_TEMPLATE,
   PROP_TEMPLATE_OVERRIDE,
+  PROP_MEASURE_LOUDNESS,
   N_PROPS
 };
 
@@ -79,6 +118,8 @@ auricle_music_row_finalize (GObject *object)
 {
   AuricleMusicRow *self = (AuricleMusicRow *)object;
 
+  auricle_music_row_stop_loudness (self);
+
   if (self->pipeline)
     gst_element_set_state (self->pipeline, GST_STATE_NULL);
 
@@ -89,10 +130,14 @@ auricle_music_row_finalize (GObject *object)
     }
 
   g_clear_pointer (&self->template_vars, g_hash_table_unref);
+  g_clear_pointer (&self->cover, g_bytes_unref);
   g_clear_pointer (&self->path, g_free);
   g_clear_pointer (&self->template, g_free);
   g_clear_pointer (&self->template_override, g_free);
   g_clear_pointer (&self->pipeline, gst_object_unref);
+  g_clear_pointer (&self->loudness, auricle_loudness_free);
+  g_clear_pointer (&self->source_caps, gst_caps_unref);
+  g_clear_pointer (&self->range_vars, g_hash_table_unref);
   G_OBJECT_CLASS (auricle_music_row_parent_class)->finalize (object);
 }
 
@@ -150,10 +195,71 @@ auricle_music_row_update_result_name (AuricleMusicRow *self)
   gtk_label_set_label (self->music_row_result_name, result);
 }
 
+static void
+auricle_music_row_update_cover (AuricleMusicRow *self,
+                                GstTagList      *tags)
+{
+  g_autoptr(GstSample) sample = NULL;
+
+  // Keep the first image seen, which is usually the front cover.
+  if (self->cover != NULL || !gst_tag_list_get_sample (tags, GST_TAG_IMAGE, &sample))
+    return;
+
+  GstBuffer *buffer = gst_sample_get_buffer (sample);
+  if (buffer == NULL)
+    return;
+
+  gpointer data;
+  gsize size;
+  gst_buffer_extract_dup (buffer, 0, gst_buffer_get_size (buffer), &data, &size);
+  self->cover = g_bytes_new_take (data, size);
+}
+
+static void
+auricle_music_row_update_source_bitrate (AuricleMusicRow *self,
+                                         GstTagList      *tags)
+{
+  guint bitrate = 0;
+
+  // Parsers post the measured bitrate, containers tend to only know the nominal one.
+  if (!gst_tag_list_get_uint (tags, GST_TAG_BITRATE, &bitrate) &&
+      !gst_tag_list_get_uint (tags, GST_TAG_NOMINAL_BITRATE, &bitrate) &&
+      !gst_tag_list_get_uint (tags, GST_TAG_MAXIMUM_BITRATE, &bitrate))
+    return;
+
+  if (bitrate != 0)
+    self->source_bitrate = bitrate / 1000;
+}
+
+static void
+auricle_music_row_add_tag_labels (AuricleMusicRow *self,
+                                  const char      *name,
+                                  char           **values)
+{
+  g_autofree char *values_str = g_strjoinv (",", values);
+
+  GtkWidget *name_label = gtk_label_new (name);
+  GtkWidget *values_label = gtk_label_new (values_str);
+
+  gtk_widget_set_halign (name_label, GTK_ALIGN_END);
+  gtk_widget_set_halign (values_label, GTK_ALIGN_START);
+
+  gtk_grid_attach_next_to (self->music_row_tag_grid, name_label, NULL, GTK_POS_BOTTOM, 1, 1);
+  gtk_grid_attach_next_to (self->music_row_tag_grid, values_label, name_label, GTK_POS_RIGHT, 1, 1);
+}
+
 static void
 auricle_music_row_add_tags (AuricleMusicRow *self,
                             GstTagList      *tags)
 {
+  auricle_music_row_update_source_bitrate (self, tags);
+
+  // Once playing through for the loudness, the tags are only reposted with updated bitrates.
+  if (self->tags_scanned)
+    return;
+
+  auricle_music_row_update_cover (self, tags);
+
   int ntags = gst_tag_list_n_tags (tags);
 
   for (int i = 0; i < ntags; i++)
@@ -175,22 +281,173 @@ auricle_music_row_add_tags (AuricleMusicRow *self,
 
       g_ptr_array_add (values, NULL);
 
+      if (self->range_vars != NULL && g_hash_table_contains (self->range_vars, name))
+        continue;
+
       g_hash_table_replace (self->template_vars, g_strdup (name), g_strdupv ((gchar **)values->pdata));
+      auricle_music_row_add_tag_labels (self, name, (gchar **)values->pdata);
+    }
+
+  gtk_widget_show_all (GTK_WIDGET (self->music_row_tag_grid));
+  auricle_music_row_update_result_name (self);
+}
+
+static void
+auricle_music_row_update_source_caps (AuricleMusicRow     *self,
+                                      GstStreamCollection *collection)
+{
+  for (guint i = 0; i < gst_stream_collection_get_size (collection); i++)
+    {
+      GstStream *stream = gst_stream_collection_get_stream (collection, i);
+      if (!(gst_stream_get_stream_type (stream) & GST_STREAM_TYPE_AUDIO))
+        continue;
+
+      g_autoptr(GstCaps) caps = gst_stream_get_caps (stream);
+      if (caps != NULL)
+        {
+          gst_caps_replace (&self->source_caps, caps);
+          return;
+        }
+    }
+}
+
+static GstFlowReturn
+on_loudness_sample (GstAppSink *appsink,
+                    gpointer    udata)
+{
+  AuricleMusicRow *self = AURICLE_MUSIC_ROW (udata);
 
-      g_autofree char *values_str = g_strjoinv (",", (gchar **)values->pdata);
+  g_autoptr(GstSample) sample = gst_app_sink_pull_sample (appsink);
+  if (sample == NULL)
+    return GST_FLOW_EOS;
 
-      GtkWidget *name_label = gtk_label_new (name);
-      GtkWidget *values_label = gtk_label_new (values_str);
+  if (self->loudness == NULL)
+    {
+      GstStructure *structure = gst_caps_get_structure (gst_sample_get_caps (sample), 0);
+      int rate = 0, channels = 0;
+      if (!gst_structure_get_int (structure, "rate", &rate) ||
+          !gst_structure_get_int (structure, "channels", &channels))
+        return GST_FLOW_NOT_NEGOTIATED;
+
+      self->loudness = auricle_loudness_new (rate, channels);
+      self->loudness_rate = rate;
+    }
 
-      gtk_widget_set_halign (name_label, GTK_ALIGN_END);
-      gtk_widget_set_halign (values_label, GTK_ALIGN_START);
+  GstBuffer *buffer = gst_sample_get_buffer (sample);
+  GstMapInfo map;
+  if (!gst_buffer_map (buffer, &map, GST_MAP_READ))
+    return GST_FLOW_ERROR;
 
-      gtk_grid_attach_next_to (self->music_row_tag_grid, name_label, NULL, GTK_POS_BOTTOM, 1, 1);
-      gtk_grid_attach_next_to (self->music_row_tag_grid, values_label, name_label, GTK_POS_RIGHT, 1, 1);
+  // The caps filter in front of the sink guarantees interleaved floats.
+  gsize channels = auricle_loudness_get_channels (self->loudness);
+  gsize first = 0, last = map.size / sizeof (float) / channels;
+
+  // Tracks from a CUE sheet only count the audio within their range. The scan was seeked to it, but
+  // decoders may still hand over a bit from around its edges.
+  GstClockTime pts = GST_BUFFER_PTS (buffer);
+  if (GST_CLOCK_TIME_IS_VALID (self->range_start) && GST_CLOCK_TIME_IS_VALID (pts))
+    {
+      if (pts < self->range_start)
+        first = MIN (gst_util_uint64_scale (self->range_start - pts, self->loudness_rate, GST_SECOND), last);
+      if (GST_CLOCK_TIME_IS_VALID (self->range_end))
+        last = pts < self->range_end
+               ? MIN (gst_util_uint64_scale (self->range_end - pts, self->loudness_rate, GST_SECOND), last)
+               : 0;
     }
 
-  gtk_widget_show_all (GTK_WIDGET (self->music_row_tag_grid));
-  auricle_music_row_update_result_name (self);
+  if (last > first)
+    auricle_loudness_add_samples (self->loudness, (const float *) map.data + first * channels, last - first);
+  gst_buffer_unmap (buffer, &map);
+
+  return GST_FLOW_OK;
+}
+
+static gboolean on_bus_message (GstBus     *bus,
+                                GstMessage *message,
+                                gpointer    udata);
+
+static void
+auricle_music_row_run_loudness (AuricleMusicRow *self)
+{
+  self->measuring_loudness = TRUE;
+  n_measuring++;
+  if (self->bus_watch_id == 0)
+    self->bus_watch_id = gst_bus_add_watch (GST_ELEMENT_BUS (self->pipeline), on_bus_message, self);
+
+  // Tracks sharing a file each only decode their own part of it, so between them the file is
+  // decoded once. The stop position ends the scan with an EOS.
+  if (GST_CLOCK_TIME_IS_VALID (self->range_start))
+    gst_element_seek (self->pipeline, 1.0, GST_FORMAT_TIME, GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_ACCURATE,
+                      GST_SEEK_TYPE_SET, self->range_start,
+                      GST_CLOCK_TIME_IS_VALID (self->range_end) ? GST_SEEK_TYPE_SET : GST_SEEK_TYPE_NONE,
+                      self->range_end);
+
+  gst_element_set_state (self->pipeline, GST_STATE_PLAYING);
+}
+
+/* Starts the waiting measurements that there's room for. */
+static void
+auricle_music_row_run_waiting_loudness (void)
+{
+  while (n_measuring < g_get_num_processors () && !g_queue_is_empty (&waiting_rows))
+    {
+      AuricleMusicRow *row = g_queue_pop_head (&waiting_rows);
+      row->waiting_for_loudness = FALSE;
+      auricle_music_row_run_loudness (row);
+    }
+}
+
+/* Plays the rest of the tag scan pipeline through the loudness measurement, if it's wanted and
+   hasn't happened yet, once there's room for it. Returns whether the measurement is running or
+   waiting to. */
+static gboolean
+auricle_music_row_start_loudness (AuricleMusicRow *self)
+{
+  if (self->measuring_loudness || self->waiting_for_loudness)
+    return TRUE;
+  if (!self->measure_loudness || self->has_loudness || !self->tags_scanned || self->pipeline == NULL)
+    return FALSE;
+
+  self->waiting_for_loudness = TRUE;
+  g_queue_push_tail (&waiting_rows, self);
+  auricle_music_row_run_waiting_loudness ();
+  return TRUE;
+}
+
+/* Gives up the row's place in the queue, or its running measurement's turn to the next row. */
+static void
+auricle_music_row_stop_loudness (AuricleMusicRow *self)
+{
+  if (self->waiting_for_loudness)
+    {
+      g_queue_remove (&waiting_rows, self);
+      self->waiting_for_loudness = FALSE;
+    }
+
+  if (self->measuring_loudness)
+    {
+      self->measuring_loudness = FALSE;
+      n_measuring--;
+      auricle_music_row_run_waiting_loudness ();
+    }
+}
+
+static void
+auricle_music_row_finish_loudness (AuricleMusicRow *self)
+{
+  auricle_music_row_stop_loudness (self);
+  gst_element_set_state (self->pipeline, GST_STATE_NULL);
+  g_clear_pointer (&self->pipeline, gst_object_unref);
+
+  if (self->loudness == NULL)
+    return;
+
+  self->has_loudness = TRUE;
+  self->integrated_loudness = auricle_loudness_get_integrated (self->loudness);
+  self->true_peak = auricle_loudness_get_true_peak (self->loudness);
+  g_clear_pointer (&self->loudness, auricle_loudness_free);
+
+  g_info ("%s: %.1f LUFS, %.1f dBTP", self->path, self->integrated_loudness, self->true_peak);
 }
 
 static gboolean
@@ -209,10 +466,32 @@ on_bus_message (GstBus     *bus,
       gst_message_parse_error (message, &error, NULL);
       basename = g_path_get_basename (self->path);
       auricle_show_notification ("Pipeline for %s tags got error: %s", basename, error->message);
-      // Fallthrough.
+      self->tags_scanned = TRUE;
+      auricle_music_row_stop_loudness (self);
+      self->bus_watch_id = 0;
+      return FALSE;
     case GST_MESSAGE_ASYNC_DONE:
+      if (self->measuring_loudness)
+        break;
+
+      self->tags_scanned = TRUE;
+      gst_element_query_duration (self->pipeline, GST_FORMAT_TIME, (gint64 *) &self->duration);
+      if (auricle_music_row_start_loudness (self))
+        break;
+
+      self->bus_watch_id = 0;
+      return FALSE;
+    case GST_MESSAGE_EOS:
       self->bus_watch_id = 0;
+      auricle_music_row_finish_loudness (self);
       return FALSE;
+    case GST_MESSAGE_STREAM_COLLECTION:
+      {
+        g_autoptr(GstStreamCollection) collection = NULL;
+        gst_message_parse_stream_collection (message, &collection);
+        auricle_music_row_update_source_caps (self, collection);
+      }
+      break;
     case GST_MESSAGE_TAG:
       gst_message_parse_tag (message, &tags);
       auricle_music_row_add_tags (self, tags);
@@ -232,16 +511,24 @@ auricle_music_row_update_tags (AuricleMusicRow *self)
 
   self->bus_watch_id = gst_bus_add_watch (GST_ELEMENT_BUS (self->pipeline), on_bus_message, self);
 
-  GstElement *src = gst_element_factory_make ("filesrc", NULL);
-  g_object_set (src, "location", self->path, NULL);
+  GstElement *src = auricle_file_source_new (self->path);
 
   GstElement *typefind = gst_element_factory_make ("typefind", NULL);
   GstElement *dec = gst_element_factory_make ("decodebin3", NULL);
-  GstElement *sink = gst_element_factory_make ("fakesink", NULL);
+  GstElement *conv = gst_element_factory_make ("audioconvert", NULL);
+  GstElement *sink = gst_element_factory_make ("appsink", NULL);
+
+  g_autoptr(GstCaps) caps = gst_caps_from_string ("audio/x-raw, format=" NATIVE_F32 ", layout=interleaved");
+  g_object_set (sink, "caps", caps,
+                      "sync", FALSE, NULL);
 
-  gst_bin_add_many (GST_BIN (self->pipeline), src, typefind, dec, sink, NULL);
-  gst_element_link_many (src, typefind, dec, sink, NULL);
-  g_signal_connect (dec, "pad-added", G_CALLBACK (on_dec_pad_added), sink);
+  GstAppSinkCallbacks callbacks = { .new_sample = on_loudness_sample };
+  gst_app_sink_set_callbacks (GST_APP_SINK (sink), &callbacks, self, NULL);
+
+  gst_bin_add_many (GST_BIN (self->pipeline), src, typefind, dec, conv, sink, NULL);
+  gst_element_link_many (src, typefind, dec, NULL);
+  gst_element_link (conv, sink);
+  g_signal_connect (dec, "pad-added", G_CALLBACK (on_dec_pad_added), conv);
 
   gst_element_set_state (self->pipeline, GST_STATE_PAUSED);
 }
@@ -266,6 +553,9 @@ auricle_music_row_get_property (GObject    *object,
     case PROP_TEMPLATE_OVERRIDE:
       g_value_set_string (value, self->template_override);
       break;
+    case PROP_MEASURE_LOUDNESS:
+      g_value_set_boolean (value, self->measure_loudness);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
     }
@@ -329,6 +619,13 @@ auricle_music_row_set_property (GObject      *object,
 
       auricle_music_row_update_result_name (self);
       break;
+    case PROP_MEASURE_LOUDNESS:
+      self->measure_loudness = g_value_get_boolean (value);
+      if (self->measure_loudness)
+        auricle_music_row_start_loudness (self);
+      else if (self->waiting_for_loudness)
+        auricle_music_row_stop_loudness (self);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
     }
@@ -386,6 +683,16 @@ auricle_music_row_class_init (AuricleMusicRowClass *klass)
   g_object_class_install_property (object_class, PROP_TEMPLATE_OVERRIDE,
                                    properties [PROP_TEMPLATE_OVERRIDE]);
 
+  properties [PROP_MEASURE_LOUDNESS] =
+    g_param_spec_boolean ("measure-loudness",
+                          "Measure loudness",
+                          "Whether to measure the track's loudness after scanning its tags",
+                          FALSE,
+                          (G_PARAM_READWRITE |
+                           G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (object_class, PROP_MEASURE_LOUDNESS,
+                                   properties [PROP_MEASURE_LOUDNESS]);
+
   signals [DELETE_REQUESTED] =
     g_signal_new ("delete-requested",
                   G_TYPE_FROM_CLASS (klass),
@@ -413,6 +720,9 @@ auricle_music_row_init (AuricleMusicRow *self)
   gtk_widget_init_template (GTK_WIDGET (self));
 
   self->template_vars = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+  self->duration = GST_CLOCK_TIME_NONE;
+  self->range_start = GST_CLOCK_TIME_NONE;
+  self->range_end = GST_CLOCK_TIME_NONE;
 
   g_signal_connect (self->music_row_delete, "clicked", G_CALLBACK (on_delete_clicked), self);
   g_object_bind_property (self->music_row_override_switch, "active", self->music_row_override_revealer, "reveal-child", 0);
@@ -431,6 +741,105 @@ auricle_music_row_get_result_name (AuricleMusicRow *self)
   return gtk_label_get_text (self->music_row_result_name);
 }
 
+GBytes *
+auricle_music_row_get_cover (AuricleMusicRow *self)
+{
+  return self->cover;
+}
+
+guint
+auricle_music_row_get_source_bitrate (AuricleMusicRow *self)
+{
+  return self->source_bitrate;
+}
+
+/* Limits the row to part of its file, with the given template variables replacing the file's tags. */
+void
+auricle_music_row_set_range (AuricleMusicRow *self,
+                             GstClockTime     start,
+                             GstClockTime     end,
+                             GHashTable      *template_vars)
+{
+  self->range_start = start;
+  self->range_end = end;
+
+  g_clear_pointer (&self->range_vars, g_hash_table_unref);
+  self->range_vars = g_hash_table_ref (template_vars);
+
+  GHashTableIter iter;
+  gpointer key, value;
+  g_hash_table_iter_init (&iter, template_vars);
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    {
+      g_hash_table_replace (self->template_vars, g_strdup (key), g_strdupv (value));
+      auricle_music_row_add_tag_labels (self, key, value);
+    }
+
+  gtk_widget_show_all (GTK_WIDGET (self->music_row_tag_grid));
+
+  char **name = g_hash_table_lookup (template_vars, "name");
+  if (name != NULL)
+    gtk_label_set_text (self->music_row_basename, name[0]);
+
+  auricle_music_row_update_result_name (self);
+}
+
+gboolean
+auricle_music_row_get_range (AuricleMusicRow *self,
+                             GstClockTime    *start,
+                             GstClockTime    *end)
+{
+  if (!GST_CLOCK_TIME_IS_VALID (self->range_start))
+    return FALSE;
+
+  *start = self->range_start;
+  *end = self->range_end;
+  return TRUE;
+}
+
+GstClockTime
+auricle_music_row_get_duration (AuricleMusicRow *self)
+{
+  return self->duration;
+}
+
+GstCaps *
+auricle_music_row_get_source_caps (AuricleMusicRow *self)
+{
+  return self->source_caps;
+}
+
+/* Returns the integrated loudness in LUFS and the true peak in dBTP, once they've been measured. */
+gboolean
+auricle_music_row_get_loudness (AuricleMusicRow *self,
+                                double          *integrated_loudness,
+                                double          *true_peak)
+{
+  if (!self->has_loudness)
+    return FALSE;
+
+  *integrated_loudness = self->integrated_loudness;
+  *true_peak = self->true_peak;
+  return TRUE;
+}
+
+GHashTable *
+auricle_music_row_dup_template_vars (AuricleMusicRow *self)
+{
+  GHashTable *result = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_strfreev);
+
+  GHashTableIter iter;
+  gpointer key, value;
+  g_hash_table_iter_init (&iter, self->template_vars);
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    g_hash_table_replace (result, g_strdup (key), g_strdupv (value));
+
+  // Let other templates (e.g. captions) refer to the final output name.
+  g_hash_table_replace (result, g_strdup ("result"), strv_new_with_value (auricle_music_row_get_result_name (self)));
+
+  return result;
+}
+
 void
 auricle_music_row_toggle (AuricleMusicRow *self)
 {
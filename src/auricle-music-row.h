@@ -21,6 +21,7 @@
 #pragma once
 
 #include <gtk/gtk.h>
+#include <gst/gst.h>
 
 G_BEGIN_DECLS
 
@@ -33,6 +34,25 @@ AuricleMusicRow *auricle_music_row_new (const char *path);
 const char *auricle_music_row_get_path        (AuricleMusicRow *row);
 const char *auricle_music_row_get_result_name (AuricleMusicRow *row);
 
+GBytes     *auricle_music_row_get_cover         (AuricleMusicRow *row);
+GHashTable *auricle_music_row_dup_template_vars (AuricleMusicRow *row);
+guint       auricle_music_row_get_source_bitrate (AuricleMusicRow *row);
+
+void     auricle_music_row_set_range (AuricleMusicRow *row,
+                                      GstClockTime     start,
+                                      GstClockTime     end,
+                                      GHashTable      *template_vars);
+gboolean auricle_music_row_get_range (AuricleMusicRow *row,
+                                      GstClockTime    *start,
+                                      GstClockTime    *end);
+
+GstClockTime auricle_music_row_get_duration    (AuricleMusicRow *row);
+GstCaps     *auricle_music_row_get_source_caps (AuricleMusicRow *row);
+
+gboolean    auricle_music_row_get_loudness       (AuricleMusicRow *row,
+                                                  double          *integrated_loudness,
+                                                  double          *true_peak);
+
 void auricle_music_row_toggle (AuricleMusicRow *row);
 
 G_END_DECLS
@@ -18,9 +18,12 @@
  * SPDX-License-Identifier: GPL-3.0-or-later
  */
 
+#include "auricle-archive.h"
+#include "auricle-cue-sheet.h"
 #include "auricle-music-file.h"
 #include "auricle-music-table.h"
 #include "auricle-music-row.h"
+#include "auricle-utils.h"
 
 struct _AuricleMusicTable
 {
@@ -29,16 +32,19 @@ struct _AuricleMusicTable
   GtkListBox *music_list_box;
   GtkLabel   *music_list_placeholder;
   GtkEntry   *music_list_template;
+
+  gboolean    measure_loudness;
 };
 
 G_DEFINE_TYPE (AuricleMusicTable, auricle_music_table, GTK_TYPE_GRID)
 
-/* enum { */
-/*   PROP_0, */
-/*   N_PROPS */
-/* }; */
+enum {
+  PROP_0,
+  PROP_MEASURE_LOUDNESS,
+  N_PROPS
+};
 
-/* static GParamSpec *properties [N_PROPS]; */
+static GParamSpec *properties [N_PROPS];
 
 enum {
   SIGNAL_0,
@@ -68,10 +74,13 @@ auricle_music_table_get_property (GObject    *object,
                                   GValue     *value,
                                   GParamSpec *pspec)
 {
-  /* AuricleMusicTable *self = AURICLE_MUSIC_TABLE (object); */
+  AuricleMusicTable *self = AURICLE_MUSIC_TABLE (object);
 
   switch (prop_id)
     {
+    case PROP_MEASURE_LOUDNESS:
+      g_value_set_boolean (value, self->measure_loudness);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
     }
@@ -83,10 +92,13 @@ auricle_music_table_set_property (GObject      *object,
                                   const GValue *value,
                                   GParamSpec   *pspec)
 {
-  /* AuricleMusicTable *self = AURICLE_MUSIC_TABLE (object); */
+  AuricleMusicTable *self = AURICLE_MUSIC_TABLE (object);
 
   switch (prop_id)
     {
+    case PROP_MEASURE_LOUDNESS:
+      self->measure_loudness = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
     }
@@ -101,6 +113,16 @@ auricle_music_table_class_init (AuricleMusicTableClass *klass)
   object_class->get_property = auricle_music_table_get_property;
   object_class->set_property = auricle_music_table_set_property;
 
+  properties [PROP_MEASURE_LOUDNESS] =
+    g_param_spec_boolean ("measure-loudness",
+                          "Measure loudness",
+                          "Whether the tracks' loudness is measured along with their tags",
+                          FALSE,
+                          (G_PARAM_READWRITE |
+                           G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (object_class, PROP_MEASURE_LOUDNESS,
+                                   properties [PROP_MEASURE_LOUDNESS]);
+
   GtkWidgetClass *widget_class = GTK_WIDGET_CLASS (klass);
 
   gtk_widget_class_set_template_from_resource (widget_class, "/com/refi64/Auricle/auricle-music-table.ui");
@@ -149,6 +171,62 @@ on_row_delete_requested (AuricleMusicRow *row,
   g_signal_emit (self, signals[FILES_CHANGED], 0, -1);
 }
 
+static AuricleMusicRow *
+auricle_music_table_add_row (AuricleMusicTable *self,
+                             const char        *path)
+{
+  AuricleMusicRow *row = auricle_music_row_new (path);
+  g_object_bind_property (self->music_list_template, "text", row, "template", G_BINDING_SYNC_CREATE);
+  g_object_bind_property (self, "measure-loudness", row, "measure-loudness", G_BINDING_SYNC_CREATE);
+  g_signal_connect (row, "delete-requested", G_CALLBACK (on_row_delete_requested), self);
+  gtk_container_add (GTK_CONTAINER (self->music_list_box), GTK_WIDGET (row));
+  return row;
+}
+
+/* Adds a row for each track of a CUE sheet, returning how many there were. */
+static int
+auricle_music_table_add_cue_sheet (AuricleMusicTable *self,
+                                   const char        *path)
+{
+  g_autoptr(GError) error = NULL;
+  g_autoptr(GPtrArray) tracks = auricle_cue_sheet_load (path, &error);
+  if (tracks == NULL)
+    {
+      g_autofree char *basename = g_path_get_basename (path);
+      auricle_show_notification ("Failed to read %s: %s", basename, error->message);
+      return 0;
+    }
+
+  for (guint i = 0; i < tracks->len; i++)
+    {
+      AuricleCueTrack *track = g_ptr_array_index (tracks, i);
+      AuricleMusicRow *row = auricle_music_table_add_row (self, track->path);
+      auricle_music_row_set_range (row, track->start, track->end, track->template_vars);
+    }
+
+  return tracks->len;
+}
+
+/* Adds a row for each audio file in an archive, returning how many there were. */
+static int
+auricle_music_table_add_archive (AuricleMusicTable *self,
+                                 const char        *path)
+{
+  g_autoptr(GError) error = NULL;
+  g_autoptr(GPtrArray) members = auricle_archive_list (path, &error);
+  if (members == NULL)
+    {
+      g_autofree char *basename = g_path_get_basename (path);
+      auricle_show_notification ("Failed to read %s: %s", basename, error->message);
+      return 0;
+    }
+
+  for (guint i = 0; i < members->len; i++)
+    auricle_music_table_add_row (self, g_ptr_array_index (members, i));
+
+  return members->len;
+}
+
 void
 auricle_music_table_add_tracks (AuricleMusicTable *self,
                                 GSList *filenames)
@@ -157,10 +235,19 @@ auricle_music_table_add_tracks (AuricleMusicTable *self,
 
   for (GSList *l = filenames; l != NULL; l = l->next)
     {
-      AuricleMusicRow *row = auricle_music_row_new (l->data);
-      g_object_bind_property (self->music_list_template, "text", row, "template", G_BINDING_SYNC_CREATE);
-      g_signal_connect (row, "delete-requested", G_CALLBACK (on_row_delete_requested), self);
-      gtk_container_add (GTK_CONTAINER (self->music_list_box), GTK_WIDGET (row));
+      g_autofree char *lower = g_ascii_strdown (l->data, -1);
+      if (g_str_has_suffix (lower, ".cue"))
+        {
+          added += auricle_music_table_add_cue_sheet (self, l->data);
+          continue;
+        }
+      else if (auricle_archive_has_archive_name (l->data))
+        {
+          added += auricle_music_table_add_archive (self, l->data);
+          continue;
+        }
+
+      auricle_music_table_add_row (self, l->data);
       added++;
     }
 
@@ -174,6 +261,30 @@ auricle_music_table_is_empty (AuricleMusicTable *self)
   return children == NULL;
 }
 
+static AuricleMusicFile *
+create_file_for_row (AuricleMusicRow *row)
+{
+  AuricleMusicFile *file = auricle_music_file_new (auricle_music_row_get_path (row),
+                                                   auricle_music_row_get_result_name (row));
+
+  g_autoptr(GHashTable) template_vars = auricle_music_row_dup_template_vars (row);
+  auricle_music_file_set_template_vars (file, template_vars);
+  auricle_music_file_set_cover (file, auricle_music_row_get_cover (row));
+  auricle_music_file_set_source_bitrate (file, auricle_music_row_get_source_bitrate (row));
+  auricle_music_file_set_duration (file, auricle_music_row_get_duration (row));
+  auricle_music_file_set_source_caps (file, auricle_music_row_get_source_caps (row));
+
+  GstClockTime start, end;
+  if (auricle_music_row_get_range (row, &start, &end))
+    auricle_music_file_set_range (file, start, end);
+
+  double integrated_loudness, true_peak;
+  if (auricle_music_row_get_loudness (row, &integrated_loudness, &true_peak))
+    auricle_music_file_set_loudness (file, integrated_loudness, true_peak);
+
+  return file;
+}
+
 GList *
 auricle_music_table_get_files (AuricleMusicTable *self)
 {
@@ -181,13 +292,22 @@ auricle_music_table_get_files (AuricleMusicTable *self)
   GList *result = NULL;
 
   for (GList *l = children; l != NULL; l = l->next)
-    {
-      AuricleMusicRow *row = AURICLE_MUSIC_ROW (l->data);
-      AuricleMusicFile *file = auricle_music_file_new (auricle_music_row_get_path (row),
-                                                       auricle_music_row_get_result_name (row));
-      result = g_list_prepend (result, file);
-    }
+    result = g_list_prepend (result, create_file_for_row (AURICLE_MUSIC_ROW (l->data)));
+
+  // Keep the table's order, which album mode relies on.
+  return g_list_reverse (result);
+}
+
+// Returns the file for the selected row, falling back to the first one, or NULL if the table is empty.
+AuricleMusicFile *
+auricle_music_table_get_preview_file (AuricleMusicTable *self)
+{
+  GtkListBoxRow *row = gtk_list_box_get_selected_row (self->music_list_box);
+  if (row == NULL)
+    row = gtk_list_box_get_row_at_index (self->music_list_box, 0);
+  if (row == NULL)
+    return NULL;
 
-  return result;
+  return create_file_for_row (AURICLE_MUSIC_ROW (row));
 }
 
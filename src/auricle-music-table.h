@@ -21,6 +21,7 @@
 #pragma once
 
 #include <gtk/gtk.h>
+#include "auricle-music-file.h"
 
 G_BEGIN_DECLS
 
@@ -36,5 +37,7 @@ void auricle_music_table_add_tracks (AuricleMusicTable *self,
 gboolean auricle_music_table_is_empty  (AuricleMusicTable *self);
 GList   *auricle_music_table_get_files (AuricleMusicTable *self);
 
+AuricleMusicFile *auricle_music_table_get_preview_file (AuricleMusicTable *self);
+
 G_END_DECLS
 
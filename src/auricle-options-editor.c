@@ -19,6 +19,7 @@
  */
 
 #include "auricle-options-editor.h"
+#include "auricle-codecs.h"
 
 struct _AuricleOptionsEditor
 {
@@ -26,6 +27,30 @@ struct _AuricleOptionsEditor
 
   GtkFileChooserButton *options_output_directory;
   GtkComboBoxText      *options_audio_bitrate;
+  GtkEntry             *options_caption_template;
+  GtkSwitch            *options_track_artwork;
+  GtkSwitch            *options_audio_passthrough;
+  GtkSwitch            *options_match_source_bitrate;
+  GtkComboBoxText      *options_audio_max_sample_rate;
+  GtkComboBoxText      *options_audio_max_channels;
+  GtkSpinButton        *options_resample_quality;
+  GtkSwitch            *options_normalize_loudness;
+  GtkSpinButton        *options_target_loudness;
+  GtkSwitch            *options_parallel_encoding;
+  GtkSwitch            *options_album_mode;
+  GtkEntry             *options_renditions;
+  GtkSwitch            *options_fragmented_output;
+  GtkSwitch            *options_faststart;
+  GtkSwitch            *options_write_checksums;
+  GtkEntry             *options_output_command;
+  GtkSwitch            *options_skip_unchanged;
+  GtkComboBoxText      *options_render_mode;
+  GtkButton            *options_slideshow_images;
+  GtkSpinButton        *options_slideshow_dwell;
+  GtkComboBoxText      *options_video_encoder;
+  GtkComboBoxText      *options_video_preset;
+  GtkComboBoxText      *options_audio_encoder;
+  GtkComboBoxText      *options_muxer;
 
   AuricleRenderOptions *render_options;
 };
@@ -94,11 +119,14 @@ auricle_options_editor_set_property (GObject      *object,
     }
 }
 
+static void auricle_options_editor_constructed (GObject *object);
+
 static void
 auricle_options_editor_class_init (AuricleOptionsEditorClass *klass)
 {
   GObjectClass *object_class = G_OBJECT_CLASS (klass);
 
+  object_class->constructed = auricle_options_editor_constructed;
   object_class->finalize = auricle_options_editor_finalize;
   object_class->get_property = auricle_options_editor_get_property;
   object_class->set_property = auricle_options_editor_set_property;
@@ -108,6 +136,30 @@ auricle_options_editor_class_init (AuricleOptionsEditorClass *klass)
   gtk_widget_class_set_template_from_resource (widget_class, "/com/refi64/Auricle/auricle-options-editor.ui");
   gtk_widget_class_bind_template_child (widget_class, AuricleOptionsEditor, options_output_directory);
   gtk_widget_class_bind_template_child (widget_class, AuricleOptionsEditor, options_audio_bitrate);
+  gtk_widget_class_bind_template_child (widget_class, AuricleOptionsEditor, options_caption_template);
+  gtk_widget_class_bind_template_child (widget_class, AuricleOptionsEditor, options_track_artwork);
+  gtk_widget_class_bind_template_child (widget_class, AuricleOptionsEditor, options_audio_passthrough);
+  gtk_widget_class_bind_template_child (widget_class, AuricleOptionsEditor, options_match_source_bitrate);
+  gtk_widget_class_bind_template_child (widget_class, AuricleOptionsEditor, options_audio_max_sample_rate);
+  gtk_widget_class_bind_template_child (widget_class, AuricleOptionsEditor, options_audio_max_channels);
+  gtk_widget_class_bind_template_child (widget_class, AuricleOptionsEditor, options_resample_quality);
+  gtk_widget_class_bind_template_child (widget_class, AuricleOptionsEditor, options_normalize_loudness);
+  gtk_widget_class_bind_template_child (widget_class, AuricleOptionsEditor, options_target_loudness);
+  gtk_widget_class_bind_template_child (widget_class, AuricleOptionsEditor, options_parallel_encoding);
+  gtk_widget_class_bind_template_child (widget_class, AuricleOptionsEditor, options_album_mode);
+  gtk_widget_class_bind_template_child (widget_class, AuricleOptionsEditor, options_renditions);
+  gtk_widget_class_bind_template_child (widget_class, AuricleOptionsEditor, options_fragmented_output);
+  gtk_widget_class_bind_template_child (widget_class, AuricleOptionsEditor, options_faststart);
+  gtk_widget_class_bind_template_child (widget_class, AuricleOptionsEditor, options_write_checksums);
+  gtk_widget_class_bind_template_child (widget_class, AuricleOptionsEditor, options_output_command);
+  gtk_widget_class_bind_template_child (widget_class, AuricleOptionsEditor, options_skip_unchanged);
+  gtk_widget_class_bind_template_child (widget_class, AuricleOptionsEditor, options_render_mode);
+  gtk_widget_class_bind_template_child (widget_class, AuricleOptionsEditor, options_slideshow_images);
+  gtk_widget_class_bind_template_child (widget_class, AuricleOptionsEditor, options_slideshow_dwell);
+  gtk_widget_class_bind_template_child (widget_class, AuricleOptionsEditor, options_video_encoder);
+  gtk_widget_class_bind_template_child (widget_class, AuricleOptionsEditor, options_video_preset);
+  gtk_widget_class_bind_template_child (widget_class, AuricleOptionsEditor, options_audio_encoder);
+  gtk_widget_class_bind_template_child (widget_class, AuricleOptionsEditor, options_muxer);
 
   properties [PROP_RENDER_OPTIONS] =
     g_param_spec_object ("render-options",
@@ -141,6 +193,391 @@ on_bitrate_changed (GtkComboBox *combo_box,
   auricle_render_options_set_audio_bitrate (self->render_options, bitrate);
 }
 
+static void
+on_caption_template_changed (GtkEditable *editable,
+                             gpointer     udata)
+{
+  AuricleOptionsEditor *self = AURICLE_OPTIONS_EDITOR (udata);
+
+  const char *caption_template = gtk_entry_get_text (self->options_caption_template);
+  auricle_render_options_set_caption_template (self->render_options, caption_template);
+}
+
+static void
+on_track_artwork_notify (GtkSwitch  *sw,
+                         GParamSpec *pspec,
+                         gpointer    udata)
+{
+  AuricleOptionsEditor *self = AURICLE_OPTIONS_EDITOR (udata);
+
+  gboolean track_artwork = gtk_switch_get_active (self->options_track_artwork);
+  auricle_render_options_set_track_artwork (self->render_options, track_artwork);
+}
+
+static void
+on_audio_passthrough_notify (GtkSwitch  *sw,
+                             GParamSpec *pspec,
+                             gpointer    udata)
+{
+  AuricleOptionsEditor *self = AURICLE_OPTIONS_EDITOR (udata);
+
+  gboolean audio_passthrough = gtk_switch_get_active (self->options_audio_passthrough);
+  auricle_render_options_set_audio_passthrough (self->render_options, audio_passthrough);
+}
+
+static void
+on_parallel_encoding_notify (GtkSwitch  *sw,
+                             GParamSpec *pspec,
+                             gpointer    udata)
+{
+  AuricleOptionsEditor *self = AURICLE_OPTIONS_EDITOR (udata);
+
+  gboolean parallel_encoding = gtk_switch_get_active (self->options_parallel_encoding);
+  auricle_render_options_set_parallel_encoding (self->render_options, parallel_encoding);
+}
+
+static void
+on_renditions_changed (GtkEditable *editable,
+                       gpointer     udata)
+{
+  AuricleOptionsEditor *self = AURICLE_OPTIONS_EDITOR (udata);
+
+  const char *renditions = gtk_entry_get_text (self->options_renditions);
+  auricle_render_options_set_renditions (self->render_options, renditions);
+}
+
+static void
+on_album_mode_notify (GtkSwitch  *sw,
+                      GParamSpec *pspec,
+                      gpointer    udata)
+{
+  AuricleOptionsEditor *self = AURICLE_OPTIONS_EDITOR (udata);
+
+  gboolean album_mode = gtk_switch_get_active (self->options_album_mode);
+  auricle_render_options_set_album_mode (self->render_options, album_mode);
+}
+
+static void
+on_fragmented_output_notify (GtkSwitch  *sw,
+                             GParamSpec *pspec,
+                             gpointer    udata)
+{
+  AuricleOptionsEditor *self = AURICLE_OPTIONS_EDITOR (udata);
+
+  gboolean fragmented_output = gtk_switch_get_active (self->options_fragmented_output);
+  auricle_render_options_set_fragmented_output (self->render_options, fragmented_output);
+}
+
+static void
+on_faststart_notify (GtkSwitch  *sw,
+                     GParamSpec *pspec,
+                     gpointer    udata)
+{
+  AuricleOptionsEditor *self = AURICLE_OPTIONS_EDITOR (udata);
+
+  gboolean faststart = gtk_switch_get_active (self->options_faststart);
+  auricle_render_options_set_faststart (self->render_options, faststart);
+}
+
+static void
+on_write_checksums_notify (GtkSwitch  *sw,
+                           GParamSpec *pspec,
+                           gpointer    udata)
+{
+  AuricleOptionsEditor *self = AURICLE_OPTIONS_EDITOR (udata);
+
+  gboolean write_checksums = gtk_switch_get_active (self->options_write_checksums);
+  auricle_render_options_set_write_checksums (self->render_options, write_checksums);
+}
+
+static void
+on_output_command_changed (GtkEditable *editable,
+                           gpointer     udata)
+{
+  AuricleOptionsEditor *self = AURICLE_OPTIONS_EDITOR (udata);
+
+  const char *output_command = gtk_entry_get_text (self->options_output_command);
+  auricle_render_options_set_output_command (self->render_options, output_command);
+}
+
+static void
+on_skip_unchanged_notify (GtkSwitch  *sw,
+                          GParamSpec *pspec,
+                          gpointer    udata)
+{
+  AuricleOptionsEditor *self = AURICLE_OPTIONS_EDITOR (udata);
+
+  gboolean skip_unchanged = gtk_switch_get_active (self->options_skip_unchanged);
+  auricle_render_options_set_skip_unchanged (self->render_options, skip_unchanged);
+}
+
+static void
+on_match_source_bitrate_notify (GtkSwitch  *sw,
+                                GParamSpec *pspec,
+                                gpointer    udata)
+{
+  AuricleOptionsEditor *self = AURICLE_OPTIONS_EDITOR (udata);
+
+  gboolean match_source_bitrate = gtk_switch_get_active (self->options_match_source_bitrate);
+  auricle_render_options_set_match_source_bitrate (self->render_options, match_source_bitrate);
+}
+
+static void
+auricle_options_editor_update_sensitivity (AuricleOptionsEditor *self)
+{
+  const char *render_mode = gtk_combo_box_get_active_id (GTK_COMBO_BOX (self->options_render_mode));
+  gboolean slideshow = g_strcmp0 (render_mode, "slideshow") == 0;
+  gboolean video = g_strcmp0 (render_mode, "audio") != 0;
+
+  gtk_widget_set_sensitive (GTK_WIDGET (self->options_slideshow_images), slideshow);
+  gtk_widget_set_sensitive (GTK_WIDGET (self->options_slideshow_dwell), slideshow);
+  gtk_widget_set_sensitive (GTK_WIDGET (self->options_caption_template), video);
+  gtk_widget_set_sensitive (GTK_WIDGET (self->options_track_artwork), video);
+  gtk_widget_set_sensitive (GTK_WIDGET (self->options_video_encoder), video);
+  gtk_widget_set_sensitive (GTK_WIDGET (self->options_video_preset), video);
+
+  const char *max_sample_rate = gtk_combo_box_get_active_id (GTK_COMBO_BOX (self->options_audio_max_sample_rate));
+  gtk_widget_set_sensitive (GTK_WIDGET (self->options_resample_quality), g_strcmp0 (max_sample_rate, "0") != 0);
+
+  gboolean normalize_loudness = gtk_switch_get_active (self->options_normalize_loudness);
+  gtk_widget_set_sensitive (GTK_WIDGET (self->options_target_loudness), normalize_loudness);
+}
+
+static void
+on_normalize_loudness_notify (GtkSwitch  *sw,
+                              GParamSpec *pspec,
+                              gpointer    udata)
+{
+  AuricleOptionsEditor *self = AURICLE_OPTIONS_EDITOR (udata);
+
+  gboolean normalize_loudness = gtk_switch_get_active (self->options_normalize_loudness);
+  auricle_render_options_set_normalize_loudness (self->render_options, normalize_loudness);
+  auricle_options_editor_update_sensitivity (self);
+}
+
+static void
+on_target_loudness_changed (GtkSpinButton *spin_button,
+                            gpointer       udata)
+{
+  AuricleOptionsEditor *self = AURICLE_OPTIONS_EDITOR (udata);
+
+  double target_loudness = gtk_spin_button_get_value (self->options_target_loudness);
+  auricle_render_options_set_target_loudness (self->render_options, target_loudness);
+}
+
+static void
+on_audio_max_sample_rate_changed (GtkComboBox *combo_box,
+                                  gpointer     udata)
+{
+  AuricleOptionsEditor *self = AURICLE_OPTIONS_EDITOR (udata);
+
+  guint sample_rate = atoi (gtk_combo_box_get_active_id (combo_box));
+  auricle_render_options_set_audio_max_sample_rate (self->render_options, sample_rate);
+  auricle_options_editor_update_sensitivity (self);
+}
+
+static void
+on_audio_max_channels_changed (GtkComboBox *combo_box,
+                               gpointer     udata)
+{
+  AuricleOptionsEditor *self = AURICLE_OPTIONS_EDITOR (udata);
+
+  guint channels = atoi (gtk_combo_box_get_active_id (combo_box));
+  auricle_render_options_set_audio_max_channels (self->render_options, channels);
+}
+
+static void
+on_resample_quality_changed (GtkSpinButton *spin_button,
+                             gpointer       udata)
+{
+  AuricleOptionsEditor *self = AURICLE_OPTIONS_EDITOR (udata);
+
+  guint quality = gtk_spin_button_get_value_as_int (self->options_resample_quality);
+  auricle_render_options_set_resample_quality (self->render_options, quality);
+}
+
+static void
+on_render_mode_changed (GtkComboBox *combo_box,
+                        gpointer     udata)
+{
+  AuricleOptionsEditor *self = AURICLE_OPTIONS_EDITOR (udata);
+
+  const char *render_mode = gtk_combo_box_get_active_id (GTK_COMBO_BOX (self->options_render_mode));
+  g_autoptr(GEnumClass) enum_class = g_type_class_ref (AURICLE_TYPE_RENDER_MODE);
+  GEnumValue *value = g_enum_get_value_by_nick (enum_class, render_mode);
+  g_return_if_fail (value != NULL);
+
+  auricle_render_options_set_render_mode (self->render_options, value->value);
+  auricle_options_editor_update_sensitivity (self);
+}
+
+static void
+on_slideshow_images_clicked (GtkButton *button,
+                             gpointer   udata)
+{
+  AuricleOptionsEditor *self = AURICLE_OPTIONS_EDITOR (udata);
+
+  GtkWidget *toplevel = gtk_widget_get_toplevel (GTK_WIDGET (self));
+  g_autoptr(GtkFileChooserNative) chooser =
+    gtk_file_chooser_native_new ("Choose Slideshow Images",
+                                 GTK_IS_WINDOW (toplevel) ? GTK_WINDOW (toplevel) : NULL,
+                                 GTK_FILE_CHOOSER_ACTION_OPEN, "_Choose", "_Cancel");
+
+  GtkFileFilter *filter = gtk_file_filter_new ();
+  gtk_file_filter_set_name (filter, "Image files");
+  gtk_file_filter_add_mime_type (filter, "image/*");
+  gtk_file_chooser_add_filter (GTK_FILE_CHOOSER (chooser), filter);
+
+  gtk_file_chooser_set_select_multiple (GTK_FILE_CHOOSER (chooser), TRUE);
+
+  if (gtk_native_dialog_run (GTK_NATIVE_DIALOG (chooser)) != GTK_RESPONSE_ACCEPT)
+    return;
+
+  GSList *filenames = gtk_file_chooser_get_filenames (GTK_FILE_CHOOSER (chooser));
+  g_autoptr(GPtrArray) images = g_ptr_array_new_with_free_func (g_free);
+  for (GSList *l = filenames; l != NULL; l = l->next)
+    g_ptr_array_add (images, g_steal_pointer (&l->data));
+  g_ptr_array_add (images, NULL);
+  g_slist_free (filenames);
+
+  auricle_render_options_set_slideshow_images (self->render_options, (const char * const *) images->pdata);
+
+  g_autofree char *label = g_strdup_printf ("%u images", images->len - 1);
+  gtk_button_set_label (self->options_slideshow_images, label);
+}
+
+static void
+on_slideshow_dwell_changed (GtkSpinButton *spin_button,
+                            gpointer       udata)
+{
+  AuricleOptionsEditor *self = AURICLE_OPTIONS_EDITOR (udata);
+
+  guint dwell = gtk_spin_button_get_value_as_int (self->options_slideshow_dwell);
+  auricle_render_options_set_slideshow_dwell (self->render_options, dwell);
+}
+
+static void
+auricle_options_editor_populate_presets (AuricleOptionsEditor *self)
+{
+  const char *video_encoder = auricle_render_options_get_video_encoder (self->render_options);
+  const AuricleCodec *codec = auricle_codecs_find (AURICLE_CODEC_KIND_VIDEO, video_encoder);
+
+  gtk_combo_box_text_remove_all (self->options_video_preset);
+  gtk_combo_box_text_append (self->options_video_preset, "", "Default");
+
+  for (const char * const *preset = codec != NULL ? codec->presets : NULL; preset != NULL && *preset != NULL;
+       preset++)
+    gtk_combo_box_text_append (self->options_video_preset, *preset, *preset);
+
+  const char *video_preset = auricle_render_options_get_video_preset (self->render_options);
+  gtk_combo_box_set_active_id (GTK_COMBO_BOX (self->options_video_preset), video_preset ? video_preset : "");
+}
+
+static void
+on_video_encoder_changed (GtkComboBox *combo_box,
+                          gpointer     udata)
+{
+  AuricleOptionsEditor *self = AURICLE_OPTIONS_EDITOR (udata);
+
+  const char *id = gtk_combo_box_get_active_id (GTK_COMBO_BOX (self->options_video_encoder));
+  if (id == NULL || g_strcmp0 (id, auricle_render_options_get_video_encoder (self->render_options)) == 0)
+    return;
+
+  // The presets differ between encoders.
+  auricle_render_options_set_video_encoder (self->render_options, id);
+  auricle_render_options_set_video_preset (self->render_options, NULL);
+}
+
+static void
+on_video_preset_changed (GtkComboBox *combo_box,
+                         gpointer     udata)
+{
+  AuricleOptionsEditor *self = AURICLE_OPTIONS_EDITOR (udata);
+
+  const char *id = gtk_combo_box_get_active_id (GTK_COMBO_BOX (self->options_video_preset));
+  if (id == NULL)
+    return;
+
+  const char *preset = *id != '\0' ? id : NULL;
+  if (g_strcmp0 (preset, auricle_render_options_get_video_preset (self->render_options)) == 0)
+    return;
+
+  auricle_render_options_set_video_preset (self->render_options, preset);
+}
+
+/* The calibration can change the video settings behind the editor's back. */
+static void
+on_video_options_notify (AuricleRenderOptions *render_options,
+                         GParamSpec           *pspec,
+                         gpointer              udata)
+{
+  AuricleOptionsEditor *self = AURICLE_OPTIONS_EDITOR (udata);
+
+  gtk_combo_box_set_active_id (GTK_COMBO_BOX (self->options_video_encoder),
+                               auricle_render_options_get_video_encoder (render_options));
+  auricle_options_editor_populate_presets (self);
+}
+
+static void
+on_audio_encoder_changed (GtkComboBox *combo_box,
+                          gpointer     udata)
+{
+  AuricleOptionsEditor *self = AURICLE_OPTIONS_EDITOR (udata);
+
+  const char *id = gtk_combo_box_get_active_id (GTK_COMBO_BOX (self->options_audio_encoder));
+  auricle_render_options_set_audio_encoder (self->render_options, id);
+}
+
+static void
+on_muxer_changed (GtkComboBox *combo_box,
+                  gpointer     udata)
+{
+  AuricleOptionsEditor *self = AURICLE_OPTIONS_EDITOR (udata);
+
+  const char *id = gtk_combo_box_get_active_id (GTK_COMBO_BOX (self->options_muxer));
+  auricle_render_options_set_muxer (self->render_options, id);
+}
+
+/* Fills the combo box with the installed codecs of the given kind, leaving it on the current choice
+   when that one is installed. */
+static void
+populate_codecs (GtkComboBoxText  *combo_box,
+                 AuricleCodecKind  kind,
+                 const char       *active_id)
+{
+  g_autoptr(GPtrArray) codecs = auricle_codecs_list (kind);
+  for (guint i = 0; i < codecs->len; i++)
+    {
+      const AuricleCodec *codec = g_ptr_array_index (codecs, i);
+      gtk_combo_box_text_append (combo_box, codec->id, codec->name);
+    }
+
+  if (!gtk_combo_box_set_active_id (GTK_COMBO_BOX (combo_box), active_id))
+    gtk_combo_box_set_active (GTK_COMBO_BOX (combo_box), 0);
+}
+
+static void
+auricle_options_editor_constructed (GObject *object)
+{
+  AuricleOptionsEditor *self = AURICLE_OPTIONS_EDITOR (object);
+
+  G_OBJECT_CLASS (auricle_options_editor_parent_class)->constructed (object);
+
+  // The render options are only set after init, so these are filled in here.
+  populate_codecs (self->options_video_encoder, AURICLE_CODEC_KIND_VIDEO,
+                   auricle_render_options_get_video_encoder (self->render_options));
+  populate_codecs (self->options_audio_encoder, AURICLE_CODEC_KIND_AUDIO,
+                   auricle_render_options_get_audio_encoder (self->render_options));
+  populate_codecs (self->options_muxer, AURICLE_CODEC_KIND_MUXER,
+                   auricle_render_options_get_muxer (self->render_options));
+  auricle_options_editor_populate_presets (self);
+
+  g_signal_connect_object (self->render_options, "notify::video-encoder", G_CALLBACK (on_video_options_notify),
+                           self, 0);
+  g_signal_connect_object (self->render_options, "notify::video-preset", G_CALLBACK (on_video_options_notify),
+                           self, 0);
+}
+
 static void
 auricle_options_editor_init (AuricleOptionsEditor *self)
 {
@@ -148,5 +585,39 @@ auricle_options_editor_init (AuricleOptionsEditor *self)
 
   g_signal_connect (self->options_output_directory, "file-set", G_CALLBACK (on_file_set), self);
   g_signal_connect (self->options_audio_bitrate, "changed", G_CALLBACK (on_bitrate_changed), self);
+  g_signal_connect (self->options_caption_template, "changed", G_CALLBACK (on_caption_template_changed), self);
+  g_signal_connect (self->options_track_artwork, "notify::active", G_CALLBACK (on_track_artwork_notify), self);
+  g_signal_connect (self->options_audio_passthrough, "notify::active", G_CALLBACK (on_audio_passthrough_notify),
+                    self);
+  g_signal_connect (self->options_match_source_bitrate, "notify::active",
+                    G_CALLBACK (on_match_source_bitrate_notify), self);
+  g_signal_connect (self->options_audio_max_sample_rate, "changed", G_CALLBACK (on_audio_max_sample_rate_changed),
+                    self);
+  g_signal_connect (self->options_audio_max_channels, "changed", G_CALLBACK (on_audio_max_channels_changed), self);
+  g_signal_connect (self->options_resample_quality, "value-changed", G_CALLBACK (on_resample_quality_changed),
+                    self);
+  g_signal_connect (self->options_normalize_loudness, "notify::active", G_CALLBACK (on_normalize_loudness_notify),
+                    self);
+  g_signal_connect (self->options_target_loudness, "value-changed", G_CALLBACK (on_target_loudness_changed), self);
+  g_signal_connect (self->options_parallel_encoding, "notify::active", G_CALLBACK (on_parallel_encoding_notify),
+                    self);
+  g_signal_connect (self->options_album_mode, "notify::active", G_CALLBACK (on_album_mode_notify), self);
+  g_signal_connect (self->options_renditions, "changed", G_CALLBACK (on_renditions_changed), self);
+  g_signal_connect (self->options_fragmented_output, "notify::active", G_CALLBACK (on_fragmented_output_notify),
+                    self);
+  g_signal_connect (self->options_faststart, "notify::active", G_CALLBACK (on_faststart_notify), self);
+  g_signal_connect (self->options_write_checksums, "notify::active", G_CALLBACK (on_write_checksums_notify),
+                    self);
+  g_signal_connect (self->options_output_command, "changed", G_CALLBACK (on_output_command_changed), self);
+  g_signal_connect (self->options_skip_unchanged, "notify::active", G_CALLBACK (on_skip_unchanged_notify), self);
+  g_signal_connect (self->options_render_mode, "changed", G_CALLBACK (on_render_mode_changed), self);
+  g_signal_connect (self->options_slideshow_images, "clicked", G_CALLBACK (on_slideshow_images_clicked), self);
+  g_signal_connect (self->options_slideshow_dwell, "value-changed", G_CALLBACK (on_slideshow_dwell_changed), self);
+  g_signal_connect (self->options_video_encoder, "changed", G_CALLBACK (on_video_encoder_changed), self);
+  g_signal_connect (self->options_video_preset, "changed", G_CALLBACK (on_video_preset_changed), self);
+  g_signal_connect (self->options_audio_encoder, "changed", G_CALLBACK (on_audio_encoder_changed), self);
+  g_signal_connect (self->options_muxer, "changed", G_CALLBACK (on_muxer_changed), self);
+
+  auricle_options_editor_update_sensitivity (self);
 }
 
@@ -20,12 +20,59 @@
 
 #include "auricle-render-options.h"
 
+GType
+auricle_render_mode_get_type (void)
+{
+  static volatile gsize type_id = 0;
+
+  if (g_once_init_enter (&type_id))
+    {
+      static const GEnumValue values[] = {
+        { AURICLE_RENDER_MODE_STILL, "AURICLE_RENDER_MODE_STILL", "still" },
+        { AURICLE_RENDER_MODE_SLIDESHOW, "AURICLE_RENDER_MODE_SLIDESHOW", "slideshow" },
+        { AURICLE_RENDER_MODE_WAVEFORM, "AURICLE_RENDER_MODE_WAVEFORM", "waveform" },
+        { AURICLE_RENDER_MODE_SPECTRUM, "AURICLE_RENDER_MODE_SPECTRUM", "spectrum" },
+        { AURICLE_RENDER_MODE_AUDIO_ONLY, "AURICLE_RENDER_MODE_AUDIO_ONLY", "audio" },
+        { 0, NULL, NULL },
+      };
+
+      GType type = g_enum_register_static ("AuricleRenderMode", values);
+      g_once_init_leave (&type_id, type);
+    }
+
+  return type_id;
+}
+
 struct _AuricleRenderOptions
 {
   GObject parent_instance;
 
-  char *output_directory;
-  guint audio_bitrate;
+  char              *output_directory;
+  guint              audio_bitrate;
+  char              *caption_template;
+  gboolean           track_artwork;
+  AuricleRenderMode  render_mode;
+  guint              slideshow_dwell;
+  char             **slideshow_images;
+  char              *video_encoder;
+  char              *audio_encoder;
+  char              *muxer;
+  char              *video_preset;
+  gboolean           audio_passthrough;
+  gboolean           match_source_bitrate;
+  guint              audio_max_sample_rate;
+  guint              audio_max_channels;
+  guint              resample_quality;
+  gboolean           normalize_loudness;
+  double             target_loudness;
+  gboolean           parallel_encoding;
+  gboolean           album_mode;
+  char              *renditions;
+  gboolean           fragmented_output;
+  gboolean           faststart;
+  gboolean           write_checksums;
+  char              *output_command;
+  gboolean           skip_unchanged;
 };
 
 G_DEFINE_TYPE (AuricleRenderOptions, auricle_render_options, G_TYPE_OBJECT)
@@ -34,6 +81,30 @@ enum {
   PROP_0,
   PROP_OUTPUT_DIRECTORY,
   PROP_AUDIO_BITRATE,
+  PROP_CAPTION_TEMPLATE,
+  PROP_TRACK_ARTWORK,
+  PROP_RENDER_MODE,
+  PROP_SLIDESHOW_DWELL,
+  PROP_SLIDESHOW_IMAGES,
+  PROP_VIDEO_ENCODER,
+  PROP_AUDIO_ENCODER,
+  PROP_MUXER,
+  PROP_VIDEO_PRESET,
+  PROP_AUDIO_PASSTHROUGH,
+  PROP_MATCH_SOURCE_BITRATE,
+  PROP_AUDIO_MAX_SAMPLE_RATE,
+  PROP_AUDIO_MAX_CHANNELS,
+  PROP_RESAMPLE_QUALITY,
+  PROP_NORMALIZE_LOUDNESS,
+  PROP_TARGET_LOUDNESS,
+  PROP_PARALLEL_ENCODING,
+  PROP_ALBUM_MODE,
+  PROP_RENDITIONS,
+  PROP_FRAGMENTED_OUTPUT,
+  PROP_FASTSTART,
+  PROP_WRITE_CHECKSUMS,
+  PROP_OUTPUT_COMMAND,
+  PROP_SKIP_UNCHANGED,
   N_PROPS
 };
 
@@ -51,6 +122,14 @@ auricle_render_options_finalize (GObject *object)
   AuricleRenderOptions *self = (AuricleRenderOptions *)object;
 
   g_clear_pointer (&self->output_directory, g_free);
+  g_clear_pointer (&self->caption_template, g_free);
+  g_clear_pointer (&self->slideshow_images, g_strfreev);
+  g_clear_pointer (&self->video_encoder, g_free);
+  g_clear_pointer (&self->audio_encoder, g_free);
+  g_clear_pointer (&self->muxer, g_free);
+  g_clear_pointer (&self->video_preset, g_free);
+  g_clear_pointer (&self->renditions, g_free);
+  g_clear_pointer (&self->output_command, g_free);
 
   G_OBJECT_CLASS (auricle_render_options_parent_class)->finalize (object);
 }
@@ -76,6 +155,254 @@ auricle_render_options_set_audio_bitrate_notify (AuricleRenderOptions *self,
     g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_AUDIO_BITRATE]);
 }
 
+static void
+auricle_render_options_set_caption_template_notify (AuricleRenderOptions *self,
+                                                    const char           *caption_template,
+                                                    gboolean              notify)
+{
+  g_free (self->caption_template);
+  self->caption_template = g_strdup (caption_template);
+  if (notify)
+    g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_CAPTION_TEMPLATE]);
+}
+
+static void
+auricle_render_options_set_track_artwork_notify (AuricleRenderOptions *self,
+                                                 gboolean              track_artwork,
+                                                 gboolean              notify)
+{
+  self->track_artwork = track_artwork;
+  if (notify)
+    g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_TRACK_ARTWORK]);
+}
+
+static void
+auricle_render_options_set_render_mode_notify (AuricleRenderOptions *self,
+                                               AuricleRenderMode     render_mode,
+                                               gboolean              notify)
+{
+  self->render_mode = render_mode;
+  if (notify)
+    g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_RENDER_MODE]);
+}
+
+static void
+auricle_render_options_set_slideshow_dwell_notify (AuricleRenderOptions *self,
+                                                   guint                 slideshow_dwell,
+                                                   gboolean              notify)
+{
+  self->slideshow_dwell = slideshow_dwell;
+  if (notify)
+    g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_SLIDESHOW_DWELL]);
+}
+
+static void
+auricle_render_options_set_slideshow_images_notify (AuricleRenderOptions *self,
+                                                    const char * const   *slideshow_images,
+                                                    gboolean              notify)
+{
+  g_strfreev (self->slideshow_images);
+  self->slideshow_images = g_strdupv ((char **) slideshow_images);
+  if (notify)
+    g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_SLIDESHOW_IMAGES]);
+}
+
+static void
+auricle_render_options_set_video_encoder_notify (AuricleRenderOptions *self,
+                                                 const char           *video_encoder,
+                                                 gboolean              notify)
+{
+  g_free (self->video_encoder);
+  self->video_encoder = g_strdup (video_encoder);
+  if (notify)
+    g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_VIDEO_ENCODER]);
+}
+
+static void
+auricle_render_options_set_audio_encoder_notify (AuricleRenderOptions *self,
+                                                 const char           *audio_encoder,
+                                                 gboolean              notify)
+{
+  g_free (self->audio_encoder);
+  self->audio_encoder = g_strdup (audio_encoder);
+  if (notify)
+    g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_AUDIO_ENCODER]);
+}
+
+static void
+auricle_render_options_set_muxer_notify (AuricleRenderOptions *self,
+                                         const char           *muxer,
+                                         gboolean              notify)
+{
+  g_free (self->muxer);
+  self->muxer = g_strdup (muxer);
+  if (notify)
+    g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_MUXER]);
+}
+
+static void
+auricle_render_options_set_video_preset_notify (AuricleRenderOptions *self,
+                                                const char           *video_preset,
+                                                gboolean              notify)
+{
+  g_free (self->video_preset);
+  self->video_preset = g_strdup (video_preset);
+  if (notify)
+    g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_VIDEO_PRESET]);
+}
+
+static void
+auricle_render_options_set_audio_passthrough_notify (AuricleRenderOptions *self,
+                                                     gboolean              audio_passthrough,
+                                                     gboolean              notify)
+{
+  self->audio_passthrough = audio_passthrough;
+  if (notify)
+    g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_AUDIO_PASSTHROUGH]);
+}
+
+static void
+auricle_render_options_set_match_source_bitrate_notify (AuricleRenderOptions *self,
+                                                        gboolean              match_source_bitrate,
+                                                        gboolean              notify)
+{
+  self->match_source_bitrate = match_source_bitrate;
+  if (notify)
+    g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_MATCH_SOURCE_BITRATE]);
+}
+
+static void
+auricle_render_options_set_audio_max_sample_rate_notify (AuricleRenderOptions *self,
+                                                         guint                 audio_max_sample_rate,
+                                                         gboolean              notify)
+{
+  self->audio_max_sample_rate = audio_max_sample_rate;
+  if (notify)
+    g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_AUDIO_MAX_SAMPLE_RATE]);
+}
+
+static void
+auricle_render_options_set_audio_max_channels_notify (AuricleRenderOptions *self,
+                                                      guint                 audio_max_channels,
+                                                      gboolean              notify)
+{
+  self->audio_max_channels = audio_max_channels;
+  if (notify)
+    g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_AUDIO_MAX_CHANNELS]);
+}
+
+static void
+auricle_render_options_set_resample_quality_notify (AuricleRenderOptions *self,
+                                                    guint                 resample_quality,
+                                                    gboolean              notify)
+{
+  self->resample_quality = resample_quality;
+  if (notify)
+    g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_RESAMPLE_QUALITY]);
+}
+
+static void
+auricle_render_options_set_normalize_loudness_notify (AuricleRenderOptions *self,
+                                                      gboolean              normalize_loudness,
+                                                      gboolean              notify)
+{
+  self->normalize_loudness = normalize_loudness;
+  if (notify)
+    g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_NORMALIZE_LOUDNESS]);
+}
+
+static void
+auricle_render_options_set_target_loudness_notify (AuricleRenderOptions *self,
+                                                   double                target_loudness,
+                                                   gboolean              notify)
+{
+  self->target_loudness = target_loudness;
+  if (notify)
+    g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_TARGET_LOUDNESS]);
+}
+
+static void
+auricle_render_options_set_parallel_encoding_notify (AuricleRenderOptions *self,
+                                                     gboolean              parallel_encoding,
+                                                     gboolean              notify)
+{
+  self->parallel_encoding = parallel_encoding;
+  if (notify)
+    g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_PARALLEL_ENCODING]);
+}
+
+static void
+auricle_render_options_set_album_mode_notify (AuricleRenderOptions *self,
+                                              gboolean              album_mode,
+                                              gboolean              notify)
+{
+  self->album_mode = album_mode;
+  if (notify)
+    g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_ALBUM_MODE]);
+}
+
+static void
+auricle_render_options_set_renditions_notify (AuricleRenderOptions *self,
+                                              const char           *renditions,
+                                              gboolean              notify)
+{
+  g_free (self->renditions);
+  self->renditions = g_strdup (renditions);
+  if (notify)
+    g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_RENDITIONS]);
+}
+
+static void
+auricle_render_options_set_fragmented_output_notify (AuricleRenderOptions *self,
+                                                     gboolean              fragmented_output,
+                                                     gboolean              notify)
+{
+  self->fragmented_output = fragmented_output;
+  if (notify)
+    g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_FRAGMENTED_OUTPUT]);
+}
+
+static void
+auricle_render_options_set_faststart_notify (AuricleRenderOptions *self,
+                                             gboolean              faststart,
+                                             gboolean              notify)
+{
+  self->faststart = faststart;
+  if (notify)
+    g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_FASTSTART]);
+}
+
+static void
+auricle_render_options_set_write_checksums_notify (AuricleRenderOptions *self,
+                                                   gboolean              write_checksums,
+                                                   gboolean              notify)
+{
+  self->write_checksums = write_checksums;
+  if (notify)
+    g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_WRITE_CHECKSUMS]);
+}
+
+static void
+auricle_render_options_set_output_command_notify (AuricleRenderOptions *self,
+                                                  const char           *output_command,
+                                                  gboolean              notify)
+{
+  g_free (self->output_command);
+  self->output_command = g_strdup (output_command);
+  if (notify)
+    g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_OUTPUT_COMMAND]);
+}
+
+static void
+auricle_render_options_set_skip_unchanged_notify (AuricleRenderOptions *self,
+                                                  gboolean              skip_unchanged,
+                                                  gboolean              notify)
+{
+  self->skip_unchanged = skip_unchanged;
+  if (notify)
+    g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_SKIP_UNCHANGED]);
+}
+
 static void
 auricle_render_options_get_property (GObject    *object,
                                      guint       prop_id,
@@ -92,6 +419,78 @@ auricle_render_options_get_property (GObject    *object,
     case PROP_AUDIO_BITRATE:
       g_value_set_uint (value, self->audio_bitrate);
       break;
+    case PROP_CAPTION_TEMPLATE:
+      g_value_set_string (value, self->caption_template);
+      break;
+    case PROP_TRACK_ARTWORK:
+      g_value_set_boolean (value, self->track_artwork);
+      break;
+    case PROP_RENDER_MODE:
+      g_value_set_enum (value, self->render_mode);
+      break;
+    case PROP_SLIDESHOW_DWELL:
+      g_value_set_uint (value, self->slideshow_dwell);
+      break;
+    case PROP_SLIDESHOW_IMAGES:
+      g_value_set_boxed (value, self->slideshow_images);
+      break;
+    case PROP_VIDEO_ENCODER:
+      g_value_set_string (value, self->video_encoder);
+      break;
+    case PROP_AUDIO_ENCODER:
+      g_value_set_string (value, self->audio_encoder);
+      break;
+    case PROP_MUXER:
+      g_value_set_string (value, self->muxer);
+      break;
+    case PROP_VIDEO_PRESET:
+      g_value_set_string (value, self->video_preset);
+      break;
+    case PROP_AUDIO_PASSTHROUGH:
+      g_value_set_boolean (value, self->audio_passthrough);
+      break;
+    case PROP_MATCH_SOURCE_BITRATE:
+      g_value_set_boolean (value, self->match_source_bitrate);
+      break;
+    case PROP_AUDIO_MAX_SAMPLE_RATE:
+      g_value_set_uint (value, self->audio_max_sample_rate);
+      break;
+    case PROP_AUDIO_MAX_CHANNELS:
+      g_value_set_uint (value, self->audio_max_channels);
+      break;
+    case PROP_RESAMPLE_QUALITY:
+      g_value_set_uint (value, self->resample_quality);
+      break;
+    case PROP_NORMALIZE_LOUDNESS:
+      g_value_set_boolean (value, self->normalize_loudness);
+      break;
+    case PROP_TARGET_LOUDNESS:
+      g_value_set_double (value, self->target_loudness);
+      break;
+    case PROP_PARALLEL_ENCODING:
+      g_value_set_boolean (value, self->parallel_encoding);
+      break;
+    case PROP_ALBUM_MODE:
+      g_value_set_boolean (value, self->album_mode);
+      break;
+    case PROP_RENDITIONS:
+      g_value_set_string (value, self->renditions);
+      break;
+    case PROP_FRAGMENTED_OUTPUT:
+      g_value_set_boolean (value, self->fragmented_output);
+      break;
+    case PROP_FASTSTART:
+      g_value_set_boolean (value, self->faststart);
+      break;
+    case PROP_WRITE_CHECKSUMS:
+      g_value_set_boolean (value, self->write_checksums);
+      break;
+    case PROP_OUTPUT_COMMAND:
+      g_value_set_string (value, self->output_command);
+      break;
+    case PROP_SKIP_UNCHANGED:
+      g_value_set_boolean (value, self->skip_unchanged);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
     }
@@ -113,6 +512,78 @@ auricle_render_options_set_property (GObject      *object,
     case PROP_AUDIO_BITRATE:
       auricle_render_options_set_audio_bitrate_notify (self, g_value_get_uint (value), FALSE);
       break;
+    case PROP_CAPTION_TEMPLATE:
+      auricle_render_options_set_caption_template_notify (self, g_value_get_string (value), FALSE);
+      break;
+    case PROP_TRACK_ARTWORK:
+      auricle_render_options_set_track_artwork_notify (self, g_value_get_boolean (value), FALSE);
+      break;
+    case PROP_RENDER_MODE:
+      auricle_render_options_set_render_mode_notify (self, g_value_get_enum (value), FALSE);
+      break;
+    case PROP_SLIDESHOW_DWELL:
+      auricle_render_options_set_slideshow_dwell_notify (self, g_value_get_uint (value), FALSE);
+      break;
+    case PROP_SLIDESHOW_IMAGES:
+      auricle_render_options_set_slideshow_images_notify (self, g_value_get_boxed (value), FALSE);
+      break;
+    case PROP_VIDEO_ENCODER:
+      auricle_render_options_set_video_encoder_notify (self, g_value_get_string (value), FALSE);
+      break;
+    case PROP_AUDIO_ENCODER:
+      auricle_render_options_set_audio_encoder_notify (self, g_value_get_string (value), FALSE);
+      break;
+    case PROP_MUXER:
+      auricle_render_options_set_muxer_notify (self, g_value_get_string (value), FALSE);
+      break;
+    case PROP_VIDEO_PRESET:
+      auricle_render_options_set_video_preset_notify (self, g_value_get_string (value), FALSE);
+      break;
+    case PROP_AUDIO_PASSTHROUGH:
+      auricle_render_options_set_audio_passthrough_notify (self, g_value_get_boolean (value), FALSE);
+      break;
+    case PROP_MATCH_SOURCE_BITRATE:
+      auricle_render_options_set_match_source_bitrate_notify (self, g_value_get_boolean (value), FALSE);
+      break;
+    case PROP_AUDIO_MAX_SAMPLE_RATE:
+      auricle_render_options_set_audio_max_sample_rate_notify (self, g_value_get_uint (value), FALSE);
+      break;
+    case PROP_AUDIO_MAX_CHANNELS:
+      auricle_render_options_set_audio_max_channels_notify (self, g_value_get_uint (value), FALSE);
+      break;
+    case PROP_RESAMPLE_QUALITY:
+      auricle_render_options_set_resample_quality_notify (self, g_value_get_uint (value), FALSE);
+      break;
+    case PROP_NORMALIZE_LOUDNESS:
+      auricle_render_options_set_normalize_loudness_notify (self, g_value_get_boolean (value), FALSE);
+      break;
+    case PROP_TARGET_LOUDNESS:
+      auricle_render_options_set_target_loudness_notify (self, g_value_get_double (value), FALSE);
+      break;
+    case PROP_PARALLEL_ENCODING:
+      auricle_render_options_set_parallel_encoding_notify (self, g_value_get_boolean (value), FALSE);
+      break;
+    case PROP_ALBUM_MODE:
+      auricle_render_options_set_album_mode_notify (self, g_value_get_boolean (value), FALSE);
+      break;
+    case PROP_RENDITIONS:
+      auricle_render_options_set_renditions_notify (self, g_value_get_string (value), FALSE);
+      break;
+    case PROP_FRAGMENTED_OUTPUT:
+      auricle_render_options_set_fragmented_output_notify (self, g_value_get_boolean (value), FALSE);
+      break;
+    case PROP_FASTSTART:
+      auricle_render_options_set_faststart_notify (self, g_value_get_boolean (value), FALSE);
+      break;
+    case PROP_WRITE_CHECKSUMS:
+      auricle_render_options_set_write_checksums_notify (self, g_value_get_boolean (value), FALSE);
+      break;
+    case PROP_OUTPUT_COMMAND:
+      auricle_render_options_set_output_command_notify (self, g_value_get_string (value), FALSE);
+      break;
+    case PROP_SKIP_UNCHANGED:
+      auricle_render_options_set_skip_unchanged_notify (self, g_value_get_boolean (value), FALSE);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
     }
@@ -146,11 +617,263 @@ auricle_render_options_class_init (AuricleRenderOptionsClass *klass)
                         G_PARAM_STATIC_STRINGS));
   g_object_class_install_property (object_class, PROP_AUDIO_BITRATE,
                                    properties [PROP_AUDIO_BITRATE]);
+
+  properties [PROP_CAPTION_TEMPLATE] =
+    g_param_spec_string ("caption-template",
+                         "Caption template",
+                         "Template for the caption drawn onto the image, or empty for none",
+                         NULL,
+                         (G_PARAM_READWRITE |
+                          G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (object_class, PROP_CAPTION_TEMPLATE,
+                                   properties [PROP_CAPTION_TEMPLATE]);
+
+  properties [PROP_TRACK_ARTWORK] =
+    g_param_spec_boolean ("track-artwork",
+                          "Track artwork",
+                          "Use the cover art embedded in or next to each track instead of the chosen image, when available",
+                          FALSE,
+                          (G_PARAM_READWRITE |
+                           G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (object_class, PROP_TRACK_ARTWORK,
+                                   properties [PROP_TRACK_ARTWORK]);
+
+  properties [PROP_RENDER_MODE] =
+    g_param_spec_enum ("render-mode",
+                       "Render mode",
+                       "How the video track is produced",
+                       AURICLE_TYPE_RENDER_MODE,
+                       AURICLE_RENDER_MODE_STILL,
+                       (G_PARAM_READWRITE |
+                        G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (object_class, PROP_RENDER_MODE,
+                                   properties [PROP_RENDER_MODE]);
+
+  properties [PROP_SLIDESHOW_DWELL] =
+    g_param_spec_uint ("slideshow-dwell",
+                       "Slideshow dwell",
+                       "How many seconds each slideshow image is shown for",
+                       1, 3600, 10,
+                       (G_PARAM_READWRITE |
+                        G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (object_class, PROP_SLIDESHOW_DWELL,
+                                   properties [PROP_SLIDESHOW_DWELL]);
+
+  properties [PROP_SLIDESHOW_IMAGES] =
+    g_param_spec_boxed ("slideshow-images",
+                        "Slideshow images",
+                        "Paths of the images shown after the main one in slideshow mode",
+                        G_TYPE_STRV,
+                        (G_PARAM_READWRITE |
+                         G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (object_class, PROP_SLIDESHOW_IMAGES,
+                                   properties [PROP_SLIDESHOW_IMAGES]);
+
+  properties [PROP_VIDEO_ENCODER] =
+    g_param_spec_string ("video-encoder",
+                         "Video encoder",
+                         "ID of the preferred video encoder",
+                         "x264",
+                         (G_PARAM_READWRITE |
+                          G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (object_class, PROP_VIDEO_ENCODER,
+                                   properties [PROP_VIDEO_ENCODER]);
+
+  properties [PROP_AUDIO_ENCODER] =
+    g_param_spec_string ("audio-encoder",
+                         "Audio encoder",
+                         "ID of the preferred audio encoder",
+                         "fdkaac",
+                         (G_PARAM_READWRITE |
+                          G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (object_class, PROP_AUDIO_ENCODER,
+                                   properties [PROP_AUDIO_ENCODER]);
+
+  properties [PROP_MUXER] =
+    g_param_spec_string ("muxer",
+                         "Muxer",
+                         "ID of the preferred container format",
+                         "mp4",
+                         (G_PARAM_READWRITE |
+                          G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (object_class, PROP_MUXER,
+                                   properties [PROP_MUXER]);
+
+  properties [PROP_VIDEO_PRESET] =
+    g_param_spec_string ("video-preset",
+                         "Video preset",
+                         "Speed preset of the video encoder, or NULL for its default",
+                         NULL,
+                         (G_PARAM_READWRITE |
+                          G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (object_class, PROP_VIDEO_PRESET,
+                                   properties [PROP_VIDEO_PRESET]);
+
+  properties [PROP_AUDIO_PASSTHROUGH] =
+    g_param_spec_boolean ("audio-passthrough",
+                          "Audio passthrough",
+                          "Copy audio that the container already supports instead of re-encoding it",
+                          TRUE,
+                          (G_PARAM_READWRITE |
+                           G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (object_class, PROP_AUDIO_PASSTHROUGH,
+                                   properties [PROP_AUDIO_PASSTHROUGH]);
+
+  properties [PROP_MATCH_SOURCE_BITRATE] =
+    g_param_spec_boolean ("match-source-bitrate",
+                          "Match source bitrate",
+                          "Lower the audio bitrate to the source's, treating audio-bitrate as the maximum",
+                          FALSE,
+                          (G_PARAM_READWRITE |
+                           G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (object_class, PROP_MATCH_SOURCE_BITRATE,
+                                   properties [PROP_MATCH_SOURCE_BITRATE]);
+
+  properties [PROP_AUDIO_MAX_SAMPLE_RATE] =
+    g_param_spec_uint ("audio-max-sample-rate",
+                       "Maximum sample rate",
+                       "Sources above this sample rate in Hz are resampled down to it before encoding, or 0 for no limit",
+                       0, 192000, 48000,
+                       (G_PARAM_READWRITE |
+                        G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (object_class, PROP_AUDIO_MAX_SAMPLE_RATE,
+                                   properties [PROP_AUDIO_MAX_SAMPLE_RATE]);
+
+  properties [PROP_AUDIO_MAX_CHANNELS] =
+    g_param_spec_uint ("audio-max-channels",
+                       "Maximum channels",
+                       "Sources with more channels are downmixed to this many before encoding, or 0 for no limit",
+                       0, 8, 2,
+                       (G_PARAM_READWRITE |
+                        G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (object_class, PROP_AUDIO_MAX_CHANNELS,
+                                   properties [PROP_AUDIO_MAX_CHANNELS]);
+
+  properties [PROP_RESAMPLE_QUALITY] =
+    g_param_spec_uint ("resample-quality",
+                       "Resample quality",
+                       "The audioresample quality used when reducing the sample rate, from 0 (fastest) to 10 (best)",
+                       0, 10, 4,
+                       (G_PARAM_READWRITE |
+                        G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (object_class, PROP_RESAMPLE_QUALITY,
+                                   properties [PROP_RESAMPLE_QUALITY]);
+
+  properties [PROP_NORMALIZE_LOUDNESS] =
+    g_param_spec_boolean ("normalize-loudness",
+                          "Normalize loudness",
+                          "Adjust each track's volume to the target loudness, as measured while scanning its tags",
+                          FALSE,
+                          (G_PARAM_READWRITE |
+                           G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (object_class, PROP_NORMALIZE_LOUDNESS,
+                                   properties [PROP_NORMALIZE_LOUDNESS]);
+
+  properties [PROP_TARGET_LOUDNESS] =
+    g_param_spec_double ("target-loudness",
+                         "Target loudness",
+                         "The integrated loudness to normalize to, in LUFS",
+                         -40.0, -5.0, -23.0,
+                         (G_PARAM_READWRITE |
+                          G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (object_class, PROP_TARGET_LOUDNESS,
+                                   properties [PROP_TARGET_LOUDNESS]);
+
+  properties [PROP_PARALLEL_ENCODING] =
+    g_param_spec_boolean ("parallel-encoding",
+                          "Parallel encoding",
+                          "Split long tracks into ranges that are encoded in parallel",
+                          TRUE,
+                          (G_PARAM_READWRITE |
+                           G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (object_class, PROP_PARALLEL_ENCODING,
+                                   properties [PROP_PARALLEL_ENCODING]);
+
+  properties [PROP_ALBUM_MODE] =
+    g_param_spec_boolean ("album-mode",
+                          "Album mode",
+                          "Render all tracks into one video, with a chapter per track",
+                          FALSE,
+                          (G_PARAM_READWRITE |
+                           G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (object_class, PROP_ALBUM_MODE,
+                                   properties [PROP_ALBUM_MODE]);
+
+  properties [PROP_RENDITIONS] =
+    g_param_spec_string ("renditions",
+                         "Renditions",
+                         "Extra versions of each video to render, separated by commas, e.g. "480p, webm"",
+                         NULL,
+                         (G_PARAM_READWRITE |
+                          G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (object_class, PROP_RENDITIONS,
+                                   properties [PROP_RENDITIONS]);
+
+  properties [PROP_FRAGMENTED_OUTPUT] =
+    g_param_spec_boolean ("fragmented-output",
+                          "Fragmented output",
+                          "Write MP4 files in fragments, so they stay playable if rendering is interrupted",
+                          FALSE,
+                          (G_PARAM_READWRITE |
+                           G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (object_class, PROP_FRAGMENTED_OUTPUT,
+                                   properties [PROP_FRAGMENTED_OUTPUT]);
+
+  properties [PROP_FASTSTART] =
+    g_param_spec_boolean ("faststart",
+                          "Fast start",
+                          "Reserve room for the MP4 index at the start of the file, so playback can begin before it's fully downloaded",
+                          FALSE,
+                          (G_PARAM_READWRITE |
+                           G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (object_class, PROP_FASTSTART,
+                                   properties [PROP_FASTSTART]);
+
+  properties [PROP_WRITE_CHECKSUMS] =
+    g_param_spec_boolean ("write-checksums",
+                          "Write checksums",
+                          "Write the SHA-256 of each output to a SHA256SUMS file in the output directory",
+                          FALSE,
+                          (G_PARAM_READWRITE |
+                           G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (object_class, PROP_WRITE_CHECKSUMS,
+                                   properties [PROP_WRITE_CHECKSUMS]);
+
+  properties [PROP_OUTPUT_COMMAND] =
+    g_param_spec_string ("output-command",
+                         "Output command",
+                         "A shell command each output is piped into instead of being written to a file, or NULL",
+                         NULL,
+                         (G_PARAM_READWRITE |
+                          G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (object_class, PROP_OUTPUT_COMMAND,
+                                   properties [PROP_OUTPUT_COMMAND]);
+
+  properties [PROP_SKIP_UNCHANGED] =
+    g_param_spec_boolean ("skip-unchanged",
+                          "Skip unchanged",
+                          "Whether outputs that are already up to date with their inputs and options are left alone",
+                          FALSE,
+                          (G_PARAM_READWRITE |
+                           G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (object_class, PROP_SKIP_UNCHANGED,
+                                   properties [PROP_SKIP_UNCHANGED]);
 }
 
 static void
 auricle_render_options_init (AuricleRenderOptions *self)
 {
+  self->audio_bitrate = 384;
+  self->slideshow_dwell = 10;
+  self->video_encoder = g_strdup ("x264");
+  self->audio_encoder = g_strdup ("fdkaac");
+  self->muxer = g_strdup ("mp4");
+  self->audio_passthrough = TRUE;
+  self->audio_max_sample_rate = 48000;
+  self->audio_max_channels = 2;
+  self->resample_quality = 4;
+  self->target_loudness = -23.0;
+  self->parallel_encoding = TRUE;
 }
 
 const char *
@@ -186,3 +909,314 @@ auricle_render_options_set_audio_bitrate (AuricleRenderOptions *self,
   auricle_render_options_set_audio_bitrate_notify (self, bitrate, TRUE);
 }
 
+const char *
+auricle_render_options_get_caption_template (AuricleRenderOptions *self)
+{
+  return self->caption_template;
+}
+
+void
+auricle_render_options_set_caption_template (AuricleRenderOptions *self,
+                                             const char           *caption_template)
+{
+  auricle_render_options_set_caption_template_notify (self, caption_template, TRUE);
+}
+
+gboolean
+auricle_render_options_get_track_artwork (AuricleRenderOptions *self)
+{
+  return self->track_artwork;
+}
+
+void
+auricle_render_options_set_track_artwork (AuricleRenderOptions *self,
+                                          gboolean              track_artwork)
+{
+  auricle_render_options_set_track_artwork_notify (self, track_artwork, TRUE);
+}
+
+AuricleRenderMode
+auricle_render_options_get_render_mode (AuricleRenderOptions *self)
+{
+  return self->render_mode;
+}
+
+void
+auricle_render_options_set_render_mode (AuricleRenderOptions *self,
+                                        AuricleRenderMode     render_mode)
+{
+  auricle_render_options_set_render_mode_notify (self, render_mode, TRUE);
+}
+
+guint
+auricle_render_options_get_slideshow_dwell (AuricleRenderOptions *self)
+{
+  return self->slideshow_dwell;
+}
+
+void
+auricle_render_options_set_slideshow_dwell (AuricleRenderOptions *self,
+                                            guint                 slideshow_dwell)
+{
+  auricle_render_options_set_slideshow_dwell_notify (self, slideshow_dwell, TRUE);
+}
+
+const char * const *
+auricle_render_options_get_slideshow_images (AuricleRenderOptions *self)
+{
+  return (const char * const *) self->slideshow_images;
+}
+
+void
+auricle_render_options_set_slideshow_images (AuricleRenderOptions *self,
+                                             const char * const   *slideshow_images)
+{
+  auricle_render_options_set_slideshow_images_notify (self, slideshow_images, TRUE);
+}
+
+const char *
+auricle_render_options_get_video_encoder (AuricleRenderOptions *self)
+{
+  return self->video_encoder;
+}
+
+void
+auricle_render_options_set_video_encoder (AuricleRenderOptions *self,
+                                          const char           *video_encoder)
+{
+  auricle_render_options_set_video_encoder_notify (self, video_encoder, TRUE);
+}
+
+const char *
+auricle_render_options_get_audio_encoder (AuricleRenderOptions *self)
+{
+  return self->audio_encoder;
+}
+
+void
+auricle_render_options_set_audio_encoder (AuricleRenderOptions *self,
+                                          const char           *audio_encoder)
+{
+  auricle_render_options_set_audio_encoder_notify (self, audio_encoder, TRUE);
+}
+
+const char *
+auricle_render_options_get_muxer (AuricleRenderOptions *self)
+{
+  return self->muxer;
+}
+
+void
+auricle_render_options_set_muxer (AuricleRenderOptions *self,
+                                  const char           *muxer)
+{
+  auricle_render_options_set_muxer_notify (self, muxer, TRUE);
+}
+
+const char *
+auricle_render_options_get_video_preset (AuricleRenderOptions *self)
+{
+  return self->video_preset;
+}
+
+void
+auricle_render_options_set_video_preset (AuricleRenderOptions *self,
+                                         const char           *video_preset)
+{
+  auricle_render_options_set_video_preset_notify (self, video_preset, TRUE);
+}
+
+gboolean
+auricle_render_options_get_audio_passthrough (AuricleRenderOptions *self)
+{
+  return self->audio_passthrough;
+}
+
+void
+auricle_render_options_set_audio_passthrough (AuricleRenderOptions *self,
+                                              gboolean              audio_passthrough)
+{
+  auricle_render_options_set_audio_passthrough_notify (self, audio_passthrough, TRUE);
+}
+
+gboolean
+auricle_render_options_get_match_source_bitrate (AuricleRenderOptions *self)
+{
+  return self->match_source_bitrate;
+}
+
+void
+auricle_render_options_set_match_source_bitrate (AuricleRenderOptions *self,
+                                                 gboolean              match_source_bitrate)
+{
+  auricle_render_options_set_match_source_bitrate_notify (self, match_source_bitrate, TRUE);
+}
+
+guint
+auricle_render_options_get_audio_max_sample_rate (AuricleRenderOptions *self)
+{
+  return self->audio_max_sample_rate;
+}
+
+void
+auricle_render_options_set_audio_max_sample_rate (AuricleRenderOptions *self,
+                                                  guint                 audio_max_sample_rate)
+{
+  auricle_render_options_set_audio_max_sample_rate_notify (self, audio_max_sample_rate, TRUE);
+}
+
+guint
+auricle_render_options_get_audio_max_channels (AuricleRenderOptions *self)
+{
+  return self->audio_max_channels;
+}
+
+void
+auricle_render_options_set_audio_max_channels (AuricleRenderOptions *self,
+                                               guint                 audio_max_channels)
+{
+  auricle_render_options_set_audio_max_channels_notify (self, audio_max_channels, TRUE);
+}
+
+guint
+auricle_render_options_get_resample_quality (AuricleRenderOptions *self)
+{
+  return self->resample_quality;
+}
+
+void
+auricle_render_options_set_resample_quality (AuricleRenderOptions *self,
+                                             guint                 resample_quality)
+{
+  auricle_render_options_set_resample_quality_notify (self, resample_quality, TRUE);
+}
+
+gboolean
+auricle_render_options_get_normalize_loudness (AuricleRenderOptions *self)
+{
+  return self->normalize_loudness;
+}
+
+void
+auricle_render_options_set_normalize_loudness (AuricleRenderOptions *self,
+                                               gboolean              normalize_loudness)
+{
+  auricle_render_options_set_normalize_loudness_notify (self, normalize_loudness, TRUE);
+}
+
+double
+auricle_render_options_get_target_loudness (AuricleRenderOptions *self)
+{
+  return self->target_loudness;
+}
+
+void
+auricle_render_options_set_target_loudness (AuricleRenderOptions *self,
+                                            double                target_loudness)
+{
+  auricle_render_options_set_target_loudness_notify (self, target_loudness, TRUE);
+}
+
+gboolean
+auricle_render_options_get_parallel_encoding (AuricleRenderOptions *self)
+{
+  return self->parallel_encoding;
+}
+
+void
+auricle_render_options_set_parallel_encoding (AuricleRenderOptions *self,
+                                              gboolean              parallel_encoding)
+{
+  auricle_render_options_set_parallel_encoding_notify (self, parallel_encoding, TRUE);
+}
+
+gboolean
+auricle_render_options_get_album_mode (AuricleRenderOptions *self)
+{
+  return self->album_mode;
+}
+
+void
+auricle_render_options_set_album_mode (AuricleRenderOptions *self,
+                                       gboolean              album_mode)
+{
+  auricle_render_options_set_album_mode_notify (self, album_mode, TRUE);
+}
+
+const char *
+auricle_render_options_get_renditions (AuricleRenderOptions *self)
+{
+  return self->renditions;
+}
+
+void
+auricle_render_options_set_renditions (AuricleRenderOptions *self,
+                                       const char           *renditions)
+{
+  auricle_render_options_set_renditions_notify (self, renditions, TRUE);
+}
+
+gboolean
+auricle_render_options_get_fragmented_output (AuricleRenderOptions *self)
+{
+  return self->fragmented_output;
+}
+
+void
+auricle_render_options_set_fragmented_output (AuricleRenderOptions *self,
+                                              gboolean              fragmented_output)
+{
+  auricle_render_options_set_fragmented_output_notify (self, fragmented_output, TRUE);
+}
+
+gboolean
+auricle_render_options_get_faststart (AuricleRenderOptions *self)
+{
+  return self->faststart;
+}
+
+void
+auricle_render_options_set_faststart (AuricleRenderOptions *self,
+                                      gboolean              faststart)
+{
+  auricle_render_options_set_faststart_notify (self, faststart, TRUE);
+}
+
+gboolean
+auricle_render_options_get_write_checksums (AuricleRenderOptions *self)
+{
+  return self->write_checksums;
+}
+
+void
+auricle_render_options_set_write_checksums (AuricleRenderOptions *self,
+                                            gboolean              write_checksums)
+{
+  auricle_render_options_set_write_checksums_notify (self, write_checksums, TRUE);
+}
+
+const char *
+auricle_render_options_get_output_command (AuricleRenderOptions *self)
+{
+  return self->output_command;
+}
+
+void
+auricle_render_options_set_output_command (AuricleRenderOptions *self,
+                                           const char           *output_command)
+{
+  auricle_render_options_set_output_command_notify (self, output_command, TRUE);
+}
+
+gboolean
+auricle_render_options_get_skip_unchanged (AuricleRenderOptions *self)
+{
+  return self->skip_unchanged;
+}
+
+void
+auricle_render_options_set_skip_unchanged (AuricleRenderOptions *self,
+                                           gboolean              skip_unchanged)
+{
+  auricle_render_options_set_skip_unchanged_notify (self, skip_unchanged, TRUE);
+}
@@ -24,6 +24,18 @@
 
 G_BEGIN_DECLS
 
+typedef enum {
+  AURICLE_RENDER_MODE_STILL,
+  AURICLE_RENDER_MODE_SLIDESHOW,
+  AURICLE_RENDER_MODE_WAVEFORM,
+  AURICLE_RENDER_MODE_SPECTRUM,
+  AURICLE_RENDER_MODE_AUDIO_ONLY,
+} AuricleRenderMode;
+
+#define AURICLE_TYPE_RENDER_MODE (auricle_render_mode_get_type())
+
+GType auricle_render_mode_get_type (void);
+
 #define AURICLE_TYPE_RENDER_OPTIONS (auricle_render_options_get_type())
 
 G_DECLARE_FINAL_TYPE (AuricleRenderOptions, auricle_render_options, AURICLE, RENDER_OPTIONS, GObject)
@@ -40,7 +52,101 @@ guint auricle_render_options_get_audio_bitrate (AuricleRenderOptions *self);
 void  auricle_render_options_set_audio_bitrate (AuricleRenderOptions *self,
                                                 guint                 bitrate);
 
+const char *auricle_render_options_get_caption_template (AuricleRenderOptions *self);
+void        auricle_render_options_set_caption_template (AuricleRenderOptions *self,
+                                                         const char           *caption_template);
+
+gboolean auricle_render_options_get_track_artwork (AuricleRenderOptions *self);
+void     auricle_render_options_set_track_artwork (AuricleRenderOptions *self,
+                                                   gboolean              track_artwork);
+
+AuricleRenderMode auricle_render_options_get_render_mode (AuricleRenderOptions *self);
+void              auricle_render_options_set_render_mode (AuricleRenderOptions *self,
+                                                          AuricleRenderMode     render_mode);
+
+guint auricle_render_options_get_slideshow_dwell (AuricleRenderOptions *self);
+void  auricle_render_options_set_slideshow_dwell (AuricleRenderOptions *self,
+                                                  guint                 slideshow_dwell);
+
+const char * const *auricle_render_options_get_slideshow_images (AuricleRenderOptions *self);
+void                auricle_render_options_set_slideshow_images (AuricleRenderOptions *self,
+                                                                 const char * const   *slideshow_images);
+
+const char *auricle_render_options_get_video_encoder (AuricleRenderOptions *self);
+void        auricle_render_options_set_video_encoder (AuricleRenderOptions *self,
+                                                      const char           *video_encoder);
+
+const char *auricle_render_options_get_audio_encoder (AuricleRenderOptions *self);
+void        auricle_render_options_set_audio_encoder (AuricleRenderOptions *self,
+                                                      const char           *audio_encoder);
+
+const char *auricle_render_options_get_muxer (AuricleRenderOptions *self);
+void        auricle_render_options_set_muxer (AuricleRenderOptions *self,
+                                              const char           *muxer);
+
+const char *auricle_render_options_get_video_preset (AuricleRenderOptions *self);
+void        auricle_render_options_set_video_preset (AuricleRenderOptions *self,
+                                                     const char           *video_preset);
+
+gboolean auricle_render_options_get_audio_passthrough (AuricleRenderOptions *self);
+void     auricle_render_options_set_audio_passthrough (AuricleRenderOptions *self,
+                                                       gboolean              audio_passthrough);
+
+gboolean auricle_render_options_get_match_source_bitrate (AuricleRenderOptions *self);
+void     auricle_render_options_set_match_source_bitrate (AuricleRenderOptions *self,
+                                                          gboolean              match_source_bitrate);
+
+guint auricle_render_options_get_audio_max_sample_rate (AuricleRenderOptions *self);
+void  auricle_render_options_set_audio_max_sample_rate (AuricleRenderOptions *self,
+                                                        guint                 audio_max_sample_rate);
+
+guint auricle_render_options_get_audio_max_channels (AuricleRenderOptions *self);
+void  auricle_render_options_set_audio_max_channels (AuricleRenderOptions *self,
+                                                     guint                 audio_max_channels);
+
+guint auricle_render_options_get_resample_quality (AuricleRenderOptions *self);
+void  auricle_render_options_set_resample_quality (AuricleRenderOptions *self,
+                                                   guint                 resample_quality);
+
+gboolean auricle_render_options_get_normalize_loudness (AuricleRenderOptions *self);
+void     auricle_render_options_set_normalize_loudness (AuricleRenderOptions *self,
+                                                        gboolean              normalize_loudness);
+
+double auricle_render_options_get_target_loudness (AuricleRenderOptions *self);
+void   auricle_render_options_set_target_loudness (AuricleRenderOptions *self,
+                                                   double                target_loudness);
+
+gboolean auricle_render_options_get_parallel_encoding (AuricleRenderOptions *self);
+void     auricle_render_options_set_parallel_encoding (AuricleRenderOptions *self,
+                                                       gboolean              parallel_encoding);
+
+gboolean auricle_render_options_get_album_mode (AuricleRenderOptions *self);
+void     auricle_render_options_set_album_mode (AuricleRenderOptions *self,
+                                                gboolean              album_mode);
+
+const char *auricle_render_options_get_renditions (AuricleRenderOptions *self);
+void        auricle_render_options_set_renditions (AuricleRenderOptions *self,
+                                                   const char           *renditions);
+
+gboolean auricle_render_options_get_fragmented_output (AuricleRenderOptions *self);
+void     auricle_render_options_set_fragmented_output (AuricleRenderOptions *self,
+                                                       gboolean              fragmented_output);
+
+gboolean auricle_render_options_get_faststart (AuricleRenderOptions *self);
+void     auricle_render_options_set_faststart (AuricleRenderOptions *self,
+                                               gboolean              faststart);
+
+gboolean auricle_render_options_get_write_checksums (AuricleRenderOptions *self);
+void     auricle_render_options_set_write_checksums (AuricleRenderOptions *self,
+                                                     gboolean              write_checksums);
+
+const char *auricle_render_options_get_output_command (AuricleRenderOptions *self);
+void        auricle_render_options_set_output_command (AuricleRenderOptions *self,
+                                                       const char           *output_command);
 
+gboolean auricle_render_options_get_skip_unchanged (AuricleRenderOptions *self);
+void     auricle_render_options_set_skip_unchanged (AuricleRenderOptions *self,
+                                                    gboolean              skip_unchanged);
 
 G_END_DECLS
 
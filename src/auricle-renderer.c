@@ -19,10 +19,52 @@
  */
 
 #include "auricle-renderer.h"
+#include "auricle-archive.h"
+#include "auricle-chunked-audio.h"
+#include "auricle-codecs.h"
+#include "auricle-file-sink.h"
+#include "auricle-image-cache.h"
 #include "auricle-utils.h"
+#include "auricle-visualizer.h"
+#include <gio/gio.h>
+#include <glib-unix.h>
+#include <glib/gstdio.h>
 #include <gst/gst.h>
 #include <gst/app/app.h>
+#include <gst/audio/audio.h>
 #include <gst/video/video.h>
+#include <math.h>
+#include <string.h>
+
+// Previews are small, since they only need to be good enough to check the layout.
+#define PREVIEW_HEIGHT 360
+
+// The lowest bitrate matching the source will pick, in kbps, below which AAC gets audibly worse.
+#define MIN_AUDIO_BITRATE 64
+
+// The highest true peak, in dBTP, that loudness normalization may raise a track to. Lossy encoders
+// overshoot a bit, so this leaves them some room.
+#define TRUE_PEAK_CEILING -1.0
+
+// With fragmented output, at most this many milliseconds are lost if rendering is interrupted.
+#define FRAGMENT_DURATION 1000
+
+// Lists the SHA-256 of each output, in the format sha256sum --check reads.
+#define CHECKSUM_MANIFEST_NAME "SHA256SUMS"
+#define SHA256_HEX_LENGTH 64
+
+// Added on top of the expected length of fast start outputs, for slack in the durations.
+#define RESERVED_DURATION_MARGIN (10 * GST_SECOND)
+
+// Records what each output in the directory was rendered from, so unchanged ones can be skipped.
+#define RENDER_MANIFEST_NAME ".auricle-manifest"
+
+// Options that don't change what's rendered, which are left out of the comparison. The slideshow
+// images are compared through the job's image instead.
+static const char *unrendered_options[] = {
+  "output-directory", "parallel-encoding", "write-checksums", "output-command", "skip-unchanged",
+  "slideshow-images", NULL
+};
 
 typedef struct _AuricleRendererPadProbe AuricleRendererPadProbe;
 
@@ -31,24 +73,103 @@ struct _AuricleRendererPadProbe {
   guint   id;
 };
 
+typedef struct _AuricleRendererRendition AuricleRendererRendition;
+
+/* A version of the output to render. The first is the one set in the options, and any others share
+   each job's decoded audio, so they only add their own encoding. */
+struct _AuricleRendererRendition
+{
+  // The formats asked for, or NULL to use the ones from the options.
+  char *muxer_id;
+  char *video_id;
+  char *audio_id;
+  // The maximum video height, or 0 to keep the image's.
+  int   height;
+  // Added to the result names, to tell the renditions apart.
+  char *suffix;
+
+  const AuricleCodec *muxer;
+  const AuricleCodec *video_codec;
+  const AuricleCodec *audio_codec;
+  const char         *video_preset;
+  AuricleImageCache  *image_cache;
+  char               *default_image_key;
+  GPtrArray          *slideshow_keys;
+};
+
+static void
+auricle_renderer_rendition_free (AuricleRendererRendition *rendition)
+{
+  g_free (rendition->muxer_id);
+  g_free (rendition->video_id);
+  g_free (rendition->audio_id);
+  g_free (rendition->suffix);
+  g_clear_object (&rendition->image_cache);
+  g_free (rendition->default_image_key);
+  g_clear_pointer (&rendition->slideshow_keys, g_ptr_array_unref);
+  g_free (rendition);
+}
+
 typedef struct _AuricleRendererFileData AuricleRendererFileData;
 
 struct _AuricleRendererFileData
 {
-  AuricleMusicFile *file;
+  AuricleMusicFile         *file;
+  AuricleRendererRendition *rendition;
+
+  AuricleImageCache *image_cache;
+  char              *image_key;
+  guint              segment_repeat;
 
   GstElement *src;
   GstElement *sink;
+  // Only linked in once the decoder shows that the audio can't be passed through as is.
+  GstElement *audio_enc;
+  GstElement *audio_queue;
   GList      *request_pads;
   GList      *pad_probes;
   gboolean    is_eos;
   gboolean    emitted_finished_progress;
+
+  char        *output_path;
+  // Set if the output went to the output command instead of output_path.
+  gboolean     streamed;
+  GstClockTime end_time;
+
+  // For jobs sharing their source's decoder, the branch split off it, and the part of the source
+  // the job covers.
+  GstPad      *shared_pad;
+  GstClockTime range_start;
+  gboolean     range_done;
+
+  // In album mode, the files played back to back in the one job, and the list of their chapters
+  // that's written next to the output once it's done.
+  GPtrArray *tracks;
+  char      *chapter_listing;
+
+  // With skip-unchanged, what the output is rendered from, as recorded in the manifest: the size,
+  // modification time and path of each input, and hashes of the image and settings.
+  GStrv    inputs;
+  char    *image_hash;
+  char    *settings_hash;
+  gboolean skipped;
+
+  gint64       start_time;
+  GstClockTime duration;
 };
 
 static void
 auricle_renderer_file_data_destroy (AuricleRendererFileData *data)
 {
   g_clear_object (&data->file);
+  g_clear_object (&data->image_cache);
+  g_clear_pointer (&data->image_key, g_free);
+  g_clear_pointer (&data->output_path, g_free);
+  g_clear_pointer (&data->tracks, g_ptr_array_unref);
+  g_clear_pointer (&data->chapter_listing, g_free);
+  g_clear_pointer (&data->inputs, g_strfreev);
+  g_clear_pointer (&data->image_hash, g_free);
+  g_clear_pointer (&data->settings_hash, g_free);
 
   for (GList *l = data->request_pads; l != NULL; l = l->next)
     {
@@ -59,6 +180,13 @@ auricle_renderer_file_data_destroy (AuricleRendererFileData *data)
 
   g_list_free (data->request_pads);
 
+  if (data->shared_pad != NULL)
+    {
+      g_autoptr(GstElement) parent = gst_pad_get_parent_element (data->shared_pad);
+      gst_element_release_request_pad (parent, data->shared_pad);
+      g_clear_object (&data->shared_pad);
+    }
+
   for (GList *l = data->pad_probes; l != NULL; l = l->next)
     {
       AuricleRendererPadProbe *probe = l->data;
@@ -69,6 +197,8 @@ auricle_renderer_file_data_destroy (AuricleRendererFileData *data)
 
   g_clear_pointer (&data->src, gst_object_unref);
   g_clear_pointer (&data->sink, gst_object_unref);
+  g_clear_pointer (&data->audio_enc, gst_object_unref);
+  g_clear_pointer (&data->audio_queue, gst_object_unref);
 }
 
 struct _AuricleRenderer
@@ -78,10 +208,16 @@ struct _AuricleRenderer
   GdkPixbuf            *pixbuf;
   AuricleRenderOptions *render_options;
 
+  GstClockTime preview_duration;
+  GPtrArray   *renditions;
+
   GPtrArray  *file_data;
   GstElement *pipeline;
   guint       bus_watch_id;
   guint       progress_timer_id;
+
+  // The output directory's manifest, if unchanged outputs are skipped.
+  GKeyFile *manifest;
 };
 
 G_DEFINE_TYPE (AuricleRenderer, auricle_renderer, G_TYPE_OBJECT)
@@ -134,11 +270,15 @@ auricle_renderer_finalize (GObject *object)
       self->progress_timer_id = 0;
     }
 
-  g_clear_pointer (&self->file_data, g_ptr_array_unref);
-
+  // Stop the pipeline first, since the streaming threads still refer to the file data.
   g_debug ("Destroying renderer");
-  gst_element_set_state (self->pipeline, GST_STATE_NULL);
+  if (self->pipeline != NULL)
+    gst_element_set_state (self->pipeline, GST_STATE_NULL);
+
+  g_clear_pointer (&self->file_data, g_ptr_array_unref);
+  g_clear_pointer (&self->renditions, g_ptr_array_unref);
   g_clear_object (&self->pipeline);
+  g_clear_pointer (&self->manifest, g_key_file_unref);
 
   G_OBJECT_CLASS (auricle_renderer_parent_class)->finalize (object);
 }
@@ -154,7 +294,7 @@ auricle_renderer_get_property (GObject    *object,
   switch (prop_id)
     {
     case PROP_PIXBUF:
-      g_warn_if_fail (self->pixbuf != NULL);
+      // Audio-only renders have no image.
       g_value_set_object (value, self->pixbuf);
       break;
     case PROP_RENDER_OPTIONS:
@@ -249,13 +389,357 @@ auricle_renderer_init (AuricleRenderer *self)
   self->file_data = g_ptr_array_new_with_free_func ((GDestroyNotify) auricle_renderer_file_data_destroy);
 }
 
+static void
+set_rendition_id (char       **id,
+                  const char  *value)
+{
+  g_free (*id);
+  *id = g_strdup (value);
+}
+
+/* Parses the extra renditions from the options, the first time they're needed. They're separated by
+   commas, and each is made up of a height like 480p and the IDs of the muxer and encoders to use. */
+static GPtrArray *
+auricle_renderer_get_renditions (AuricleRenderer *self)
+{
+  if (self->renditions != NULL)
+    return self->renditions;
+
+  self->renditions = g_ptr_array_new_with_free_func ((GDestroyNotify) auricle_renderer_rendition_free);
+
+  AuricleRendererRendition *main_rendition = g_new0 (AuricleRendererRendition, 1);
+  main_rendition->height = self->preview_duration != 0 ? PREVIEW_HEIGHT : 0;
+  main_rendition->suffix = g_strdup ("");
+  g_ptr_array_add (self->renditions, main_rendition);
+
+  // Previews only need the one.
+  const char *spec = auricle_render_options_get_renditions (self->render_options);
+  if (spec == NULL || self->preview_duration != 0)
+    return self->renditions;
+
+  g_auto(GStrv) items = g_strsplit (spec, ",", -1);
+  for (char **item = items; *item != NULL; item++)
+    {
+      g_auto(GStrv) words = g_strsplit_set (*item, " \t", -1);
+      g_autoptr(GPtrArray) suffix_words = g_ptr_array_new ();
+      AuricleRendererRendition *rendition = g_new0 (AuricleRendererRendition, 1);
+      gboolean valid = TRUE;
+
+      for (char **word = words; *word != NULL; word++)
+        {
+          if (**word == '\0')
+            continue;
+
+          char *end;
+          guint64 height = g_ascii_strtoull (*word, &end, 10);
+          if (end != *word && g_ascii_strcasecmp (end, "p") == 0 && height > 0 && height <= G_MAXINT)
+            rendition->height = height;
+          else if (auricle_codecs_find (AURICLE_CODEC_KIND_MUXER, *word) != NULL)
+            set_rendition_id (&rendition->muxer_id, *word);
+          else if (auricle_codecs_find (AURICLE_CODEC_KIND_VIDEO, *word) != NULL)
+            set_rendition_id (&rendition->video_id, *word);
+          else if (auricle_codecs_find (AURICLE_CODEC_KIND_AUDIO, *word) != NULL)
+            set_rendition_id (&rendition->audio_id, *word);
+          else
+            {
+              auricle_show_notification ("Skipping the rendition \"%s\", since %s isn't a known height or format",
+                                         g_strstrip (*item), *word);
+              valid = FALSE;
+              break;
+            }
+
+          g_ptr_array_add (suffix_words, *word);
+        }
+
+      if (!valid || suffix_words->len == 0)
+        {
+          auricle_renderer_rendition_free (rendition);
+          continue;
+        }
+
+      g_ptr_array_add (suffix_words, NULL);
+      g_autofree char *suffix = g_strjoinv ("-", (char **) suffix_words->pdata);
+      rendition->suffix = g_strconcat ("-", suffix, NULL);
+      g_ptr_array_add (self->renditions, rendition);
+    }
+
+  return self->renditions;
+}
+
+/* In album mode, every file becomes a track of a single job, named after the album. */
+static void
+auricle_renderer_take_album_track (AuricleRenderer  *self,
+                                   AuricleMusicFile *file)
+{
+  if (self->file_data->len == 0)
+    {
+      GHashTable *track_vars = auricle_music_file_get_template_vars (file);
+      char **album = track_vars != NULL ? g_hash_table_lookup (track_vars, GST_TAG_ALBUM) : NULL;
+      const char *name = album != NULL && album[0] != NULL ? album[0] : auricle_music_file_get_result_name (file);
+
+      // Captions get the first track's tags, but with the album in place of its title.
+      g_autoptr(GHashTable) album_vars = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                                                (GDestroyNotify) g_strfreev);
+      if (track_vars != NULL)
+        {
+          GHashTableIter iter;
+          gpointer key, value;
+          g_hash_table_iter_init (&iter, track_vars);
+          while (g_hash_table_iter_next (&iter, &key, &value))
+            g_hash_table_replace (album_vars, g_strdup (key), g_strdupv (value));
+        }
+
+      char *name_strv[] = { (char *) name, NULL };
+      g_hash_table_replace (album_vars, g_strdup (GST_TAG_TITLE), g_strdupv (name_strv));
+      g_hash_table_replace (album_vars, g_strdup ("result"), g_strdupv (name_strv));
+
+      g_autoptr(AuricleMusicFile) album_file = auricle_music_file_new (auricle_music_file_get_path (file), name);
+      auricle_music_file_set_template_vars (album_file, album_vars);
+      auricle_music_file_set_cover (album_file, auricle_music_file_get_cover (file));
+      auricle_music_file_set_source_bitrate (album_file, auricle_music_file_get_source_bitrate (file));
+
+      // Every rendition of the album plays the same tracks.
+      g_autoptr(GPtrArray) tracks = g_ptr_array_new_with_free_func (g_object_unref);
+      GPtrArray *renditions = auricle_renderer_get_renditions (self);
+      for (guint i = 0; i < renditions->len; i++)
+        {
+          AuricleRendererRendition *rendition = g_ptr_array_index (renditions, i);
+          g_autofree char *rendition_name = g_strconcat (name, rendition->suffix, NULL);
+
+          AuricleRendererFileData *data = g_new0 (AuricleRendererFileData, 1);
+          data->file = auricle_music_file_copy_renamed (album_file, rendition_name);
+          data->rendition = rendition;
+          data->tracks = g_ptr_array_ref (tracks);
+          g_ptr_array_add (self->file_data, data);
+        }
+    }
+
+  AuricleRendererFileData *data = g_ptr_array_index (self->file_data, 0);
+  g_ptr_array_add (data->tracks, file);
+}
+
 void
 auricle_renderer_take_file (AuricleRenderer  *self,
                             AuricleMusicFile *file)
 {
-  AuricleRendererFileData *data = g_new0 (AuricleRendererFileData, 1);
-  data->file = file;
-  g_ptr_array_add (self->file_data, data);
+  // Previews stick to a single track.
+  if (self->preview_duration == 0 && auricle_render_options_get_album_mode (self->render_options))
+    {
+      auricle_renderer_take_album_track (self, file);
+      return;
+    }
+
+  GPtrArray *renditions = auricle_renderer_get_renditions (self);
+  for (guint i = 0; i < renditions->len; i++)
+    {
+      AuricleRendererRendition *rendition = g_ptr_array_index (renditions, i);
+
+      AuricleRendererFileData *data = g_new0 (AuricleRendererFileData, 1);
+      data->rendition = rendition;
+      if (i == 0)
+        {
+          data->file = g_object_ref (file);
+        }
+      else
+        {
+          g_autofree char *rendition_name = g_strconcat (auricle_music_file_get_result_name (file),
+                                                         rendition->suffix, NULL);
+          data->file = auricle_music_file_copy_renamed (file, rendition_name);
+        }
+
+      g_ptr_array_add (self->file_data, data);
+    }
+
+  g_object_unref (file);
+}
+
+static void
+auricle_renderer_open_outputs (AuricleRenderer *self)
+{
+  for (guint i = 0; i < self->file_data->len; i++)
+    {
+      AuricleRendererFileData *data = g_ptr_array_index (self->file_data, i);
+      if (data->output_path == NULL || data->streamed)
+        continue;
+
+      g_autoptr(GError) error = NULL;
+      g_autofree char *uri = g_filename_to_uri (data->output_path, NULL, &error);
+      if (uri == NULL || !g_app_info_launch_default_for_uri (uri, NULL, &error))
+        auricle_show_notification ("Failed to open %s: %s", data->output_path, error->message);
+    }
+}
+
+/* Records the checksums of the finished outputs in the output directory's manifest, which the sinks
+   computed while writing them. Entries for other files, e.g. from earlier renders, are kept. */
+static void
+auricle_renderer_write_checksums (AuricleRenderer *self)
+{
+  if (self->preview_duration != 0 || !auricle_render_options_get_write_checksums (self->render_options))
+    return;
+
+  const char *output_directory = auricle_render_options_get_output_directory (self->render_options);
+  g_autofree char *manifest_path = g_build_filename (output_directory, CHECKSUM_MANIFEST_NAME, NULL);
+
+  // The names are kept in the order they were first listed in.
+  g_autoptr(GPtrArray) names = g_ptr_array_new_with_free_func (g_free);
+  g_autoptr(GHashTable) checksums = g_hash_table_new_full (g_str_hash, g_str_equal, NULL, g_free);
+
+  g_autofree char *existing = NULL;
+  if (g_file_get_contents (manifest_path, &existing, NULL, NULL))
+    {
+      g_auto(GStrv) lines = g_strsplit (existing, "\n", -1);
+      for (char **line = lines; *line != NULL; line++)
+        {
+          // Each line is the checksum, a space, and then the name, marked with a * if it was hashed in
+          // binary mode.
+          if (strlen (*line) <= SHA256_HEX_LENGTH + 2 || (*line)[SHA256_HEX_LENGTH] != ' ' ||
+              g_hash_table_contains (checksums, *line + SHA256_HEX_LENGTH + 2))
+            continue;
+
+          char *name = g_strdup (*line + SHA256_HEX_LENGTH + 2);
+          g_ptr_array_add (names, name);
+          g_hash_table_replace (checksums, name, g_strndup (*line, SHA256_HEX_LENGTH));
+        }
+    }
+
+  gboolean changed = FALSE;
+  for (guint i = 0; i < self->file_data->len; i++)
+    {
+      AuricleRendererFileData *data = g_ptr_array_index (self->file_data, i);
+      const char *checksum = data->sink != NULL ? auricle_file_sink_get_checksum (AURICLE_FILE_SINK (data->sink))
+                                                : NULL;
+      if (checksum == NULL)
+        continue;
+
+      g_autofree char *name = g_path_get_basename (data->output_path);
+      gpointer listed_name;
+      if (!g_hash_table_lookup_extended (checksums, name, &listed_name, NULL))
+        {
+          listed_name = g_steal_pointer (&name);
+          g_ptr_array_add (names, listed_name);
+        }
+
+      g_hash_table_insert (checksums, listed_name, g_strdup (checksum));
+      changed = TRUE;
+    }
+
+  if (!changed)
+    return;
+
+  g_autoptr(GString) manifest = g_string_new (NULL);
+  for (guint i = 0; i < names->len; i++)
+    {
+      const char *name = g_ptr_array_index (names, i);
+      g_string_append_printf (manifest, "%s *%s\n", (char *) g_hash_table_lookup (checksums, name), name);
+    }
+
+  g_autoptr(GError) error = NULL;
+  if (!g_file_set_contents (manifest_path, manifest->str, manifest->len, &error))
+    auricle_show_notification ("Failed to write the checksums to %s: %s", manifest_path, error->message);
+}
+
+/* Writes the chapter listings of the albums that were moved into place. Streamed albums never
+   reach the output directory, so they don't get one. */
+static void
+auricle_renderer_write_chapter_listings (AuricleRenderer *self)
+{
+  for (guint i = 0; i < self->file_data->len; i++)
+    {
+      AuricleRendererFileData *data = g_ptr_array_index (self->file_data, i);
+      if (data->chapter_listing == NULL || data->streamed || data->sink == NULL ||
+          !auricle_file_sink_is_finished (AURICLE_FILE_SINK (data->sink)))
+        continue;
+
+      g_autofree char *output_directory = g_path_get_dirname (data->output_path);
+      g_autofree char *listing_basename = g_strdup_printf ("%s.chapters.txt",
+                                                           auricle_music_file_get_result_name (data->file));
+      g_autofree char *listing_path = g_build_filename (output_directory, listing_basename, NULL);
+      g_autoptr(GError) error = NULL;
+      if (!g_file_set_contents (listing_path, data->chapter_listing, -1, &error))
+        auricle_show_notification ("Failed to write the chapters to %s: %s", listing_path, error->message);
+    }
+}
+
+/* Records what the finished outputs were rendered from in the output directory's manifest. Entries
+   for skipped outputs and other files are kept as they were. */
+static void
+auricle_renderer_write_manifest (AuricleRenderer *self)
+{
+  if (self->manifest == NULL)
+    return;
+
+  gboolean changed = FALSE;
+  for (guint i = 0; i < self->file_data->len; i++)
+    {
+      AuricleRendererFileData *data = g_ptr_array_index (self->file_data, i);
+      if (data->sink == NULL || data->inputs == NULL ||
+          !auricle_file_sink_is_finished (AURICLE_FILE_SINK (data->sink)))
+        continue;
+
+      g_autofree char *name = g_path_get_basename (data->output_path);
+      g_key_file_remove_group (self->manifest, name, NULL);
+      g_key_file_set_string_list (self->manifest, name, "inputs", (const char * const *) data->inputs,
+                                  g_strv_length (data->inputs));
+      if (data->image_hash != NULL)
+        g_key_file_set_string (self->manifest, name, "image", data->image_hash);
+      g_key_file_set_string (self->manifest, name, "settings", data->settings_hash);
+      changed = TRUE;
+    }
+
+  if (!changed)
+    return;
+
+  const char *output_directory = auricle_render_options_get_output_directory (self->render_options);
+  g_autofree char *manifest_path = g_build_filename (output_directory, RENDER_MANIFEST_NAME, NULL);
+
+  g_autoptr(GError) error = NULL;
+  if (!g_key_file_save_to_file (self->manifest, manifest_path, &error))
+    auricle_show_notification ("Failed to write %s: %s", manifest_path, error->message);
+}
+
+static void
+on_output_command_finished (GObject      *source,
+                            GAsyncResult *result,
+                            gpointer      udata)
+{
+  g_autofree char *name = udata;
+  g_autoptr(GError) error = NULL;
+
+  if (!g_subprocess_wait_check_finish (G_SUBPROCESS (source), result, &error))
+    auricle_show_notification ("The output command for %s failed: %s", name, error->message);
+}
+
+/* Starts the output command for the given output, which is then written to its standard input
+   instead of to a file. It's run through the shell, with the names passed in the environment so
+   they don't need to be quoted. Returns the write end of its pipe, or -1 on failure. */
+static int
+auricle_renderer_spawn_output_command (AuricleRenderer          *self,
+                                       AuricleRendererFileData  *data,
+                                       const char               *output_basename,
+                                       GError                  **error)
+{
+  const char *command = auricle_render_options_get_output_command (self->render_options);
+
+  int fds[2];
+  if (!g_unix_open_pipe (fds, FD_CLOEXEC, error))
+    return -1;
+
+  g_autoptr(GSubprocessLauncher) launcher = g_subprocess_launcher_new (G_SUBPROCESS_FLAGS_NONE);
+  g_subprocess_launcher_take_stdin_fd (launcher, fds[0]);
+  g_subprocess_launcher_setenv (launcher, "AURICLE_RESULT_NAME", auricle_music_file_get_result_name (data->file),
+                                TRUE);
+  g_subprocess_launcher_setenv (launcher, "AURICLE_OUTPUT_NAME", output_basename, TRUE);
+  g_subprocess_launcher_setenv (launcher, "AURICLE_INPUT_PATH", auricle_music_file_get_path (data->file), TRUE);
+
+  g_autoptr(GSubprocess) process = g_subprocess_launcher_spawn (launcher, error, "/bin/sh", "-c", command, NULL);
+  if (process == NULL)
+    {
+      g_close (fds[1], NULL);
+      return -1;
+    }
+
+  g_subprocess_wait_check_async (process, NULL, on_output_command_finished, g_strdup (output_basename));
+  return fds[1];
 }
 
 static gboolean
@@ -274,8 +758,14 @@ on_bus_message (GstBus     *bus,
       // Fallthrough.
     case GST_MESSAGE_EOS:
       self->bus_watch_id = 0;
+      // Whatever did finish before an error is still recorded.
+      auricle_renderer_write_chapter_listings (self);
+      auricle_renderer_write_checksums (self);
+      auricle_renderer_write_manifest (self);
       auricle_show_notification ("Render complete");
-      /* g_signal_emit (self, COMPLETE, 0); */
+      if (GST_MESSAGE_TYPE (message) == GST_MESSAGE_EOS && self->preview_duration != 0)
+        auricle_renderer_open_outputs (self);
+      g_signal_emit (self, signals[COMPLETE], 0);
       return FALSE;
     default:
       break;
@@ -297,6 +787,42 @@ on_dec_pad_added (GstElement *el,
     }
 }
 
+static void
+on_passthrough_dec_pad_added (GstElement              *el,
+                              GstPad                  *pad,
+                              AuricleRendererFileData *data)
+{
+  g_autoptr(GstPad) queue_pad = gst_element_get_static_pad (data->audio_queue, "sink");
+  if (gst_pad_is_linked (queue_pad))
+    return;
+
+  g_autoptr(GstCaps) caps = gst_pad_get_current_caps (pad);
+  if (caps == NULL)
+    caps = gst_pad_query_caps (pad, NULL);
+
+  GstStructure *structure = gst_caps_get_structure (caps, 0);
+  if (gst_structure_has_name (structure, "audio/x-raw"))
+    {
+      GstElement *bin = GST_ELEMENT (gst_element_get_parent (data->audio_queue));
+      gst_bin_add (GST_BIN (bin), gst_object_ref (data->audio_enc));
+      gst_object_unref (bin);
+
+      gst_element_link (data->audio_enc, data->audio_queue);
+      gst_element_sync_state_with_parent (data->audio_enc);
+
+      g_autoptr(GstPad) enc_pad = gst_element_get_static_pad (data->audio_enc, "sink");
+      if (gst_pad_link (pad, enc_pad) != GST_PAD_LINK_OK)
+        g_error ("Failed to link pads");
+    }
+  else
+    {
+      g_info ("Passing through %s audio in %s", gst_structure_get_name (structure),
+              auricle_music_file_get_result_name (data->file));
+      if (gst_pad_link (pad, queue_pad) != GST_PAD_LINK_OK)
+        g_error ("Failed to link pads");
+    }
+}
+
 static gboolean
 on_progress_timer (gpointer udata)
 {
@@ -310,6 +836,8 @@ on_progress_timer (gpointer udata)
   for (int i = 0; i < self->file_data->len; i++)
     {
       AuricleRendererFileData *data = g_ptr_array_index (self->file_data, i);
+      if (data->sink == NULL && !data->skipped)
+        continue;
 
       AuricleRenderProgress *p = g_new0 (AuricleRenderProgress, 1);
       p->index = i;
@@ -321,6 +849,11 @@ on_progress_timer (gpointer udata)
 
           p->finished = TRUE;
           data->emitted_finished_progress = TRUE;
+
+          double elapsed = (g_get_monotonic_time () - data->start_time) / (double) G_USEC_PER_SEC;
+          if (GST_CLOCK_TIME_IS_VALID (data->duration) && elapsed > 0)
+            g_info ("Rendered %s at %.1fx realtime", auricle_music_file_get_result_name (data->file),
+                    (double) data->duration / GST_SECOND / elapsed);
         }
       else
         {
@@ -329,8 +862,15 @@ on_progress_timer (gpointer udata)
 
           gst_query_parse_position (position_query, NULL, &p->position);
           gst_query_parse_duration (duration_query, NULL, &p->duration);
+          // The concatenated tracks only report their own durations.
+          if (data->tracks != NULL && GST_CLOCK_TIME_IS_VALID (auricle_music_file_get_duration (data->file)))
+            p->duration = auricle_music_file_get_duration (data->file);
+          if (GST_CLOCK_TIME_IS_VALID (data->end_time) && p->duration > data->end_time)
+            p->duration = data->end_time;
           if (p->position > p->duration)
             p->position = p->duration;
+
+          data->duration = p->duration;
         }
 
       progress = g_list_prepend (progress, p);
@@ -350,41 +890,616 @@ on_progress_timer (gpointer udata)
 }
 
 static void
-on_image_src_needs_data (GstAppSrc *appsrc,
-                         guint      length,
-                         gpointer   udata)
+on_segment_src_needs_data (GstAppSrc *appsrc,
+                           guint      length,
+                           gpointer   udata)
+{
+  AuricleRendererFileData *data = udata;
+  g_autoptr(GError) error = NULL;
+
+  // The first request encodes the image, so this may block for a bit.
+  AuricleVideoSegment *segment = auricle_image_cache_get_segment (data->image_cache, data->image_key, &error);
+  if (segment == NULL)
+    {
+      GST_ELEMENT_ERROR (appsrc, STREAM, ENCODE, ("Failed to encode image: %s", error->message), (NULL));
+      return;
+    }
+
+  if (data->segment_repeat == 0)
+    gst_app_src_set_caps (appsrc, auricle_video_segment_get_caps (segment));
+
+  // Keep repeating the segment until the audio's EOS is forwarded to the muxer.
+  for (guint i = 0; i < auricle_video_segment_get_n_buffers (segment); i++)
+    gst_app_src_push_buffer (appsrc, auricle_video_segment_get_buffer (segment, data->segment_repeat, i));
+
+  data->segment_repeat++;
+}
+
+/* Picks the audio bitrate for a job. With match-source-bitrate, there's no point in spending more than
+   the source had, so its bitrate is used with a bit of headroom against generational loss, capped
+   by the configured bitrate. */
+static guint
+auricle_renderer_get_audio_bitrate (AuricleRenderer         *self,
+                                    AuricleRendererFileData *data)
 {
-  GstBuffer *buffer = GST_BUFFER (udata);
-  gst_app_src_push_buffer (appsrc, buffer);
-  gst_app_src_end_of_stream (appsrc);
+  guint max_bitrate = auricle_render_options_get_audio_bitrate (self->render_options);
+  guint source_bitrate = auricle_music_file_get_source_bitrate (data->file);
+
+  if (!auricle_render_options_get_match_source_bitrate (self->render_options) || source_bitrate == 0)
+    return max_bitrate;
+
+  guint bitrate = source_bitrate + source_bitrate / 8;
+  bitrate = MAX (bitrate, MIN_AUDIO_BITRATE);
+  // Encoders round to their own steps anyway, so keep to the usual ones.
+  bitrate = (bitrate + 31) / 32 * 32;
+  return MIN (bitrate, max_bitrate);
 }
 
+/* Returns the gain in dB bringing the job to the target loudness, without pushing its true peak past
+   the ceiling. */
+static double
+auricle_renderer_get_audio_gain (AuricleRenderer         *self,
+                                 AuricleRendererFileData *data)
+{
+  if (!auricle_render_options_get_normalize_loudness (self->render_options))
+    return 0;
+
+  double integrated_loudness, true_peak;
+  if (!auricle_music_file_get_loudness (data->file, &integrated_loudness, &true_peak))
+    {
+      auricle_show_notification ("The loudness of %s hasn't been measured yet, so it won't be normalized",
+                                 auricle_music_file_get_result_name (data->file));
+      return 0;
+    }
+
+  // Silence has no loudness to speak of.
+  if (!isfinite (integrated_loudness))
+    return 0;
+
+  double gain = auricle_render_options_get_target_loudness (self->render_options) - integrated_loudness;
+  if (isfinite (true_peak))
+    gain = MIN (gain, TRUE_PEAK_CEILING - true_peak);
+
+  g_info ("Applying %.1f dB of gain to %s", gain, auricle_music_file_get_result_name (data->file));
+  return gain;
+}
+
+/* Returns how many ranges to encode the job's audio in parallel with, or 1 to decode it in the render
+   pipeline as usual. */
+static guint
+auricle_renderer_get_chunk_count (AuricleRenderer         *self,
+                                  AuricleRendererFileData *data,
+                                  const char              *scope,
+                                  GstCaps                 *passthrough_caps)
+{
+  // Visualizers need the decoded audio as it plays, and previews are too short to bother.
+  if (scope != NULL || self->preview_duration != 0 ||
+      !auricle_render_options_get_parallel_encoding (self->render_options))
+    return 1;
+
+  // Jobs sharing a decoder get their audio from it.
+  GstClockTime start, end;
+  if (auricle_music_file_get_range (data->file, &start, &end) || data->tracks != NULL || self->renditions->len > 1)
+    return 1;
+
+  // Each range starts with a seek, which tracks read out of an archive can't do.
+  g_autofree char *archive_path = NULL;
+  g_autofree char *member = NULL;
+  if (auricle_archive_split_path (auricle_music_file_get_path (data->file), &archive_path, &member))
+    return 1;
+
+  // Copying the audio over is already as cheap as it gets.
+  GstCaps *source_caps = auricle_music_file_get_source_caps (data->file);
+  if (passthrough_caps != NULL && (source_caps == NULL || gst_caps_can_intersect (source_caps, passthrough_caps)))
+    {
+      GstStructure *structure = source_caps != NULL ? gst_caps_get_structure (source_caps, 0) : NULL;
+      if (structure == NULL || !gst_structure_has_name (structure, "audio/x-raw"))
+        return 1;
+    }
+
+  return auricle_chunked_audio_get_chunk_count (auricle_music_file_get_duration (data->file));
+}
+
+static GstPadProbeReturn
+on_preview_buffer (GstPad          *pad,
+                   GstPadProbeInfo *info,
+                   gpointer         udata)
+{
+  AuricleRendererFileData *data = udata;
+  GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+
+  if (GST_PAD_IS_EOS (pad))
+    return GST_PAD_PROBE_DROP;
+  if (!GST_BUFFER_PTS_IS_VALID (buffer) || GST_BUFFER_PTS (buffer) < data->end_time)
+    return GST_PAD_PROBE_OK;
+
+  // Cut the track off here. The decoder stops on its own once its pushes start returning EOS.
+  g_info ("Ending the preview of %s", auricle_music_file_get_result_name (data->file));
+  gst_pad_push_event (pad, gst_event_new_eos ());
+  return GST_PAD_PROBE_DROP;
+}
+
+static void
+on_preview_dec_pad_added (GstElement              *el,
+                          GstPad                  *pad,
+                          AuricleRendererFileData *data)
+{
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER, on_preview_buffer, data, NULL);
+}
+
+static GstPadProbeReturn
+on_range_buffer (GstPad          *pad,
+                 GstPadProbeInfo *info,
+                 gpointer         udata)
+{
+  AuricleRendererFileData *data = udata;
+  GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+
+  if (data->range_done || !GST_BUFFER_PTS_IS_VALID (buffer))
+    return GST_PAD_PROBE_DROP;
+
+  GstClockTime end = GST_CLOCK_TIME_NONE;
+  if (GST_CLOCK_TIME_IS_VALID (data->end_time))
+    end = data->range_start + data->end_time;
+
+  if (GST_CLOCK_TIME_IS_VALID (end) && GST_BUFFER_PTS (buffer) >= end)
+    {
+      // The decoder keeps going for the later tracks, so the EOS is sent past this pad to keep it
+      // from reaching the tee.
+      g_info ("Reached the end of %s", auricle_music_file_get_result_name (data->file));
+      data->range_done = TRUE;
+
+      g_autoptr(GstPad) peer = gst_pad_get_peer (pad);
+      gst_pad_send_event (peer, gst_event_new_eos ());
+      return GST_PAD_PROBE_DROP;
+    }
+
+  g_autoptr(GstCaps) caps = gst_pad_get_current_caps (pad);
+  GstAudioInfo audio_info;
+  if (caps == NULL || !gst_audio_info_from_caps (&audio_info, caps))
+    return GST_PAD_PROBE_DROP;
+
+  // Trim the buffers on the edges down to the exact sample, and start the output from zero.
+  GstSegment segment;
+  gst_segment_init (&segment, GST_FORMAT_TIME);
+  segment.start = data->range_start;
+  segment.stop = end;
+
+  GstBuffer *clipped = gst_audio_buffer_clip (gst_buffer_ref (buffer), &segment,
+                                              GST_AUDIO_INFO_RATE (&audio_info), GST_AUDIO_INFO_BPF (&audio_info));
+  if (clipped == NULL)
+    return GST_PAD_PROBE_DROP;
+
+  gst_buffer_unref (buffer);
+  clipped = gst_buffer_make_writable (clipped);
+  GST_BUFFER_PTS (clipped) -= data->range_start;
+  GST_PAD_PROBE_INFO_DATA (info) = clipped;
+
+  return GST_PAD_PROBE_OK;
+}
+
+
+/* Returns how long a track of an album plays for, which for tracks from a CUE sheet is only their
+   part of the file. */
+static GstClockTime
+get_track_length (AuricleMusicFile *track)
+{
+  GstClockTime duration = auricle_music_file_get_duration (track);
+  GstClockTime start, end;
+
+  if (!auricle_music_file_get_range (track, &start, &end))
+    return duration;
+  if (GST_CLOCK_TIME_IS_VALID (end))
+    return end - start;
+  if (GST_CLOCK_TIME_IS_VALID (duration) && duration > start)
+    return duration - start;
+  return GST_CLOCK_TIME_NONE;
+}
+
+/* Whether the track continues the file of the one before, as the tracks of a CUE sheet do. Such a file
+   is only played once, with the tracks as chapters in it. */
+static gboolean
+continues_previous_track (GPtrArray *tracks,
+                          guint      index)
+{
+  GstClockTime start, end;
+  if (index == 0 || !auricle_music_file_get_range (g_ptr_array_index (tracks, index), &start, &end))
+    return FALSE;
+
+  AuricleMusicFile *previous = g_ptr_array_index (tracks, index - 1);
+  return auricle_music_file_get_range (previous, &start, &end) &&
+         g_strcmp0 (auricle_music_file_get_path (previous),
+                    auricle_music_file_get_path (g_ptr_array_index (tracks, index))) == 0;
+}
+
+/* Works out the album's duration and loudness from its tracks'. */
+static void
+auricle_renderer_measure_album (AuricleRendererFileData *data)
+{
+  GstClockTime duration = 0;
+  double power = 0, true_peak = -INFINITY;
+  gboolean has_loudness = TRUE;
+
+  for (guint i = 0; i < data->tracks->len; i++)
+    {
+      AuricleMusicFile *track = g_ptr_array_index (data->tracks, i);
+      GstClockTime track_duration = get_track_length (track);
+      double track_loudness, track_peak;
+
+      if (GST_CLOCK_TIME_IS_VALID (duration) && GST_CLOCK_TIME_IS_VALID (track_duration))
+        duration += track_duration;
+      else
+        duration = GST_CLOCK_TIME_NONE;
+
+      if (!GST_CLOCK_TIME_IS_VALID (track_duration) ||
+          !auricle_music_file_get_loudness (track, &track_loudness, &track_peak))
+        {
+          has_loudness = FALSE;
+          continue;
+        }
+
+      // Each track's mean power counts for as long as it plays. Unlike measuring the whole album, this
+      // doesn't gate out quiet passages across tracks, which is close enough to normalize with.
+      if (isfinite (track_loudness))
+        power += pow (10, track_loudness / 10) * ((double) track_duration / GST_SECOND);
+      true_peak = MAX (true_peak, track_peak);
+    }
+
+  auricle_music_file_set_duration (data->file, duration);
+  if (has_loudness && GST_CLOCK_TIME_IS_VALID (duration) && duration > 0)
+    auricle_music_file_set_loudness (data->file, 10 * log10 (power / ((double) duration / GST_SECOND)), true_peak);
+}
+
+static void
+on_album_dec_pad_added (GstElement *el,
+                        GstPad     *pad,
+                        GstPad     *concat_pad)
+{
+  if (!gst_pad_is_linked (concat_pad))
+    {
+      if (gst_pad_link (pad, concat_pad) != GST_PAD_LINK_OK)
+        g_error ("Failed to link pads");
+    }
+}
+
+/* Plays the album's tracks back to back as one stream, so the encoders and muxer are only set up
+   once. */
 static GstElement *
-auricle_renderer_create_image_source (AuricleRenderer *self)
+auricle_renderer_create_album_source (AuricleRenderer         *self,
+                                      AuricleRendererFileData *data)
+{
+  GstElement *concat = gst_element_factory_make ("concat", NULL);
+  gst_bin_add (GST_BIN (self->pipeline), concat);
+
+  for (guint i = 0; i < data->tracks->len; i++)
+    {
+      AuricleMusicFile *track = g_ptr_array_index (data->tracks, i);
+      if (continues_previous_track (data->tracks, i))
+        continue;
+
+      GstElement *src = auricle_file_source_new (auricle_music_file_get_path (track));
+      GstElement *dec = gst_element_factory_make ("decodebin3", NULL);
+
+      gst_bin_add_many (GST_BIN (self->pipeline), src, dec, NULL);
+      gst_element_link (src, dec);
+
+      // The pads are all requested up front, since that's the order they're played in.
+      GstPad *concat_pad = gst_element_get_request_pad (concat, "sink_%u");
+      g_signal_connect_data (dec, "pad-added", G_CALLBACK (on_album_dec_pad_added), concat_pad,
+                             (GClosureNotify) gst_object_unref, 0);
+    }
+
+  return concat;
+}
+
+/* Marks a chapter at the start of each track, for the muxers that support them. The chapters are also
+   listed as timestamps, which is how video sites pick them up from a description, to write out next to
+   the video once it's done. Nothing is marked if a track's duration isn't known. */
+static void
+auricle_renderer_add_album_chapters (AuricleRendererFileData *data,
+                                     GstElement              *mux)
 {
-  g_warn_if_fail (gdk_pixbuf_get_colorspace (self->pixbuf) == GDK_COLORSPACE_RGB);
+  g_autoptr(GstToc) toc = gst_toc_new (GST_TOC_SCOPE_GLOBAL);
+  GstTocEntry *edition = gst_toc_entry_new (GST_TOC_ENTRY_TYPE_EDITION, "album");
+  g_autoptr(GString) listing = g_string_new ("");
+  GstClockTime start = 0;
 
-  GstVideoInfo info;
-  gst_video_info_init (&info);
-  gst_video_info_set_format (&info,
-                             gdk_pixbuf_get_has_alpha (self->pixbuf) ? GST_VIDEO_FORMAT_RGBA : GST_VIDEO_FORMAT_RGB,
-                             gdk_pixbuf_get_width (self->pixbuf), gdk_pixbuf_get_height (self->pixbuf));
-  info.fps_n = 0;
-  info.fps_d = 1;
+  for (guint i = 0; i < data->tracks->len; i++)
+    {
+      AuricleMusicFile *track = g_ptr_array_index (data->tracks, i);
+      GstClockTime duration = get_track_length (track);
+      if (!GST_CLOCK_TIME_IS_VALID (duration))
+        {
+          auricle_show_notification ("The length of %s isn't known, so the album won't have chapters",
+                                     auricle_music_file_get_result_name (track));
+          gst_toc_entry_unref (edition);
+          return;
+        }
 
-  g_autoptr(GstCaps) caps = gst_video_info_to_caps (&info);
+      GHashTable *track_vars = auricle_music_file_get_template_vars (track);
+      char **title_tag = track_vars != NULL ? g_hash_table_lookup (track_vars, GST_TAG_TITLE) : NULL;
+      const char *title = title_tag != NULL && title_tag[0] != NULL ? title_tag[0]
+                                                                     : auricle_music_file_get_result_name (track);
+
+      g_autofree char *uid = g_strdup_printf ("chapter%u", i + 1);
+      GstTocEntry *chapter = gst_toc_entry_new (GST_TOC_ENTRY_TYPE_CHAPTER, uid);
+      gst_toc_entry_set_start_stop_times (chapter, start, start + duration);
+      gst_toc_entry_set_tags (chapter, gst_tag_list_new (GST_TAG_TITLE, title, NULL));
+      gst_toc_entry_append_sub_entry (edition, chapter);
+
+      guint seconds = start / GST_SECOND;
+      if (seconds >= 3600)
+        g_string_append_printf (listing, "%u:%02u:%02u %s\n", seconds / 3600, seconds / 60 % 60, seconds % 60,
+                                title);
+      else
+        g_string_append_printf (listing, "%u:%02u %s\n", seconds / 60, seconds % 60, title);
+
+      start += duration;
+    }
 
-  gsize byte_buffer_size = gdk_pixbuf_get_byte_length (self->pixbuf);
-  char *byte_buffer = g_memdup (gdk_pixbuf_read_pixels (self->pixbuf), byte_buffer_size);
-  GstBuffer *buffer = gst_buffer_new_wrapped (byte_buffer, byte_buffer_size);
+  gst_toc_append_entry (toc, edition);
+  if (GST_IS_TOC_SETTER (mux))
+    gst_toc_setter_set_toc (GST_TOC_SETTER (mux), toc);
 
+  g_free (data->chapter_listing);
+  data->chapter_listing = g_string_free (g_steal_pointer (&listing), FALSE);
+}
+
+/* Jobs decoding the same source, like the tracks of a CUE sheet or the renditions of a file, all
+   branch off one decoder, so it's only decoded once. */
+static GstElement *
+auricle_renderer_get_shared_source (AuricleRenderer         *self,
+                                    GHashTable              *shared_sources,
+                                    AuricleRendererFileData *data)
+{
+  // There's only ever one album, and no file has an empty path.
+  const char *key = data->tracks != NULL ? "" : auricle_music_file_get_path (data->file);
+  GstElement *tee = g_hash_table_lookup (shared_sources, key);
+  if (tee != NULL)
+    return tee;
+
+  tee = gst_element_factory_make ("tee", NULL);
+  gst_bin_add (GST_BIN (self->pipeline), tee);
+
+  if (data->tracks != NULL)
+    {
+      GstElement *concat = auricle_renderer_create_album_source (self, data);
+      gst_element_link (concat, tee);
+    }
+  else
+    {
+      GstElement *src = auricle_file_source_new (key);
+      GstElement *dec = gst_element_factory_make ("decodebin3", NULL);
+
+      gst_bin_add_many (GST_BIN (self->pipeline), src, dec, NULL);
+      gst_element_link (src, dec);
+      g_signal_connect (dec, "pad-added", G_CALLBACK (on_dec_pad_added), tee);
+    }
+
+  g_hash_table_insert (shared_sources, g_strdup (key), tee);
+  return tee;
+}
+
+static GstElement *
+auricle_renderer_create_video_source (AuricleRenderer         *self,
+                                      AuricleRendererFileData *data)
+{
   GstElement *src = gst_element_factory_make ("appsrc", NULL);
-  gst_app_src_set_caps (GST_APP_SRC (src), caps);
-  g_signal_connect (src, "need-data", G_CALLBACK (on_image_src_needs_data), buffer);
+  g_object_set (src, "format", GST_FORMAT_TIME, NULL);
+  g_signal_connect (src, "need-data", G_CALLBACK (on_segment_src_needs_data), data);
 
   return src;
 }
 
+static const char *
+scope_for_render_mode (AuricleRenderMode mode)
+{
+  switch (mode)
+    {
+    case AURICLE_RENDER_MODE_WAVEFORM:
+      return "wavescope";
+    case AURICLE_RENDER_MODE_SPECTRUM:
+      return "spectrascope";
+    default:
+      return NULL;
+    }
+}
+
+static const char *folder_image_names[] = {
+  "cover.jpg", "Cover.jpg", "cover.png",
+  "folder.jpg", "Folder.jpg", "folder.png",
+  "front.jpg", "Front.jpg", "front.png",
+  NULL,
+};
+
+static char *
+find_folder_image (const char *track_path)
+{
+  g_autofree char *dirname = g_path_get_dirname (track_path);
+
+  for (const char **name = folder_image_names; *name != NULL; name++)
+    {
+      g_autofree char *path = g_build_filename (dirname, *name, NULL);
+      if (g_file_test (path, G_FILE_TEST_IS_REGULAR))
+        return g_steal_pointer (&path);
+    }
+
+  return NULL;
+}
+
+static char *
+auricle_renderer_add_track_artwork (AuricleRenderer         *self,
+                                    AuricleRendererFileData *data,
+                                    AuricleImageCache       *image_cache)
+{
+  g_autoptr(GError) error = NULL;
+  const char *path = auricle_music_file_get_path (data->file);
+
+  GBytes *cover = auricle_music_file_get_cover (data->file);
+  if (cover != NULL)
+    {
+      char *key = auricle_image_cache_add_bytes (image_cache, cover, &error);
+      if (key != NULL)
+        return key;
+
+      g_warning ("Failed to load the cover art embedded in %s: %s", path, error->message);
+      g_clear_error (&error);
+    }
+
+  g_autofree char *folder_image = find_folder_image (path);
+  if (folder_image != NULL)
+    {
+      char *key = auricle_image_cache_add_file (image_cache, folder_image, &error);
+      if (key != NULL)
+        return key;
+
+      g_warning ("Failed to load %s: %s", folder_image, error->message);
+    }
+
+  return NULL;
+}
+
+static GPtrArray *
+auricle_renderer_add_slideshow_images (AuricleRenderer   *self,
+                                       AuricleImageCache *image_cache)
+{
+  GPtrArray *keys = g_ptr_array_new_with_free_func (g_free);
+  const char * const *paths = auricle_render_options_get_slideshow_images (self->render_options);
+
+  for (; paths != NULL && *paths != NULL; paths++)
+    {
+      g_autoptr(GError) error = NULL;
+      char *key = auricle_image_cache_add_file (image_cache, *paths, &error);
+      if (key == NULL)
+        {
+          g_warning ("Failed to load slideshow image %s: %s", *paths, error->message);
+          auricle_show_notification ("Failed to load slideshow image %s: %s", *paths, error->message);
+          continue;
+        }
+
+      g_ptr_array_add (keys, key);
+    }
+
+  return keys;
+}
+
+/* Picks the image (or slideshow) for the given job, returning its key in the image cache. */
+static char *
+auricle_renderer_add_job_image (AuricleRenderer         *self,
+                                AuricleRendererFileData *data,
+                                AuricleImageCache       *image_cache,
+                                const char              *default_key,
+                                GPtrArray               *slideshow_keys)
+{
+  g_autofree char *key = NULL;
+
+  if (auricle_render_options_get_track_artwork (self->render_options))
+    key = auricle_renderer_add_track_artwork (self, data, image_cache);
+  if (key == NULL)
+    key = g_strdup (default_key);
+
+  if (auricle_render_options_get_render_mode (self->render_options) == AURICLE_RENDER_MODE_SLIDESHOW &&
+      slideshow_keys->len > 0)
+    {
+      // The job's own image comes first, followed by the rest of the slideshow.
+      g_autoptr(GPtrArray) keys = g_ptr_array_new ();
+      g_ptr_array_add (keys, key);
+      for (guint i = 0; i < slideshow_keys->len; i++)
+        g_ptr_array_add (keys, g_ptr_array_index (slideshow_keys, i));
+      g_ptr_array_add (keys, NULL);
+
+      GstClockTime dwell = auricle_render_options_get_slideshow_dwell (self->render_options) * GST_SECOND;
+      char *slideshow_key = auricle_image_cache_add_slideshow (image_cache,
+                                                               (const char * const *) keys->pdata, dwell);
+      g_free (key);
+      key = slideshow_key;
+    }
+
+  const char *caption_template = auricle_render_options_get_caption_template (self->render_options);
+  GHashTable *template_vars = auricle_music_file_get_template_vars (data->file);
+
+  if (caption_template == NULL || *caption_template == '\0' || template_vars == NULL)
+    return g_steal_pointer (&key);
+
+  g_autofree char *caption = auricle_substitute (caption_template, template_vars);
+  return auricle_image_cache_add_caption (image_cache, key, caption);
+}
+
+static gboolean
+auricle_renderer_resolve_codecs (AuricleRenderer          *self,
+                                 AuricleRendererRendition *rendition,
+                                 GError                  **error)
+{
+  gboolean audio_only = auricle_render_options_get_render_mode (self->render_options) ==
+                        AURICLE_RENDER_MODE_AUDIO_ONLY;
+  const char *options_video_id = auricle_render_options_get_video_encoder (self->render_options);
+  const char *muxer_id = rendition->muxer_id != NULL ? rendition->muxer_id
+                                                     : auricle_render_options_get_muxer (self->render_options);
+  const char *video_id = rendition->video_id != NULL ? rendition->video_id : options_video_id;
+  const char *audio_id = rendition->audio_id != NULL ? rendition->audio_id
+                                                     : auricle_render_options_get_audio_encoder (self->render_options);
+
+  if (!auricle_codecs_resolve (muxer_id, video_id, audio_id, &rendition->muxer,
+                               audio_only ? NULL : &rendition->video_codec, &rendition->audio_codec, error))
+    return FALSE;
+
+  // Other renditions quietly switch the encoders they didn't ask for to ones their muxer takes. Audio-only
+  // renders swap in the audio-only version of the muxer without it counting as a change.
+  gboolean is_main = rendition == g_ptr_array_index (self->renditions, 0);
+  const AuricleCodec *requested_muxer = auricle_codecs_find (AURICLE_CODEC_KIND_MUXER, muxer_id);
+  gboolean muxer_changed = audio_only ? requested_muxer == NULL ||
+                                        g_strcmp0 (rendition->muxer->element, requested_muxer->element) != 0
+                                      : g_strcmp0 (rendition->muxer->id, muxer_id) != 0;
+  gboolean changed =
+    ((is_main || rendition->muxer_id != NULL) && muxer_changed) ||
+    (!audio_only && (is_main || rendition->video_id != NULL) && g_strcmp0 (rendition->video_codec->id, video_id) != 0) ||
+    ((is_main || rendition->audio_id != NULL) && g_strcmp0 (rendition->audio_codec->id, audio_id) != 0);
+  if (changed && audio_only)
+    auricle_show_notification ("The chosen formats aren't available, using %s with %s instead",
+                               rendition->muxer->name, rendition->audio_codec->name);
+  else if (changed)
+    auricle_show_notification ("The chosen formats aren't available, using %s with %s and %s instead",
+                               rendition->muxer->name, rendition->video_codec->name, rendition->audio_codec->name);
+
+  // The preset only makes sense for the encoder it was picked for.
+  rendition->video_preset = NULL;
+  if (audio_only)
+    return TRUE;
+
+  if (self->preview_duration != 0 && rendition->video_codec->presets != NULL)
+    rendition->video_preset = rendition->video_codec->presets[0];
+  else if (g_strcmp0 (rendition->video_codec->id, options_video_id) == 0)
+    rendition->video_preset = auricle_render_options_get_video_preset (self->render_options);
+
+  return TRUE;
+}
+
+/* Sets up the images for each rendition. Renditions with the same video encoder share its cache,
+   and so the stills encoded for it. */
+static void
+auricle_renderer_add_rendition_images (AuricleRenderer *self)
+{
+  AuricleRendererRendition *main_rendition = g_ptr_array_index (self->renditions, 0);
+
+  for (guint i = 0; i < self->renditions->len; i++)
+    {
+      AuricleRendererRendition *rendition = g_ptr_array_index (self->renditions, i);
+
+      if (i != 0 && rendition->video_codec == main_rendition->video_codec &&
+          g_strcmp0 (rendition->video_preset, main_rendition->video_preset) == 0)
+        {
+          rendition->image_cache = g_object_ref (main_rendition->image_cache);
+          rendition->default_image_key = g_strdup (main_rendition->default_image_key);
+          rendition->slideshow_keys = g_ptr_array_ref (main_rendition->slideshow_keys);
+          continue;
+        }
+
+      rendition->image_cache = auricle_image_cache_new (rendition->video_codec, rendition->video_preset);
+      rendition->default_image_key = auricle_image_cache_add_pixbuf (rendition->image_cache, self->pixbuf);
+      rendition->slideshow_keys = auricle_renderer_add_slideshow_images (self, rendition->image_cache);
+    }
+}
+
 AuricleMusicFile *
 auricle_renderer_get_file (AuricleRenderer *self,
                            int              index)
@@ -446,75 +1561,514 @@ add_downstream_event_probe (GstPad                  *pad,
   data->pad_probes = g_list_prepend (data->pad_probes, probe);
 }
 
+/* Returns how long the job's output will be, if it's known. */
+static GstClockTime
+auricle_renderer_get_output_duration (AuricleRendererFileData *data)
+{
+  return GST_CLOCK_TIME_IS_VALID (data->end_time) ? data->end_time : auricle_music_file_get_duration (data->file);
+}
+
+/* Estimates the output size from the audio bitrate, so the file can be preallocated. A still image
+   adds little on top, and whatever a visualizer adds is just allocated as it's written. Returns 0 if
+   the length isn't known. */
+static guint64
+auricle_renderer_estimate_output_size (AuricleRendererFileData    *data,
+                                       const AuricleCodecSettings *audio_settings)
+{
+  GstClockTime duration = auricle_renderer_get_output_duration (data);
+  if (!GST_CLOCK_TIME_IS_VALID (duration))
+    return 0;
+
+  return gst_util_uint64_scale (duration, audio_settings->bitrate * 1000 / 8, GST_SECOND);
+}
+
+/* Returns the command outputs are piped into, or NULL if they're written to files. */
+static const char *
+auricle_renderer_get_output_command (AuricleRenderer *self)
+{
+  const char *output_command = auricle_render_options_get_output_command (self->render_options);
+  if (self->preview_duration != 0 || output_command == NULL || *output_command == '\0')
+    return NULL;
+
+  return output_command;
+}
+
+/* Describes each of the job's inputs by its size, modification time and path, or returns NULL if
+   one can't be found. Tracks in an archive go by the archive's. */
+static GStrv
+auricle_renderer_stat_inputs (AuricleRendererFileData *data)
+{
+  g_autoptr(GPtrArray) inputs = g_ptr_array_new_with_free_func (g_free);
+  guint n_inputs = data->tracks != NULL ? data->tracks->len : 1;
+
+  for (guint i = 0; i < n_inputs; i++)
+    {
+      AuricleMusicFile *file = data->tracks != NULL ? g_ptr_array_index (data->tracks, i) : data->file;
+      const char *path = auricle_music_file_get_path (file);
+
+      g_autofree char *archive_path = NULL;
+      g_autofree char *member = NULL;
+      GStatBuf st;
+      if (g_stat (auricle_archive_split_path (path, &archive_path, &member) ? archive_path : path, &st) != 0)
+        return NULL;
+
+      g_ptr_array_add (inputs, g_strdup_printf ("%" G_GINT64_FORMAT " %" G_GINT64_FORMAT " %s",
+                                                (gint64) st.st_size, (gint64) st.st_mtime, path));
+    }
+
+  g_ptr_array_add (inputs, NULL);
+  return (GStrv) g_ptr_array_free (g_steal_pointer (&inputs), FALSE);
+}
+
+/* Hashes everything besides the inputs and image that goes into the job's output: the options, the
+   formats, and the settings worked out for the job itself. */
+static char *
+auricle_renderer_hash_settings (AuricleRenderer            *self,
+                                AuricleRendererFileData    *data,
+                                const AuricleCodecSettings *audio_settings)
+{
+  g_autoptr(GString) settings = g_string_new (NULL);
+
+  guint n_pspecs;
+  g_autofree GParamSpec **pspecs = g_object_class_list_properties (G_OBJECT_GET_CLASS (self->render_options),
+                                                                   &n_pspecs);
+  for (guint i = 0; i < n_pspecs; i++)
+    {
+      if (g_strv_contains (unrendered_options, pspecs[i]->name))
+        continue;
+
+      g_auto(GValue) value = G_VALUE_INIT;
+      g_value_init (&value, pspecs[i]->value_type);
+      g_object_get_property (G_OBJECT (self->render_options), pspecs[i]->name, &value);
+
+      g_autofree char *contents = g_strdup_value_contents (&value);
+      g_string_append_printf (settings, "%s=%s\n", pspecs[i]->name, contents);
+    }
+
+  AuricleRendererRendition *rendition = data->rendition;
+  GstClockTime range_start, range_end;
+  if (!auricle_music_file_get_range (data->file, &range_start, &range_end))
+    range_start = range_end = GST_CLOCK_TIME_NONE;
+
+  g_string_append_printf (settings, "muxer=%s\nvideo=%s\naudio=%s\npreset=%s\nheight=%d\n",
+                          rendition->muxer->id, rendition->video_codec != NULL ? rendition->video_codec->id : "",
+                          rendition->audio_codec->id, rendition->video_preset != NULL ? rendition->video_preset : "",
+                          rendition->height);
+  g_string_append_printf (settings, "bitrate=%u\ngain=%.2f\nrange=%" G_GUINT64_FORMAT "-%" G_GUINT64_FORMAT "\n",
+                          audio_settings->bitrate, audio_settings->gain_db, range_start, range_end);
+
+  return g_compute_checksum_for_string (G_CHECKSUM_SHA256, settings->str, settings->len);
+}
+
+/* Returns whether the output was already rendered from the same inputs, image and settings, going
+   by the manifest. */
+static gboolean
+auricle_renderer_is_up_to_date (AuricleRenderer         *self,
+                                AuricleRendererFileData *data,
+                                const char              *output_basename,
+                                const char              *output_path)
+{
+  if (data->inputs == NULL || !g_file_test (output_path, G_FILE_TEST_IS_REGULAR))
+    return FALSE;
+
+  g_auto(GStrv) inputs = g_key_file_get_string_list (self->manifest, output_basename, "inputs", NULL, NULL);
+  g_autofree char *image_hash = g_key_file_get_string (self->manifest, output_basename, "image", NULL);
+  g_autofree char *settings_hash = g_key_file_get_string (self->manifest, output_basename, "settings", NULL);
+  if (inputs == NULL || g_strv_length (inputs) != g_strv_length (data->inputs))
+    return FALSE;
+
+  for (guint i = 0; inputs[i] != NULL; i++)
+    if (g_strcmp0 (inputs[i], data->inputs[i]) != 0)
+      return FALSE;
+
+  return g_strcmp0 (image_hash, data->image_hash) == 0 && g_strcmp0 (settings_hash, data->settings_hash) == 0;
+}
+
+/* Turns the next run into a quick preview: only the given duration of each track is rendered, at a
+   reduced size with the fastest encoder preset, into a temporary directory. The results are opened
+   once they're done. */
+void
+auricle_renderer_set_preview (AuricleRenderer *self,
+                              GstClockTime     duration)
+{
+  g_return_if_fail (self->pipeline == NULL);
+  self->preview_duration = duration;
+}
+
 void
 auricle_renderer_run (AuricleRenderer *self)
 {
   const char *output_directory = auricle_render_options_get_output_directory (self->render_options);
-  guint audio_bitrate = auricle_render_options_get_audio_bitrate (self->render_options);
+  AuricleRenderMode render_mode = auricle_render_options_get_render_mode (self->render_options);
+  gboolean audio_only = render_mode == AURICLE_RENDER_MODE_AUDIO_ONLY;
+
+  g_autofree char *preview_directory = NULL;
+  if (self->preview_duration != 0)
+    {
+      preview_directory = g_build_filename (g_get_user_cache_dir (), "auricle", "preview", NULL);
+      g_mkdir_with_parents (preview_directory, 0755);
+      output_directory = preview_directory;
+    }
 
   g_return_if_fail (self->pipeline == NULL);
-  g_return_if_fail (self->pixbuf != NULL);
   g_return_if_fail (output_directory != NULL);
+
+  if (self->pixbuf == NULL && !audio_only)
+    {
+      auricle_show_notification ("Cannot render: no image was chosen");
+      g_signal_emit (self, signals[COMPLETE], 0);
+      return;
+    }
+
+  GPtrArray *renditions = auricle_renderer_get_renditions (self);
+  for (guint i = 0; i < renditions->len; i++)
+    {
+      g_autoptr(GError) codec_error = NULL;
+      if (!auricle_renderer_resolve_codecs (self, g_ptr_array_index (renditions, i), &codec_error))
+        {
+          auricle_show_notification ("Cannot render: %s", codec_error->message);
+          g_signal_emit (self, signals[COMPLETE], 0);
+          return;
+        }
+    }
+
+  // Streamed outputs never land in the output directory, so there's nothing to compare them with.
+  if (self->preview_duration == 0 && auricle_renderer_get_output_command (self) == NULL &&
+      auricle_render_options_get_skip_unchanged (self->render_options))
+    {
+      g_autofree char *manifest_path = g_build_filename (output_directory, RENDER_MANIFEST_NAME, NULL);
+      self->manifest = g_key_file_new ();
+      g_key_file_load_from_file (self->manifest, manifest_path, G_KEY_FILE_NONE, NULL);
+    }
+
   self->pipeline = gst_pipeline_new ("render-pipeline");
 
   self->bus_watch_id = gst_bus_add_watch (GST_ELEMENT_BUS (self->pipeline), on_bus_message, self);
 
+  if (!audio_only)
+    auricle_renderer_add_rendition_images (self);
+  g_autoptr(GHashTable) shared_sources = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  guint n_rendering = 0, n_skipped = 0;
+
   for (int i = 0; i < self->file_data->len; i++)
     {
       AuricleRendererFileData *data = g_ptr_array_index (self->file_data, i);
       g_info ("Adding %s -> %s to pipeline", auricle_music_file_get_path (data->file),
                auricle_music_file_get_result_name (data->file));
 
-      GstElement *image_src = auricle_renderer_create_image_source (self);
-      GstElement *image_conv = gst_element_factory_make ("videoconvert", NULL);
-      GstElement *image_freeze = gst_element_factory_make ("imagefreeze", NULL);
-      GstElement *image_enc = gst_element_factory_make ("x264enc", NULL);
+      AuricleRendererRendition *rendition = data->rendition;
+      data->end_time = GST_CLOCK_TIME_NONE;
 
-      g_autofree char *output_basename = g_strdup_printf ("%s.mp4", auricle_music_file_get_result_name (data->file));
+      if (!audio_only)
+        {
+          data->image_cache = g_object_ref (rendition->image_cache);
+          data->image_key = auricle_renderer_add_job_image (self, data, rendition->image_cache,
+                                                            rendition->default_image_key, rendition->slideshow_keys);
+        }
+
+      if (!audio_only && rendition->height != 0)
+        {
+          g_autofree char *full_key = g_steal_pointer (&data->image_key);
+          data->image_key = auricle_image_cache_add_scaled (rendition->image_cache, full_key, rendition->height);
+        }
+
+      if (data->tracks != NULL)
+        auricle_renderer_measure_album (data);
+
+      GstClockTime range_start, range_end;
+      gboolean ranged = auricle_music_file_get_range (data->file, &range_start, &range_end);
+      gboolean shared = ranged || renditions->len > 1;
+      if (ranged)
+        {
+          GstClockTime source_duration = auricle_music_file_get_duration (data->file);
+          if (!GST_CLOCK_TIME_IS_VALID (range_end))
+            range_end = source_duration;
+
+          data->range_start = range_start;
+          if (GST_CLOCK_TIME_IS_VALID (range_end) && range_end > range_start)
+            data->end_time = range_end - range_start;
+        }
+
+      if (self->preview_duration != 0 &&
+          (!GST_CLOCK_TIME_IS_VALID (data->end_time) || data->end_time > self->preview_duration))
+        data->end_time = self->preview_duration;
+
+      g_autofree char *output_basename = g_strdup_printf ("%s.%s", auricle_music_file_get_result_name (data->file),
+                                                          rendition->muxer->extension);
       g_autofree char *output_path = g_build_filename (output_directory, output_basename, NULL);
 
-      GstElement *audio_src = gst_element_factory_make ("filesrc", NULL);
-      g_object_set (audio_src, "location", auricle_music_file_get_path (data->file), NULL);
+      g_autoptr(GError) error = NULL;
+      AuricleCodecSettings audio_settings = {
+        .bitrate = auricle_renderer_get_audio_bitrate (self, data),
+        .max_sample_rate = auricle_render_options_get_audio_max_sample_rate (self->render_options),
+        .max_channels = auricle_render_options_get_audio_max_channels (self->render_options),
+        .resample_quality = auricle_render_options_get_resample_quality (self->render_options),
+        .gain_db = auricle_renderer_get_audio_gain (self, data),
+      };
 
-      GstElement *audio_dec = gst_element_factory_make ("decodebin3", NULL);
+      if (self->manifest != NULL)
+        {
+          data->inputs = auricle_renderer_stat_inputs (data);
+          if (data->image_key != NULL)
+            data->image_hash = g_compute_checksum_for_string (G_CHECKSUM_SHA256, data->image_key, -1);
+          data->settings_hash = auricle_renderer_hash_settings (self, data, &audio_settings);
+
+          if (auricle_renderer_is_up_to_date (self, data, output_basename, output_path))
+            {
+              g_info ("Skipping %s, which is up to date", output_basename);
+              data->skipped = TRUE;
+              data->is_eos = TRUE;
+              n_skipped++;
+              continue;
+            }
+        }
 
-      GstElement *audio_enc = gst_element_factory_make ("fdkaacenc", NULL);
-      g_object_set (audio_enc, "bitrate", audio_bitrate * 1000, NULL);
+      const char *scope = scope_for_render_mode (render_mode);
 
-      GstElement *mux  = gst_element_factory_make ("mp4mux", NULL);
+      // The visualizers and loudness gain need decoded audio, but otherwise anything the muxer already
+      // takes is copied over instead of being decoded and encoded again. The encoder is then only linked
+      // in if the decoder does output raw audio.
+      g_autoptr(GstCaps) passthrough_caps = NULL;
+      if (scope == NULL && audio_settings.gain_db == 0 && !shared && data->tracks == NULL &&
+          auricle_render_options_get_audio_passthrough (self->render_options))
+        passthrough_caps = auricle_codecs_get_passthrough_caps (rendition->muxer, audio_settings.max_sample_rate,
+                                                                audio_settings.max_channels);
 
-      GstElement *sink = gst_element_factory_make ("filesink", NULL);
-      g_object_set (sink, "location", output_path,
-                          "sync", FALSE, NULL);
+      guint n_chunks = auricle_renderer_get_chunk_count (self, data, scope, passthrough_caps);
 
-      gst_bin_add_many (GST_BIN (self->pipeline),
-                        image_src, image_conv, image_freeze, image_enc,
-                        audio_src, audio_dec, audio_enc,
-                        mux, sink, NULL);
+      // Chunked jobs encode each range inside their own source, so only the others need an encoder here.
+      GstElement *audio_enc = NULL;
+      if (n_chunks <= 1)
+        {
+          audio_enc = auricle_codec_create_encoder (rendition->audio_codec, &audio_settings, &error);
+          if (audio_enc == NULL)
+            {
+              auricle_show_notification ("Cannot render %s: %s", auricle_music_file_get_result_name (data->file),
+                                         error->message);
+              continue;
+            }
+        }
 
-      gst_element_link_many (image_src, image_conv, image_freeze, image_enc, NULL);
-      gst_element_link (audio_src, audio_dec);
-      gst_element_link (mux, sink);
+      // A stream can't be seeked back into to fill in the index, so it's always fragmented.
+      gboolean streamed = auricle_renderer_get_output_command (self) != NULL;
+      AuricleCodecSettings mux_settings = {
+        .fragment_duration = streamed || auricle_render_options_get_fragmented_output (self->render_options)
+                             ? FRAGMENT_DURATION : 0,
+        .streamable = streamed,
+      };
+
+      // A fragmented file already starts with its index. Otherwise the room for it is reserved up front
+      // from the known length, with some to spare, since running out of it fails the render.
+      GstClockTime output_duration = auricle_renderer_get_output_duration (data);
+      if (auricle_render_options_get_faststart (self->render_options) && mux_settings.fragment_duration == 0 &&
+          GST_CLOCK_TIME_IS_VALID (output_duration))
+        mux_settings.reserved_duration = output_duration + output_duration / 10 + RESERVED_DURATION_MARGIN;
+      GstElement *mux = auricle_codec_create_muxer (rendition->muxer, &mux_settings, &error);
+      if (mux == NULL)
+        {
+          if (audio_enc != NULL)
+            gst_object_unref (gst_object_ref_sink (audio_enc));
+          auricle_show_notification ("Cannot render %s: %s", auricle_music_file_get_result_name (data->file),
+                                     error->message);
+          continue;
+        }
 
-      GstPad *mux_audio_pad = gst_element_get_request_pad (mux, "audio_%u");
-      GstPad *mux_video_pad = gst_element_get_request_pad (mux, "video_%u");
+      // Streamed outputs never land in the output directory, so there's nothing to list them under.
+      gboolean checksum = self->preview_duration == 0 && !streamed &&
+                          auricle_render_options_get_write_checksums (self->render_options);
+      GstElement *sink = NULL;
+      if (streamed)
+        {
+          int fd = auricle_renderer_spawn_output_command (self, data, output_basename, &error);
+          if (fd != -1)
+            sink = auricle_file_sink_new_for_fd (fd, output_basename, checksum);
+        }
+      else
+        {
+          sink = auricle_file_sink_new (output_path,
+                                        auricle_renderer_estimate_output_size (data, &audio_settings),
+                                        checksum);
+          // Fragmented files stay playable up to the last fragment written, so they're kept if
+          // the render is cut short.
+          auricle_file_sink_set_keep_partial (AURICLE_FILE_SINK (sink), mux_settings.fragment_duration != 0);
+        }
+
+      if (sink == NULL)
+        {
+          if (audio_enc != NULL)
+            gst_object_unref (gst_object_ref_sink (audio_enc));
+          gst_object_unref (gst_object_ref_sink (mux));
+          auricle_show_notification ("Cannot render %s: %s", auricle_music_file_get_result_name (data->file),
+                                     error->message);
+          continue;
+        }
+
+      g_object_set (sink, "sync", FALSE, NULL);
+
+      GstElement *audio_src = NULL;
+      GstElement *audio_dec = NULL;
+      GstElement *audio_queue = gst_element_factory_make ("queue", NULL);
+
+      if (n_chunks > 1)
+        {
+          g_info ("Encoding %s in %u parallel ranges", auricle_music_file_get_result_name (data->file), n_chunks);
+          audio_src = auricle_chunked_audio_new (auricle_music_file_get_path (data->file), rendition->audio_codec,
+                                                 &audio_settings, auricle_music_file_get_duration (data->file),
+                                                 n_chunks);
+
+          gst_bin_add_many (GST_BIN (self->pipeline), audio_src, audio_queue, NULL);
+          gst_element_link (audio_src, audio_queue);
+        }
+      else if (shared)
+        {
+          // Each job sharing the decoded audio encodes its own copy, cutting its track out first if
+          // it only covers part of the source.
+          GstElement *source_tee = auricle_renderer_get_shared_source (self, shared_sources, data);
+          audio_src = gst_element_factory_make ("queue", NULL);
+
+          gst_bin_add_many (GST_BIN (self->pipeline), audio_src, audio_enc, audio_queue, NULL);
+          gst_element_link (audio_enc, audio_queue);
+
+          data->shared_pad = gst_element_get_request_pad (source_tee, "src_%u");
+          g_autoptr(GstPad) shared_queue_pad = gst_element_get_static_pad (audio_src, "sink");
+          gst_pad_link (data->shared_pad, shared_queue_pad);
+          if (ranged)
+            gst_pad_add_probe (data->shared_pad, GST_PAD_PROBE_TYPE_BUFFER, on_range_buffer, data, NULL);
+
+          // Later tracks only get their audio once the decoder reaches them, and a sink waiting on
+          // another branch of the tee would stall it, so these can't hold up the pipeline's preroll.
+          g_object_set (sink, "async", FALSE, NULL);
+        }
+      else if (data->tracks != NULL)
+        {
+          // Switching between tracks needs decoded audio, so albums are always encoded.
+          audio_src = auricle_renderer_create_album_source (self, data);
 
-      g_autoptr(GstPad) audio_enc_pad = gst_element_get_static_pad (audio_enc, "src");
-      g_autoptr(GstPad) image_enc_pad = gst_element_get_static_pad (image_enc, "src");
+          gst_bin_add_many (GST_BIN (self->pipeline), audio_enc, audio_queue, NULL);
+          gst_element_link (audio_enc, audio_queue);
+        }
+      else
+        {
+          audio_src = auricle_file_source_new (auricle_music_file_get_path (data->file));
+          audio_dec = gst_element_factory_make ("decodebin3", NULL);
+
+          if (passthrough_caps != NULL)
+            {
+              g_object_set (audio_dec, "caps", passthrough_caps, NULL);
+              data->audio_enc = gst_object_ref_sink (audio_enc);
+            }
+          else
+            {
+              gst_bin_add (GST_BIN (self->pipeline), audio_enc);
+              gst_element_link (audio_enc, audio_queue);
+            }
+
+          gst_bin_add_many (GST_BIN (self->pipeline), audio_src, audio_dec, audio_queue, NULL);
+          gst_element_link (audio_src, audio_dec);
+        }
 
-      gst_pad_link (audio_enc_pad, mux_audio_pad);
-      gst_pad_link (image_enc_pad, mux_video_pad);
+      gst_bin_add_many (GST_BIN (self->pipeline), mux, sink, NULL);
+      gst_element_link (mux, sink);
+
+      if (data->tracks != NULL)
+        auricle_renderer_add_album_chapters (data, mux);
+
+      GstPad *mux_audio_pad = gst_element_get_request_pad (mux, "audio_%u");
+      GstPad *mux_video_pad = !audio_only ? gst_element_get_request_pad (mux, "video_%u") : NULL;
 
-      g_signal_connect (audio_dec, "pad-added", G_CALLBACK (on_dec_pad_added), audio_enc);
+      g_autoptr(GstPad) audio_queue_pad = gst_element_get_static_pad (audio_queue, "src");
+      gst_pad_link (audio_queue_pad, mux_audio_pad);
 
-      data->src = g_object_ref (audio_dec);
+      data->src = g_object_ref (audio_dec != NULL ? audio_dec : audio_src);
       data->sink = g_object_ref (sink);
-      data->request_pads = g_list_prepend (data->request_pads, mux_video_pad);
+      data->audio_queue = g_object_ref (audio_queue);
+      if (mux_video_pad != NULL)
+        data->request_pads = g_list_prepend (data->request_pads, mux_video_pad);
       data->request_pads = g_list_prepend (data->request_pads, mux_audio_pad);
+      data->output_path = g_strdup (output_path);
+      data->streamed = streamed;
+      data->start_time = g_get_monotonic_time ();
+      data->duration = GST_CLOCK_TIME_NONE;
+
+      GstElement *visualizer = NULL;
+
+      if (scope != NULL)
+        {
+          GdkPixbuf *background = auricle_image_cache_get_pixbuf (data->image_cache, data->image_key);
+          visualizer = auricle_visualizer_new (background, scope, rendition->video_codec, rendition->video_preset,
+                                               &error);
+          if (visualizer == NULL)
+            {
+              g_warning ("Failed to create the visualizer: %s", error->message);
+              auricle_show_notification ("Failed to create the visualizer, using the still image: %s",
+                                         error->message);
+            }
+        }
+
+      if (visualizer != NULL)
+        {
+          // The decoded audio feeds both the encoder and the visualizer. The video branch lags behind
+          // by the encoder's lookahead, so the audio side must not block the tee while it waits to
+          // be muxed.
+          GstElement *tee = gst_element_factory_make ("tee", NULL);
+          GstElement *tee_queue = gst_element_factory_make ("queue", NULL);
+          g_object_set (tee_queue, "max-size-buffers", 0,
+                                   "max-size-bytes", 0,
+                                   "max-size-time", (guint64) 0, NULL);
+
+          gst_bin_add_many (GST_BIN (self->pipeline), tee, tee_queue, visualizer, NULL);
+          gst_element_link_many (tee, tee_queue, audio_enc, NULL);
+          gst_element_link (tee, visualizer);
+
+          g_autoptr(GstPad) visualizer_pad = gst_element_get_static_pad (visualizer, "src");
+          gst_pad_link (visualizer_pad, mux_video_pad);
+
+          if (audio_dec != NULL)
+            g_signal_connect (audio_dec, "pad-added", G_CALLBACK (on_dec_pad_added), tee);
+          else
+            gst_element_link (audio_src, tee);
+        }
+      else
+        {
+          if (!audio_only)
+            {
+              GstElement *video_src = auricle_renderer_create_video_source (self, data);
+              gst_bin_add (GST_BIN (self->pipeline), video_src);
+
+              g_autoptr(GstPad) video_src_pad = gst_element_get_static_pad (video_src, "src");
+              gst_pad_link (video_src_pad, mux_video_pad);
+
+              // The repeated segment never ends by itself, so it's cut off once the audio is done.
+              add_downstream_event_probe (audio_queue_pad, on_downstream_audio_pad_event, data);
+            }
+
+          if (data->audio_enc != NULL)
+            g_signal_connect (audio_dec, "pad-added", G_CALLBACK (on_passthrough_dec_pad_added), data);
+          else if (audio_dec != NULL)
+            g_signal_connect (audio_dec, "pad-added", G_CALLBACK (on_dec_pad_added), audio_enc);
+          else if (shared || data->tracks != NULL)
+            gst_element_link (audio_src, audio_enc);
+        }
+
+      // Ranged jobs are already cut off at their end time.
+      if (GST_CLOCK_TIME_IS_VALID (data->end_time) && audio_dec != NULL)
+        g_signal_connect (audio_dec, "pad-added", G_CALLBACK (on_preview_dec_pad_added), data);
 
-      add_downstream_event_probe (audio_enc_pad, on_downstream_audio_pad_event, data);
       g_autoptr(GstPad) sink_pad = gst_element_get_static_pad (sink, "sink");
       add_downstream_event_probe (sink_pad, on_downstream_sink_pad_event, data);
+      n_rendering++;
+    }
+
+  if (n_skipped > 0)
+    auricle_show_notification ("Skipped %u up to date %s", n_skipped, n_skipped == 1 ? "output" : "outputs");
+
+  // An empty pipeline would never reach EOS.
+  if (n_rendering == 0)
+    {
+      g_source_remove (self->bus_watch_id);
+      self->bus_watch_id = 0;
+      g_signal_emit (self, signals[COMPLETE], 0);
+      return;
     }
 
   self->progress_timer_id = g_timeout_add (100, on_progress_timer, self);
@@ -22,6 +22,7 @@
 
 #include <glib-object.h>
 #include <gdk-pixbuf/gdk-pixbuf.h>
+#include <gst/gst.h>
 #include "auricle-music-file.h"
 #include "auricle-render-options.h"
 
@@ -40,6 +41,9 @@ AuricleMusicFile *auricle_renderer_get_file (AuricleRenderer *self,
 void auricle_renderer_take_file (AuricleRenderer  *self,
                                  AuricleMusicFile *file);
 
+void auricle_renderer_set_preview (AuricleRenderer *self,
+                                   GstClockTime     duration);
+
 void auricle_renderer_run (AuricleRenderer *self);
 
 typedef struct AuricleRenderProgress AuricleRenderProgress;
@@ -19,7 +19,19 @@
  */
 
 #include "auricle-utils.h"
+#include "auricle-archive.h"
 #include "auricle-window.h"
+#include <fcntl.h>
+#include <glib/gstdio.h>
+#include <string.h>
+
+// Inputs are read in large blocks, with the kernel asked to read ahead this far of the current
+// position.
+#define INPUT_BLOCK_SIZE (1024 * 1024)
+#define INPUT_READAHEAD_WINDOW (8 * 1024 * 1024)
+// At most this many prefetches wait at once, which bounds how much of the page cache they can take up
+// ahead of time. It's enough for a hint from each input of a full batch to be in flight.
+#define PREFETCH_MAX_QUEUED 16
 
 void
 auricle_show_notification_internal (char *message)
@@ -103,3 +115,209 @@ auricle_substitute (const char *template,
   return g_string_free (g_steal_pointer (&result), FALSE);
 }
 
+/* Returns a new reference to the pixbuf, scaled up by a pixel on the odd sides if needed, since
+   h264 requires even dimensions. */
+GdkPixbuf *
+auricle_pixbuf_make_even (GdkPixbuf *pixbuf)
+{
+  int width = gdk_pixbuf_get_width (pixbuf);
+  int height = gdk_pixbuf_get_height (pixbuf);
+
+  if (width % 2 == 0 && height % 2 == 0)
+    return g_object_ref (pixbuf);
+
+  return gdk_pixbuf_scale_simple (pixbuf, width + width % 2, height + height % 2, GDK_INTERP_BILINEAR);
+}
+
+/* Returns a new opaque pixbuf of the given size, with the image scaled to fit inside of it and
+   centered over a black background. */
+GdkPixbuf *
+auricle_pixbuf_fit (GdkPixbuf *pixbuf,
+                    int        width,
+                    int        height)
+{
+  int image_width = gdk_pixbuf_get_width (pixbuf);
+  int image_height = gdk_pixbuf_get_height (pixbuf);
+
+  GdkPixbuf *result = gdk_pixbuf_new (GDK_COLORSPACE_RGB, FALSE, 8, width, height);
+  gdk_pixbuf_fill (result, 0x000000ff);
+
+  double scale = MIN ((double) width / image_width, (double) height / image_height);
+  int scaled_width = MAX (image_width * scale, 1);
+  int scaled_height = MAX (image_height * scale, 1);
+  int x = (width - scaled_width) / 2;
+  int y = (height - scaled_height) / 2;
+
+  gdk_pixbuf_composite (pixbuf, result, x, y, scaled_width, scaled_height, x, y, scale, scale,
+                        GDK_INTERP_BILINEAR, 255);
+  return result;
+}
+
+
+/* Describes the pixbuf's pixels as raw RGB(A) video. */
+void
+auricle_video_info_init_from_pixbuf (GstVideoInfo *info,
+                                     GdkPixbuf    *pixbuf)
+{
+  gst_video_info_init (info);
+  gst_video_info_set_format (info,
+                             gdk_pixbuf_get_has_alpha (pixbuf) ? GST_VIDEO_FORMAT_RGBA : GST_VIDEO_FORMAT_RGB,
+                             gdk_pixbuf_get_width (pixbuf), gdk_pixbuf_get_height (pixbuf));
+}
+
+GstBuffer *
+auricle_buffer_new_from_pixbuf (GdkPixbuf    *pixbuf,
+                                GstVideoInfo *info)
+{
+  // The pixbuf's last row isn't padded, so the rows need to be copied over one by one.
+  GstBuffer *buffer = gst_buffer_new_allocate (NULL, GST_VIDEO_INFO_SIZE (info), NULL);
+
+  GstMapInfo map;
+  gst_buffer_map (buffer, &map, GST_MAP_WRITE);
+
+  const guint8 *pixels = gdk_pixbuf_read_pixels (pixbuf);
+  int rowstride = gdk_pixbuf_get_rowstride (pixbuf);
+  int row_length = gdk_pixbuf_get_width (pixbuf) * gdk_pixbuf_get_n_channels (pixbuf);
+  int stride = GST_VIDEO_INFO_PLANE_STRIDE (info, 0);
+
+  for (int y = 0; y < gdk_pixbuf_get_height (pixbuf); y++)
+    memcpy (map.data + y * stride, pixels + y * rowstride, row_length);
+
+  gst_buffer_unmap (buffer, &map);
+  return buffer;
+}
+
+typedef struct _AuricleReadahead AuricleReadahead;
+
+struct _AuricleReadahead
+{
+  char    *path;
+  guint64  advised_end;
+};
+
+static void
+auricle_readahead_free (AuricleReadahead *readahead)
+{
+  g_free (readahead->path);
+  g_free (readahead);
+}
+
+static GstPadProbeReturn
+on_file_source_buffer (GstPad          *pad,
+                       GstPadProbeInfo *info,
+                       gpointer         udata)
+{
+  AuricleReadahead *readahead = udata;
+  GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+  guint64 offset = GST_BUFFER_OFFSET (buffer);
+  if (offset == GST_BUFFER_OFFSET_NONE)
+    return GST_PAD_PROBE_OK;
+
+  // Start over from wherever a seek landed, e.g. when the index is at the end of the file.
+  if (offset > readahead->advised_end || offset + 2 * INPUT_READAHEAD_WINDOW < readahead->advised_end)
+    readahead->advised_end = offset;
+
+  // Opening the file for the hint can take a round trip on a network share, so it's left to the
+  // prefetch thread rather than stalling the read here. A dropped hint is retried on the next buffer.
+  if (offset + INPUT_READAHEAD_WINDOW / 2 >= readahead->advised_end &&
+      auricle_prefetch_file (readahead->path, readahead->advised_end, INPUT_READAHEAD_WINDOW))
+    readahead->advised_end += INPUT_READAHEAD_WINDOW;
+
+  return GST_PAD_PROBE_OK;
+}
+
+/* Creates a filesrc for an input that's read from start to end. With many of them running at once,
+   the small default reads from each turn into random I/O on slow disks and network shares, so the
+   reads are made larger and the kernel is told to read ahead of them. filesrc keeps its descriptor
+   to itself, but the page cache is shared, so the hints go through auricle_prefetch_file.
+   Members of archives are read through a stream that decompresses them as they go. */
+GstElement *
+auricle_file_source_new (const char *path)
+{
+  g_autofree char *archive_path = NULL;
+  g_autofree char *member = NULL;
+  if (auricle_archive_split_path (path, &archive_path, &member))
+    {
+      g_autoptr(GError) error = NULL;
+      g_autoptr(GInputStream) stream = auricle_archive_open_member (archive_path, member, &error);
+      if (stream != NULL)
+        {
+          GstElement *src = gst_element_factory_make ("giostreamsrc", NULL);
+          g_object_set (src, "stream", stream,
+                             "blocksize", INPUT_BLOCK_SIZE, NULL);
+          return src;
+        }
+
+      // The filesrc below then fails to open it, which is reported like any other missing file.
+      g_warning ("Failed to open %s: %s", path, error->message);
+    }
+
+  GstElement *src = gst_element_factory_make ("filesrc", NULL);
+  g_object_set (src, "location", path,
+                     "blocksize", INPUT_BLOCK_SIZE, NULL);
+
+  AuricleReadahead *readahead = g_new0 (AuricleReadahead, 1);
+  readahead->path = g_strdup (path);
+
+  g_autoptr(GstPad) pad = gst_element_get_static_pad (src, "src");
+  gst_pad_add_probe (pad, GST_PAD_PROBE_TYPE_BUFFER, on_file_source_buffer, readahead,
+                     (GDestroyNotify) auricle_readahead_free);
+  return src;
+}
+
+typedef struct _AuriclePrefetch AuriclePrefetch;
+
+struct _AuriclePrefetch
+{
+  char    *path;
+  guint64  offset;
+  guint64  length;
+};
+
+static void
+run_prefetch (gpointer prefetch_ptr,
+              gpointer udata)
+{
+  AuriclePrefetch *prefetch = prefetch_ptr;
+
+  // The descriptor is only held for the hint, since keeping one per input open alongside filesrc's
+  // would run out of them with a few hundred tracks.
+  int fd = g_open (prefetch->path, O_RDONLY | O_CLOEXEC, 0);
+  if (fd != -1)
+    {
+      g_debug ("Prefetching %s from %" G_GUINT64_FORMAT, prefetch->path, prefetch->offset);
+      posix_fadvise (fd, prefetch->offset, prefetch->length, POSIX_FADV_WILLNEED);
+      g_close (fd, NULL);
+    }
+
+  g_free (prefetch->path);
+  g_free (prefetch);
+}
+
+/* Starts reading the given part of an input into the page cache in the background, so whatever
+   reads it next doesn't stall on a slow disk or network share. This is only a hint, and is dropped
+   if too many are already waiting, in which case FALSE is returned. */
+gboolean
+auricle_prefetch_file (const char *path,
+                       guint64     offset,
+                       guint64     length)
+{
+  static GThreadPool *pool = NULL;
+
+  if (g_once_init_enter (&pool))
+    {
+      // Asking for readahead may block until the reads are queued, which one thread is enough for.
+      GThreadPool *new_pool = g_thread_pool_new (run_prefetch, NULL, 1, FALSE, NULL);
+      g_once_init_leave (&pool, new_pool);
+    }
+
+  if (g_thread_pool_unprocessed (pool) >= PREFETCH_MAX_QUEUED)
+    return FALSE;
+
+  AuriclePrefetch *prefetch = g_new (AuriclePrefetch, 1);
+  prefetch->path = g_strdup (path);
+  prefetch->offset = offset;
+  prefetch->length = length;
+  g_thread_pool_push (pool, prefetch, NULL);
+  return TRUE;
+}
@@ -21,6 +21,8 @@
 #pragma once
 
 #include <glib.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include <gst/video/video.h>
 
 G_BEGIN_DECLS
 
@@ -31,5 +33,20 @@ void auricle_show_notification_internal (char *allocated_message);
 char * auricle_substitute (const char *template,
                            GHashTable *vars);
 
+GdkPixbuf * auricle_pixbuf_make_even (GdkPixbuf *pixbuf);
+GdkPixbuf * auricle_pixbuf_fit       (GdkPixbuf *pixbuf,
+                                      int        width,
+                                      int        height);
+
+void        auricle_video_info_init_from_pixbuf (GstVideoInfo *info,
+                                                 GdkPixbuf    *pixbuf);
+GstBuffer * auricle_buffer_new_from_pixbuf      (GdkPixbuf    *pixbuf,
+                                                 GstVideoInfo *info);
+
+GstElement * auricle_file_source_new (const char *path);
+gboolean     auricle_prefetch_file   (const char *path,
+                                      guint64     offset,
+                                      guint64     length);
+
 G_END_DECLS
 
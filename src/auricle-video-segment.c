@@ -0,0 +1,220 @@
+/* auricle-video-segment.c
+ *
+ * Copyright 2019 Ryan Gonzalez <rymg19@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "auricle-video-segment.h"
+#include "auricle-utils.h"
+#include <gst/app/app.h>
+#include <gst/video/video.h>
+
+/* A still image only needs to be encoded once: a single GOP of it can be repeated back-to-back
+   for as long as the audio lasts, without running a video encoder for every render job. The same
+   goes for a slideshow, where each image gets its own GOP and the whole cycle is repeated. */
+
+#define SEGMENT_FRAMERATE 25
+
+struct _AuricleVideoSegment
+{
+  GObject parent_instance;
+
+  GstCaps      *caps;
+  GPtrArray    *buffers;
+  GstClockTime  duration;
+};
+
+G_DEFINE_TYPE (AuricleVideoSegment, auricle_video_segment, G_TYPE_OBJECT)
+
+static void
+auricle_video_segment_finalize (GObject *object)
+{
+  AuricleVideoSegment *self = (AuricleVideoSegment *)object;
+
+  g_clear_pointer (&self->caps, gst_caps_unref);
+  g_clear_pointer (&self->buffers, g_ptr_array_unref);
+
+  G_OBJECT_CLASS (auricle_video_segment_parent_class)->finalize (object);
+}
+
+static void
+auricle_video_segment_class_init (AuricleVideoSegmentClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = auricle_video_segment_finalize;
+}
+
+static void
+auricle_video_segment_init (AuricleVideoSegment *self)
+{
+  self->buffers = g_ptr_array_new_with_free_func ((GDestroyNotify) gst_buffer_unref);
+}
+
+static gboolean
+pull_encoded_buffers (AuricleVideoSegment  *self,
+                      GstElement           *pipeline,
+                      GstAppSink           *sink,
+                      GError              **error)
+{
+  g_autoptr(GstBus) bus = gst_element_get_bus (pipeline);
+
+  for (;;)
+    {
+      g_autoptr(GstSample) sample = gst_app_sink_try_pull_sample (sink, 100 * GST_MSECOND);
+      if (sample != NULL)
+        {
+          if (self->caps == NULL)
+            self->caps = gst_caps_ref (gst_sample_get_caps (sample));
+
+          g_ptr_array_add (self->buffers, gst_buffer_ref (gst_sample_get_buffer (sample)));
+          continue;
+        }
+
+      if (gst_app_sink_is_eos (sink))
+        return TRUE;
+
+      g_autoptr(GstMessage) message = gst_bus_pop_filtered (bus, GST_MESSAGE_ERROR);
+      if (message != NULL)
+        {
+          gst_message_parse_error (message, error, NULL);
+          return FALSE;
+        }
+    }
+}
+
+/* Encodes one GOP per image with the given video codec, each lasting for the dwell time. All the images must have the same
+   size and format. This blocks until the encode is done, so it should be called from a streaming
+   thread rather than the main loop. */
+AuricleVideoSegment *
+auricle_video_segment_encode (const AuricleCodec  *codec,
+                              const char          *preset,
+                              GPtrArray           *pixbufs,
+                              GstClockTime         dwell,
+                              GError             **error)
+{
+  g_return_val_if_fail (pixbufs->len > 0, NULL);
+
+  GdkPixbuf *first = g_ptr_array_index (pixbufs, 0);
+  g_return_val_if_fail (gdk_pixbuf_get_colorspace (first) == GDK_COLORSPACE_RGB, NULL);
+
+  GstClockTime frame_duration = gst_util_uint64_scale_int (GST_SECOND, 1, SEGMENT_FRAMERATE);
+  guint frames_per_image = MAX (dwell / frame_duration, 1);
+
+  // The keyframe interval lines up with the image changes, so every image starts with its own
+  // keyframe.
+  AuricleCodecSettings settings = { .keyframe_interval = frames_per_image, .still_image = TRUE, .preset = preset };
+  GstElement *enc = auricle_codec_create_encoder (codec, &settings, error);
+  if (enc == NULL)
+    return NULL;
+
+  g_autoptr(GstElement) pipeline = gst_pipeline_new ("segment-pipeline");
+
+  GstElement *src = gst_element_factory_make ("appsrc", NULL);
+  GstElement *conv = gst_element_factory_make ("videoconvert", NULL);
+  GstElement *sink = gst_element_factory_make ("appsink", NULL);
+
+  g_object_set (sink, "sync", FALSE, NULL);
+
+  GstVideoInfo info;
+  auricle_video_info_init_from_pixbuf (&info, first);
+  info.fps_n = SEGMENT_FRAMERATE;
+  info.fps_d = 1;
+
+  g_autoptr(GstCaps) raw_caps = gst_video_info_to_caps (&info);
+  gst_app_src_set_caps (GST_APP_SRC (src), raw_caps);
+  g_object_set (src, "format", GST_FORMAT_TIME, NULL);
+
+  gst_bin_add_many (GST_BIN (pipeline), src, conv, enc, sink, NULL);
+  gst_element_link_many (src, conv, enc, sink, NULL);
+
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+
+  guint frame = 0;
+  for (guint i = 0; i < pixbufs->len; i++)
+    {
+      g_autoptr(GstBuffer) image = auricle_buffer_new_from_pixbuf (g_ptr_array_index (pixbufs, i), &info);
+
+      for (guint j = 0; j < frames_per_image; j++, frame++)
+        {
+          // Shallow copies, so every frame of the image shares the same memory.
+          GstBuffer *copy = gst_buffer_copy (image);
+          GST_BUFFER_PTS (copy) = frame * frame_duration;
+          GST_BUFFER_DURATION (copy) = frame_duration;
+          gst_app_src_push_buffer (GST_APP_SRC (src), copy);
+        }
+    }
+
+  gst_app_src_end_of_stream (GST_APP_SRC (src));
+
+  g_autoptr(AuricleVideoSegment) self = g_object_new (AURICLE_TYPE_VIDEO_SEGMENT, NULL);
+  self->duration = frame * frame_duration;
+
+  gboolean success = pull_encoded_buffers (self, pipeline, GST_APP_SINK (sink), error);
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+
+  if (!success)
+    return NULL;
+
+  if (self->buffers->len == 0 || self->caps == NULL)
+    {
+      g_set_error (error, GST_STREAM_ERROR, GST_STREAM_ERROR_ENCODE, "Encoder produced no output");
+      return NULL;
+    }
+
+  return g_steal_pointer (&self);
+}
+
+GstCaps *
+auricle_video_segment_get_caps (AuricleVideoSegment *self)
+{
+  return self->caps;
+}
+
+GstClockTime
+auricle_video_segment_get_duration (AuricleVideoSegment *self)
+{
+  return self->duration;
+}
+
+guint
+auricle_video_segment_get_n_buffers (AuricleVideoSegment *self)
+{
+  return self->buffers->len;
+}
+
+/* Returns a new reference to the buffer at index, timestamped as if it came from the given
+   repetition of the segment. */
+GstBuffer *
+auricle_video_segment_get_buffer (AuricleVideoSegment *self,
+                                  guint                repeat,
+                                  guint                index)
+{
+  g_return_val_if_fail (index < self->buffers->len, NULL);
+
+  GstBuffer *original = g_ptr_array_index (self->buffers, index);
+  GstBuffer *buffer = gst_buffer_copy (original);
+  GstClockTime offset = repeat * self->duration;
+
+  if (GST_BUFFER_PTS_IS_VALID (original))
+    GST_BUFFER_PTS (buffer) = GST_BUFFER_PTS (original) + offset;
+  if (GST_BUFFER_DTS_IS_VALID (original))
+    GST_BUFFER_DTS (buffer) = GST_BUFFER_DTS (original) + offset;
+
+  return buffer;
+}
+
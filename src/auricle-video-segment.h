@@ -0,0 +1,52 @@
+/* auricle-video-segment.h
+ *
+ * Copyright 2019 Ryan Gonzalez <rymg19@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <glib-object.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include <gst/gst.h>
+#include "auricle-codecs.h"
+
+G_BEGIN_DECLS
+
+#define AURICLE_TYPE_VIDEO_SEGMENT (auricle_video_segment_get_type())
+
+G_DECLARE_FINAL_TYPE (AuricleVideoSegment, auricle_video_segment, AURICLE, VIDEO_SEGMENT, GObject)
+
+// Matches x264's default keyframe interval at the segment framerate.
+#define AURICLE_VIDEO_SEGMENT_DEFAULT_DWELL (10 * GST_SECOND)
+
+AuricleVideoSegment *auricle_video_segment_encode (const AuricleCodec  *codec,
+                                                   const char          *preset,
+                                                   GPtrArray           *pixbufs,
+                                                   GstClockTime         dwell,
+                                                   GError             **error);
+
+GstCaps      *auricle_video_segment_get_caps      (AuricleVideoSegment *self);
+GstClockTime  auricle_video_segment_get_duration  (AuricleVideoSegment *self);
+guint         auricle_video_segment_get_n_buffers (AuricleVideoSegment *self);
+
+GstBuffer *auricle_video_segment_get_buffer (AuricleVideoSegment *self,
+                                             guint                repeat,
+                                             guint                index);
+
+G_END_DECLS
+
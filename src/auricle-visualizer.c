@@ -0,0 +1,323 @@
+/* auricle-visualizer.c
+ *
+ * Copyright 2019 Ryan Gonzalez <rymg19@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "auricle-visualizer.h"
+#include "auricle-utils.h"
+#include <gst/app/app.h>
+#include <gst/video/video.h>
+#include <string.h>
+
+// The scope only needs to look smooth, not to match the usual video framerates, and every frame
+// costs an encode.
+#define VISUALIZER_FRAMERATE 10
+#define VISUALIZER_STRIP_SCALE 0.25
+
+typedef struct _AuricleVisualizerState AuricleVisualizerState;
+
+/* The scope only ever draws into a strip at the bottom of the frame, so the rest of the frame is
+   converted once and left alone. Output frames are recycled once the encoder is done with them, and
+   since they all start out as copies of the same background, only the strip needs to be redrawn. */
+struct _AuricleVisualizerState
+{
+  GstVideoInfo frame_info;
+  GstVideoInfo scope_info;
+  GstVideoInfo strip_info;
+  int          strip_y;
+
+  GstBuffer *background;
+  guint8    *background_strip;
+
+  GstVideoConverter *strip_converter;
+  GstBuffer         *blended_strip;
+  GstBuffer         *converted_strip;
+
+  GPtrArray *frames;
+  GstAppSrc *src;
+};
+
+static void
+auricle_visualizer_state_free (AuricleVisualizerState *state)
+{
+  g_clear_pointer (&state->background, gst_buffer_unref);
+  g_clear_pointer (&state->background_strip, g_free);
+  g_clear_pointer (&state->strip_converter, gst_video_converter_free);
+  g_clear_pointer (&state->blended_strip, gst_buffer_unref);
+  g_clear_pointer (&state->converted_strip, gst_buffer_unref);
+  g_clear_pointer (&state->frames, g_ptr_array_unref);
+  g_free (state);
+}
+
+static GstBuffer *
+convert_background (GdkPixbuf    *pixbuf,
+                    GstVideoInfo *frame_info)
+{
+  GstVideoInfo rgb_info;
+  auricle_video_info_init_from_pixbuf (&rgb_info, pixbuf);
+
+  g_autoptr(GstBuffer) rgb = auricle_buffer_new_from_pixbuf (pixbuf, &rgb_info);
+  GstBuffer *background = gst_buffer_new_allocate (NULL, GST_VIDEO_INFO_SIZE (frame_info), NULL);
+
+  GstVideoFrame rgb_frame, frame;
+  gst_video_frame_map (&rgb_frame, &rgb_info, rgb, GST_MAP_READ);
+  gst_video_frame_map (&frame, frame_info, background, GST_MAP_WRITE);
+
+  GstVideoConverter *converter = gst_video_converter_new (&rgb_info, frame_info, NULL);
+  gst_video_converter_frame (converter, &rgb_frame, &frame);
+  gst_video_converter_free (converter);
+
+  gst_video_frame_unmap (&frame);
+  gst_video_frame_unmap (&rgb_frame);
+  return background;
+}
+
+/* Copies the part of the pixbuf under the strip into the scope's BGRx layout, for blending. */
+static guint8 *
+copy_background_strip (GdkPixbuf *pixbuf,
+                       int        strip_y,
+                       int        strip_height)
+{
+  int width = gdk_pixbuf_get_width (pixbuf);
+  int n_channels = gdk_pixbuf_get_n_channels (pixbuf);
+  int rowstride = gdk_pixbuf_get_rowstride (pixbuf);
+  const guint8 *pixels = gdk_pixbuf_read_pixels (pixbuf);
+
+  guint8 *strip = g_malloc (width * 4 * strip_height);
+
+  for (int y = 0; y < strip_height; y++)
+    {
+      const guint8 *in = pixels + (strip_y + y) * rowstride;
+      guint8 *out = strip + y * width * 4;
+
+      for (int x = 0; x < width; x++, in += n_channels, out += 4)
+        {
+          out[0] = in[2];
+          out[1] = in[1];
+          out[2] = in[0];
+          out[3] = 0xff;
+        }
+    }
+
+  return strip;
+}
+
+static GstBuffer *
+auricle_visualizer_state_acquire_frame (AuricleVisualizerState *state)
+{
+  /* Once the encoder drops its reference, the frame is only held by the state and can be reused.
+     The encoder may have kept the memory alive in a buffer of its own though (e.g. as a reference
+     frame), so that has to be unshared too. */
+  for (guint i = 0; i < state->frames->len; i++)
+    {
+      GstBuffer *frame = g_ptr_array_index (state->frames, i);
+      if (GST_MINI_OBJECT_REFCOUNT_VALUE (frame) == 1 && gst_buffer_is_all_memory_writable (frame))
+        return frame;
+    }
+
+  GstBuffer *frame = gst_buffer_copy_deep (state->background);
+  g_ptr_array_add (state->frames, frame);
+  return frame;
+}
+
+static void
+blend_strip (AuricleVisualizerState *state,
+             GstVideoFrame          *scope,
+             GstVideoFrame          *blended)
+{
+  int row_length = GST_VIDEO_INFO_WIDTH (&state->scope_info) * 4;
+  int scope_stride = GST_VIDEO_FRAME_PLANE_STRIDE (scope, 0);
+  int blended_stride = GST_VIDEO_FRAME_PLANE_STRIDE (blended, 0);
+  const guint8 *scope_pixels = GST_VIDEO_FRAME_PLANE_DATA (scope, 0);
+  guint8 *blended_pixels = GST_VIDEO_FRAME_PLANE_DATA (blended, 0);
+
+  // A per-byte lighten blend keeps the image visible behind the scope's black background. It's a
+  // flat loop over bytes, so the compiler can vectorize it.
+  for (int y = 0; y < GST_VIDEO_INFO_HEIGHT (&state->scope_info); y++)
+    {
+      const guint8 *in = scope_pixels + y * scope_stride;
+      const guint8 *background = state->background_strip + y * row_length;
+      guint8 *out = blended_pixels + y * blended_stride;
+
+      for (int x = 0; x < row_length; x++)
+        out[x] = MAX (in[x], background[x]);
+    }
+}
+
+static void
+copy_strip_into_frame (AuricleVisualizerState *state,
+                       GstVideoFrame          *strip,
+                       GstVideoFrame          *frame)
+{
+  for (guint plane = 0; plane < GST_VIDEO_FRAME_N_PLANES (strip); plane++)
+    {
+      int strip_stride = GST_VIDEO_FRAME_PLANE_STRIDE (strip, plane);
+      int frame_stride = GST_VIDEO_FRAME_PLANE_STRIDE (frame, plane);
+      int row_length = GST_VIDEO_FRAME_COMP_WIDTH (strip, plane) * GST_VIDEO_FRAME_COMP_PSTRIDE (strip, plane);
+      int rows = GST_VIDEO_FRAME_COMP_HEIGHT (strip, plane);
+      int offset = GST_VIDEO_FORMAT_INFO_SCALE_HEIGHT (frame->info.finfo, plane, state->strip_y);
+
+      const guint8 *in = GST_VIDEO_FRAME_PLANE_DATA (strip, plane);
+      guint8 *out = (guint8 *) GST_VIDEO_FRAME_PLANE_DATA (frame, plane) + offset * frame_stride;
+
+      for (int y = 0; y < rows; y++)
+        memcpy (out + y * frame_stride, in + y * strip_stride, row_length);
+    }
+}
+
+static GstFlowReturn
+on_scope_new_sample (GstAppSink *sink,
+                     gpointer    udata)
+{
+  AuricleVisualizerState *state = udata;
+
+  g_autoptr(GstSample) sample = gst_app_sink_pull_sample (sink);
+  if (sample == NULL)
+    return GST_FLOW_EOS;
+
+  GstBuffer *scope_buffer = gst_sample_get_buffer (sample);
+  GstVideoFrame scope, blended, converted, frame;
+
+  if (!gst_video_frame_map (&scope, &state->scope_info, scope_buffer, GST_MAP_READ))
+    return GST_FLOW_ERROR;
+
+  gst_video_frame_map (&blended, &state->scope_info, state->blended_strip, GST_MAP_READWRITE);
+  blend_strip (state, &scope, &blended);
+  gst_video_frame_unmap (&scope);
+
+  gst_video_frame_map (&converted, &state->strip_info, state->converted_strip, GST_MAP_WRITE);
+  gst_video_converter_frame (state->strip_converter, &blended, &converted);
+  gst_video_frame_unmap (&blended);
+
+  GstBuffer *output = auricle_visualizer_state_acquire_frame (state);
+  gst_video_frame_map (&frame, &state->frame_info, output, GST_MAP_WRITE);
+  copy_strip_into_frame (state, &converted, &frame);
+  gst_video_frame_unmap (&frame);
+  gst_video_frame_unmap (&converted);
+
+  GST_BUFFER_PTS (output) = GST_BUFFER_PTS (scope_buffer);
+  GST_BUFFER_DURATION (output) = GST_BUFFER_DURATION (scope_buffer);
+
+  return gst_app_src_push_buffer (state->src, gst_buffer_ref (output));
+}
+
+static void
+on_scope_eos (GstAppSink *sink,
+              gpointer    udata)
+{
+  AuricleVisualizerState *state = udata;
+  gst_app_src_end_of_stream (state->src);
+}
+
+static AuricleVisualizerState *
+auricle_visualizer_state_new (GdkPixbuf *background)
+{
+  AuricleVisualizerState *state = g_new0 (AuricleVisualizerState, 1);
+
+  // The image cache already made the dimensions even, so the strip lines up with the chroma planes.
+  int width = gdk_pixbuf_get_width (background);
+  int height = gdk_pixbuf_get_height (background);
+  int strip_height = MAX ((int) (height * VISUALIZER_STRIP_SCALE) & ~1, 2);
+  state->strip_y = (height - strip_height) & ~1;
+
+  gst_video_info_set_format (&state->frame_info, GST_VIDEO_FORMAT_I420, width, height);
+  state->frame_info.fps_n = VISUALIZER_FRAMERATE;
+  state->frame_info.fps_d = 1;
+
+  gst_video_info_set_format (&state->scope_info, GST_VIDEO_FORMAT_BGRx, width, strip_height);
+  state->scope_info.fps_n = VISUALIZER_FRAMERATE;
+  state->scope_info.fps_d = 1;
+
+  gst_video_info_set_format (&state->strip_info, GST_VIDEO_FORMAT_I420, width, strip_height);
+
+  state->background = convert_background (background, &state->frame_info);
+  state->background_strip = copy_background_strip (background, state->strip_y, strip_height);
+
+  state->strip_converter = gst_video_converter_new (&state->scope_info, &state->strip_info, NULL);
+  state->blended_strip = gst_buffer_new_allocate (NULL, GST_VIDEO_INFO_SIZE (&state->scope_info), NULL);
+  state->converted_strip = gst_buffer_new_allocate (NULL, GST_VIDEO_INFO_SIZE (&state->strip_info), NULL);
+
+  state->frames = g_ptr_array_new_with_free_func ((GDestroyNotify) gst_buffer_unref);
+  return state;
+}
+
+/* Creates a bin that takes decoded audio and outputs video, encoded with the given codec and preset,
+   of the scope element (e.g. wavescope or spectrascope) drawn over the bottom of the background. */
+GstElement *
+auricle_visualizer_new (GdkPixbuf           *background,
+                        const char          *scope_name,
+                        const AuricleCodec  *codec,
+                        const char          *preset,
+                        GError             **error)
+{
+  GstElement *scope = gst_element_factory_make (scope_name, NULL);
+  if (scope == NULL)
+    {
+      g_set_error (error, GST_CORE_ERROR, GST_CORE_ERROR_MISSING_PLUGIN, "%s is not available", scope_name);
+      return NULL;
+    }
+
+  // Most of each frame is static, so the encoder's skipped blocks already keep the frames cheap.
+  AuricleCodecSettings settings = { .keyframe_interval = VISUALIZER_FRAMERATE * 10, .fast = TRUE,
+                                    .preset = preset };
+  GstElement *enc = auricle_codec_create_encoder (codec, &settings, error);
+  if (enc == NULL)
+    {
+      gst_object_unref (gst_object_ref_sink (scope));
+      return NULL;
+    }
+
+  AuricleVisualizerState *state = auricle_visualizer_state_new (background);
+
+  GstElement *bin = gst_bin_new (NULL);
+  g_object_set_data_full (G_OBJECT (bin), "auricle-visualizer-state", state,
+                          (GDestroyNotify) auricle_visualizer_state_free);
+
+  GstElement *queue = gst_element_factory_make ("queue", NULL);
+  GstElement *audio_conv = gst_element_factory_make ("audioconvert", NULL);
+  GstElement *video_conv = gst_element_factory_make ("videoconvert", NULL);
+  GstElement *sink = gst_element_factory_make ("appsink", NULL);
+  GstElement *src = gst_element_factory_make ("appsrc", NULL);
+
+  // Fading the previous frames would redraw the whole strip for nothing.
+  gst_util_set_object_arg (G_OBJECT (scope), "shader", "none");
+
+  g_autoptr(GstCaps) scope_caps = gst_video_info_to_caps (&state->scope_info);
+  g_object_set (sink, "caps", scope_caps,
+                      "sync", FALSE, NULL);
+
+  GstAppSinkCallbacks callbacks = { .eos = on_scope_eos, .new_sample = on_scope_new_sample };
+  gst_app_sink_set_callbacks (GST_APP_SINK (sink), &callbacks, state, NULL);
+
+  g_autoptr(GstCaps) frame_caps = gst_video_info_to_caps (&state->frame_info);
+  gst_app_src_set_caps (GST_APP_SRC (src), frame_caps);
+  g_object_set (src, "format", GST_FORMAT_TIME,
+                     "block", TRUE, NULL);
+  state->src = GST_APP_SRC (src);
+
+  gst_bin_add_many (GST_BIN (bin), queue, audio_conv, scope, video_conv, sink, src, enc, NULL);
+  gst_element_link_many (queue, audio_conv, scope, video_conv, sink, NULL);
+  gst_element_link (src, enc);
+
+  g_autoptr(GstPad) queue_pad = gst_element_get_static_pad (queue, "sink");
+  g_autoptr(GstPad) enc_pad = gst_element_get_static_pad (enc, "src");
+  gst_element_add_pad (bin, gst_ghost_pad_new ("sink", queue_pad));
+  gst_element_add_pad (bin, gst_ghost_pad_new ("src", enc_pad));
+
+  return bin;
+}
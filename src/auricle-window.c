@@ -18,6 +18,7 @@
 
 #include "auricle-config.h"
 #include "auricle-window.h"
+#include "auricle-calibration.h"
 #include "auricle-image-section.h"
 #include "auricle-music-file.h"
 #include "auricle-music-table.h"
@@ -26,6 +27,9 @@
 #include "auricle-progress-view.h"
 #include "auricle-renderer.h"
 
+// Long enough to hear the audio and see the video move, short enough to be quick.
+#define PREVIEW_DURATION (10 * GST_SECOND)
+
 struct _AuricleWindow
 {
   GtkApplicationWindow  parent_instance;
@@ -46,6 +50,11 @@ struct _AuricleWindow
 
   AuricleRenderer      *renderer;
   AuricleRenderOptions *render_options;
+
+  // The video options when calibration started, so its results don't overwrite the user's own pick.
+  gboolean              calibrating;
+  char                 *calibration_video_encoder;
+  char                 *calibration_video_preset;
 };
 
 G_DEFINE_TYPE (AuricleWindow, auricle_window, GTK_TYPE_APPLICATION_WINDOW)
@@ -66,7 +75,6 @@ auricle_window_show_notification (AuricleWindow *window,
                                   const char    *message)
 {
   auricle_notification_show (window->notification, message);
-  auricle_window_goto (window, "main");
 }
 
 static void
@@ -87,18 +95,33 @@ auricle_window_class_init (AuricleWindowClass *klass)
 static void
 auricle_window_update_render_button_1_state (AuricleWindow *self)
 {
-  gboolean enabled = auricle_image_section_get_pixbuf (self->image_section) != NULL &&
-                    !auricle_music_table_is_empty (self->music_table);
+  // Audio-only renders don't need an image.
+  gboolean has_image = auricle_image_section_get_pixbuf (self->image_section) != NULL ||
+                       auricle_render_options_get_render_mode (self->render_options) == AURICLE_RENDER_MODE_AUDIO_ONLY;
+  // Calibration would compete with the render for the CPU and skew its own results.
+  gboolean enabled = has_image && !auricle_music_table_is_empty (self->music_table) && !self->calibrating;
   gtk_widget_set_sensitive (GTK_WIDGET (self->render_button_1), enabled);
+
+  // Previews render right away, so they need the same.
+  GAction *preview = g_action_map_lookup_action (G_ACTION_MAP (self), "preview");
+  g_simple_action_set_enabled (G_SIMPLE_ACTION (preview), enabled);
 }
 
 static void
 auricle_window_update_render_button_2_state (AuricleWindow *self)
 {
-  gboolean enabled = self->render_options != NULL && auricle_render_options_get_output_directory (self->render_options) != NULL;
+  gboolean enabled = self->render_options != NULL && auricle_render_options_get_output_directory (self->render_options) != NULL &&
+                     !self->calibrating;
   gtk_widget_set_sensitive (GTK_WIDGET (self->render_button_2), enabled);
 }
 
+static void
+auricle_window_update_calibrate_state (AuricleWindow *self)
+{
+  GAction *calibrate = g_action_map_lookup_action (G_ACTION_MAP (self), "calibrate");
+  g_simple_action_set_enabled (G_SIMPLE_ACTION (calibrate), self->renderer == NULL && !self->calibrating);
+}
+
 static void
 on_pixbuf_notify (AuricleImageSection *isec,
                   GParamSpec          *pspec,
@@ -119,6 +142,16 @@ on_files_changed (AuricleMusicTable *mutab,
   auricle_window_update_render_button_1_state (self);
 }
 
+static void
+on_render_mode_notify (AuricleRenderOptions *render_options,
+                       GParamSpec           *pspec,
+                       gpointer              udata)
+{
+  AuricleWindow *self = AURICLE_WINDOW (udata);
+
+  auricle_window_update_render_button_1_state (self);
+}
+
 static void
 on_output_directory_notify (AuricleRenderOptions *render_options,
                             GParamSpec           *pspec,
@@ -142,6 +175,9 @@ auricle_open_add_music_dialog_action (GSimpleAction *action,
   GtkFileFilter *filter = gtk_file_filter_new ();
   gtk_file_filter_set_name (filter, "Audio files");
   gtk_file_filter_add_mime_type (filter, "audio/*");
+  gtk_file_filter_add_pattern (filter, "*.cue");
+  gtk_file_filter_add_pattern (filter, "*.zip");
+  gtk_file_filter_add_pattern (filter, "*.tar");
   gtk_file_chooser_add_filter (GTK_FILE_CHOOSER (chooser), filter);
 
   GtkFileFilter *all_filter = gtk_file_filter_new ();
@@ -175,25 +211,36 @@ on_render_complete (AuricleRenderer *renderer,
   g_idle_add (goto_main_on_idle, udata);
 }
 
+// Takes ownership of the files. A non-zero preview duration renders a quick preview instead.
 static void
-auricle_window_goto (AuricleWindow *self,
-                     const char    *child)
+auricle_window_start_render (AuricleWindow *self,
+                             GList         *files,
+                             GstClockTime   preview_duration)
 {
-  if (strcmp (child, "render") == 0)
-    {
-      g_warn_if_fail (self->renderer == NULL);
-      self->renderer = auricle_renderer_new (auricle_image_section_get_pixbuf (self->image_section),
-                                             self->render_options);
+  g_return_if_fail (self->renderer == NULL);
 
-      g_signal_connect (self->renderer, "complete", G_CALLBACK (on_render_complete), self);
+  self->renderer = auricle_renderer_new (auricle_image_section_get_pixbuf (self->image_section),
+                                         self->render_options);
+  auricle_renderer_set_preview (self->renderer, preview_duration);
 
-      g_autoptr(GList) files = auricle_music_table_get_files (self->music_table);
-      for (GList *l = files; l != NULL; l = l->next)
-        auricle_renderer_take_file (self->renderer, g_steal_pointer (&l->data));
+  g_signal_connect (self->renderer, "complete", G_CALLBACK (on_render_complete), self);
 
-      auricle_progress_view_reset_renderer (self->progress_view, self->renderer);
-      auricle_renderer_run (self->renderer);
-    }
+  for (GList *l = files; l != NULL; l = l->next)
+    auricle_renderer_take_file (self->renderer, g_steal_pointer (&l->data));
+  g_list_free (files);
+
+  auricle_progress_view_reset_renderer (self->progress_view, self->renderer);
+  auricle_window_update_calibrate_state (self);
+  auricle_renderer_run (self->renderer);
+}
+
+static void
+auricle_window_goto (AuricleWindow *self,
+                     const char    *child)
+{
+  // A preview has already started its renderer before switching over.
+  if (strcmp (child, "render") == 0 && self->renderer == NULL)
+    auricle_window_start_render (self, auricle_music_table_get_files (self->music_table), 0);
 
   gtk_stack_set_visible_child_name (self->header_stack, child);
   gtk_stack_set_visible_child_name (self->content_stack, child);
@@ -202,6 +249,7 @@ auricle_window_goto (AuricleWindow *self,
     {
       g_clear_object (&self->renderer);
       auricle_progress_view_reset_renderer (self->progress_view, NULL);
+      auricle_window_update_calibrate_state (self);
     }
 }
 
@@ -218,6 +266,21 @@ auricle_goto_action (GSimpleAction *action,
   auricle_window_goto (self, child);
 }
 
+static void
+auricle_preview_action (GSimpleAction *action,
+                        GVariant      *param,
+                        gpointer       udata)
+{
+  AuricleWindow *self = AURICLE_WINDOW (udata);
+
+  AuricleMusicFile *file = auricle_music_table_get_preview_file (self->music_table);
+  if (file == NULL)
+    return;
+
+  auricle_window_start_render (self, g_list_prepend (NULL, file), PREVIEW_DURATION);
+  auricle_window_goto (self, "render");
+}
+
 static void
 auricle_open_menu_action (GSimpleAction *action,
                           GVariant      *param,
@@ -248,11 +311,76 @@ auricle_about_action (GSimpleAction *action,
                          NULL);
 }
 
+static void
+on_calibration_done (GObject      *source,
+                     GAsyncResult *result,
+                     gpointer      udata)
+{
+  g_autoptr(AuricleWindow) self = AURICLE_WINDOW (udata);
+  g_autoptr(GError) error = NULL;
+
+  self->calibrating = FALSE;
+  auricle_window_update_render_button_1_state (self);
+  auricle_window_update_render_button_2_state (self);
+  auricle_window_update_calibrate_state (self);
+
+  g_autofree char *video_encoder = g_steal_pointer (&self->calibration_video_encoder);
+  g_autofree char *video_preset = g_steal_pointer (&self->calibration_video_preset);
+
+  if (!auricle_calibration_run_finish (result, &error))
+    {
+      auricle_show_notification ("Encoder calibration failed: %s", error->message);
+      return;
+    }
+
+  if (g_strcmp0 (auricle_render_options_get_video_encoder (self->render_options), video_encoder) != 0 ||
+      g_strcmp0 (auricle_render_options_get_video_preset (self->render_options), video_preset) != 0)
+    {
+      auricle_show_notification ("Encoder calibration finished, keeping the chosen video encoder");
+      return;
+    }
+
+  auricle_calibration_apply (self->render_options);
+
+  const char *picked_preset = auricle_render_options_get_video_preset (self->render_options);
+  auricle_show_notification ("Encoder calibration picked %s (%s preset)",
+                             auricle_render_options_get_video_encoder (self->render_options),
+                             picked_preset != NULL ? picked_preset : "default");
+}
+
+static void
+auricle_window_calibrate (AuricleWindow *self)
+{
+  self->calibrating = TRUE;
+  self->calibration_video_encoder = g_strdup (auricle_render_options_get_video_encoder (self->render_options));
+  self->calibration_video_preset = g_strdup (auricle_render_options_get_video_preset (self->render_options));
+  auricle_window_update_render_button_1_state (self);
+  auricle_window_update_render_button_2_state (self);
+  auricle_window_update_calibrate_state (self);
+
+  // Without a chosen image, the calibration falls back to its own test image.
+  auricle_calibration_run_async (auricle_image_section_get_pixbuf (self->image_section), self->render_options,
+                                 NULL, on_calibration_done, g_object_ref (self));
+}
+
+static void
+auricle_calibrate_action (GSimpleAction *action,
+                          GVariant      *param,
+                          gpointer       udata)
+{
+  AuricleWindow *self = AURICLE_WINDOW (udata);
+
+  auricle_show_notification ("Calibrating encoders…");
+  auricle_window_calibrate (self);
+}
+
 static GActionEntry action_entries[] = {
     { "open-add-music-dialog", auricle_open_add_music_dialog_action, NULL, NULL, NULL },
     { "goto", auricle_goto_action, "s", NULL, NULL },
+    { "preview", auricle_preview_action, NULL, NULL, NULL },
     { "open-menu", auricle_open_menu_action, NULL, NULL, NULL },
     { "about", auricle_about_action, NULL, NULL, NULL },
+    { "calibrate", auricle_calibrate_action, NULL, NULL, NULL },
 };
 
 static void
@@ -274,6 +402,9 @@ auricle_window_init (AuricleWindow *self)
   self->render_options = auricle_render_options_new ();
   self->options_editor = auricle_options_editor_new (self->render_options);
   g_signal_connect (self->render_options, "notify::output-directory", G_CALLBACK (on_output_directory_notify), self);
+  g_signal_connect (self->render_options, "notify::render-mode", G_CALLBACK (on_render_mode_notify), self);
+  g_object_bind_property (self->render_options, "normalize-loudness", self->music_table, "measure-loudness",
+                          G_BINDING_SYNC_CREATE);
   gtk_stack_add_named (self->content_stack, GTK_WIDGET (self->options_editor), "options");
 
   self->progress_view = auricle_progress_view_new ();
@@ -284,4 +415,7 @@ auricle_window_init (AuricleWindow *self)
 
   g_signal_connect (self->image_section, "notify::image-path", G_CALLBACK (on_pixbuf_notify), self);
   g_signal_connect (self->music_table, "files-changed", G_CALLBACK (on_files_changed), self);
+
+  // Calibration only runs when asked for from the menu, but its earlier results are picked up here.
+  auricle_calibration_apply (self->render_options);
 }
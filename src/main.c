@@ -19,6 +19,7 @@
 #include <glib/gi18n.h>
 #include <gst/gst.h>
 
+#include "auricle-codecs.h"
 #include "auricle-config.h"
 #include "auricle-window.h"
 
@@ -57,6 +58,7 @@ main (int   argc,
     }
 
   gst_init (&argc, &argv);
+  auricle_codecs_probe ();
 
 	bindtextdomain (GETTEXT_PACKAGE, LOCALEDIR);
 	bind_textdomain_codeset (GETTEXT_PACKAGE, "UTF-8");